@@ -0,0 +1,335 @@
+#pragma once
+#include "scan.h"
+
+#include <cmath>
+#include <limits>
+
+namespace rdf
+{
+
+namespace kernels {
+
+  // Field types aggregate() accepts, integers, floating point and timestamps.
+  template <types::type T>
+  inline constexpr bool k_aggregatable = (T >= types::Int8 && T <= types::Float128) || T == types::Timestamp;
+
+  // 128-bit two's complement sum, exact for any realistic number of 64-bit integers.
+  struct wide_sum
+  {
+    uint64_t lo_ = 0;
+    int64_t hi_ = 0;
+
+    void add(uint64_t lo, int64_t hi) {
+      auto const sum = lo_ + lo;
+      hi_ += hi + (sum < lo_);
+      lo_ = sum;
+    }
+    void add(int64_t v)              { add((uint64_t)v, v < 0 ? -1 : 0); }
+    void add(uint64_t v)             { add(v, 0); }
+    void add_shifted32(int64_t v)    { add((uint64_t)v << 32, v >> 32); }     // v * 2^32.
+    void add(wide_sum const& other)  { add(other.lo_, other.hi_); }
+
+    bool fits_int64() const  { return hi_ == ((int64_t)lo_ >> 63); }
+    bool fits_uint64() const { return hi_ == 0; }
+    long double value() const { return std::ldexp((long double)hi_, 64) + (long double)lo_; }
+  };
+
+  // Neumaier's compensated sum, the rounding error of each addition is carried in c_. Values are added to 8
+  // independent lanes so a block of additions vectorizes, and the lanes are only folded together by value().
+  template <class A>
+  struct compensated_sum
+  {
+    using value_type = A;
+    static constexpr size_t k_lanes = 8;
+
+    std::array<A, k_lanes> sum_{};
+    std::array<A, k_lanes> c_{};
+
+    static void add(A& sum, A& c, A x) {
+      auto const abs = [](A y) { return y < 0 ? -y : y; };
+      auto const t = sum + x;
+      c += abs(sum) >= abs(x) ? (sum - t) + x : (x - t) + sum;
+      sum = t;
+    }
+
+    // Add x[i] to lane i.
+    void add_lanes(A const* x) {
+      for (size_t i = 0; i < k_lanes; ++i) {
+        add(sum_[i], c_[i], x[i]);
+      }
+    }
+
+    void add(compensated_sum const& other) {
+      add_lanes(other.sum_.data());
+      for (size_t i = 0; i < k_lanes; ++i) {
+        c_[i] += other.c_[i];
+      }
+    }
+
+    A value() const {
+      A sum = 0;
+      A c = 0;
+      for (size_t i = 0; i < k_lanes; ++i) {
+        add(sum, c, sum_[i]);
+      }
+      for (size_t i = 0; i < k_lanes; ++i) {
+        c += c_[i];
+      }
+      return sum + c;
+    }
+  };
+
+} // namespace kernels
+
+// Count, min, max, sum and mean of a field, see aggregate().
+// Floating point values are summed with compensation, in double for Float16 / Float32 / Float64 and in Float128 for
+// Float128 so its extra precision is kept. NaNs propagate into the sum and mean but are skipped by min and max.
+// Integers and timestamps are summed exactly in 128 bits.
+// Accumulators merge, so partial results from separate ranges or threads can be combined with merge().
+template <types::type T> requires (kernels::k_aggregatable<T>)
+class aggregates
+{
+public:
+  using value_type = types::value_t<T>;
+  using scan_type  = kernels::scan_value_t<T>;
+
+  static constexpr bool k_floating = T >= types::Float16 && T <= types::Float128;
+  static constexpr bool k_signed   = T == types::Timestamp || std::is_signed_v<scan_type>;
+
+  using sum_type  = std::conditional_t<T == types::Float128, std::float128_t,
+                    std::conditional_t<k_floating, double,
+                    std::conditional_t<k_signed, int64_t, uint64_t>>>;
+  using mean_type = std::conditional_t<T == types::Timestamp, timestamp_t,
+                    std::conditional_t<T == types::Float128, std::float128_t, double>>;
+
+  size_t count() const { return count_; }
+  bool empty() const { return count_ == 0; }
+
+  // Undefined when empty().
+  value_type min() const { BOOST_ASSERT(count_ > 0); return value(min_); }
+  value_type max() const { BOOST_ASSERT(count_ > 0); return value(max_); }
+
+  // Throws if an integer sum does not fit in sum_type. Timestamps have no sum, only a mean.
+  sum_type sum() const requires (T != types::Timestamp);
+
+  // NaN when empty(), the epoch for an empty Timestamp field.
+  mean_type mean() const;
+
+  // Accumulate v[i] for each bit i set in mask, from a 64-byte aligned block of 64 values.
+  inline void add_block(scan_type const* v, uint64_t mask);
+
+  // Accumulate a single value.
+  inline void add(value_type v);
+
+  inline void merge(aggregates const& other);
+
+private:
+  using accumulator_type = std::conditional_t<T == types::Float128, kernels::compensated_sum<std::float128_t>,
+                           std::conditional_t<k_floating, kernels::compensated_sum<double>, kernels::wide_sum>>;
+
+  static scan_type scan_value(value_type v) { return kernels::scan_value<T>(v); }
+  static value_type value(scan_type v) {
+    if constexpr (T == types::Timestamp) {
+      return util::make_timestamp(v);
+    }
+    else {
+      return (value_type)v;
+    }
+  }
+
+  template <bool Masked>
+  inline void add_block(scan_type const* v, uint64_t mask);
+
+  static constexpr scan_type k_min_identity = std::numeric_limits<scan_type>::has_infinity ?
+                                              std::numeric_limits<scan_type>::infinity() : std::numeric_limits<scan_type>::max();
+  static constexpr scan_type k_max_identity = std::numeric_limits<scan_type>::has_infinity ?
+                                              -std::numeric_limits<scan_type>::infinity() : std::numeric_limits<scan_type>::lowest();
+
+  size_t count_ = 0;
+  scan_type min_ = k_min_identity;
+  scan_type max_ = k_max_identity;
+  accumulator_type sum_;
+};
+
+template <types::type T> requires (kernels::k_aggregatable<T>)
+auto aggregates<T>::sum() const -> sum_type requires (T != types::Timestamp)
+{
+  if constexpr (k_floating) {
+    return (sum_type)sum_.value();
+  }
+  else {
+    if (k_signed ? !sum_.fits_int64() : !sum_.fits_uint64()) {
+      throw std::runtime_error(fmt::format("sum of {} values of type '{}' overflows", count_, types::enum_names_type(T)));
+    }
+    return (sum_type)sum_.lo_;
+  }
+}
+
+template <types::type T> requires (kernels::k_aggregatable<T>)
+auto aggregates<T>::mean() const -> mean_type
+{
+  if constexpr (T == types::Timestamp) {
+    return util::make_timestamp(count_ ? (raw_time_t)std::llround(sum_.value() / count_) : 0);
+  }
+  else if constexpr (k_floating) {
+    return count_ ? (mean_type)(sum_.value() / (mean_type)count_) : std::numeric_limits<mean_type>::quiet_NaN();
+  }
+  else {
+    return count_ ? (mean_type)(sum_.value() / count_) : std::numeric_limits<mean_type>::quiet_NaN();
+  }
+}
+
+template <types::type T> requires (kernels::k_aggregatable<T>)
+void aggregates<T>::add(value_type v)
+{
+  auto const x = scan_value(v);
+  ++count_;
+  min_ = x < min_ ? x : min_;
+  max_ = x > max_ ? x : max_;
+  if constexpr (k_floating) {
+    accumulator_type::add(sum_.sum_[0], sum_.c_[0], (typename accumulator_type::value_type)x);
+  }
+  else if constexpr (k_signed) {
+    sum_.add((int64_t)x);
+  }
+  else {
+    sum_.add((uint64_t)x);
+  }
+}
+
+template <types::type T> requires (kernels::k_aggregatable<T>)
+void aggregates<T>::add_block(scan_type const* v, uint64_t mask)
+{
+  if (mask == ~uint64_t{0}) {
+    add_block<false>(v, mask);
+  }
+  else if (mask) {
+    add_block<true>(v, mask);
+  }
+}
+
+template <types::type T> requires (kernels::k_aggregatable<T>)
+template <bool Masked>
+void aggregates<T>::add_block(scan_type const* v, uint64_t mask)
+{
+  // Selects rather than branches, and min / max kept per lane rather than as a single running value, so the compiler
+  // can vectorize the block. Unselected values become the identity of each aggregate.
+  constexpr size_t lanes = 8;
+  std::array<scan_type, lanes> lo, hi;
+  lo.fill(min_);
+  hi.fill(max_);
+  auto const selected = [&](size_t i) { return !Masked || ((mask >> i) & 1); };
+  auto const min_max = [&](size_t i, size_t j) {
+    lo[j] = selected(i + j) && v[i + j] < lo[j] ? v[i + j] : lo[j];
+    hi[j] = selected(i + j) && v[i + j] > hi[j] ? v[i + j] : hi[j];
+  };
+
+  if constexpr (k_floating)
+  {
+    using A = typename accumulator_type::value_type;
+    static_assert(accumulator_type::k_lanes == lanes);
+    for (size_t i = 0; i < 64; i += lanes)
+    {
+      std::array<A, lanes> x;
+      for (size_t j = 0; j < lanes; ++j) {
+        x[j] = selected(i + j) ? (A)v[i + j] : A{0};
+        min_max(i, j);
+      }
+      sum_.add_lanes(x.data());
+    }
+  }
+  else if constexpr (sizeof(scan_type) == 8)
+  {
+    // Split into 32-bit halves so neither block sum can overflow.
+    int64_t high = 0;
+    uint64_t low = 0;
+    for (size_t i = 0; i < 64; i += lanes) {
+      for (size_t j = 0; j < lanes; ++j) {
+        auto const x = selected(i + j) ? v[i + j] : scan_type{0};
+        high += k_signed ? (int64_t)x >> 32 : (int64_t)((uint64_t)x >> 32);
+        low += (uint32_t)x;
+        min_max(i, j);
+      }
+    }
+    sum_.add_shifted32(high);
+    sum_.add(low);
+  }
+  else
+  {
+    int64_t s = 0;
+    for (size_t i = 0; i < 64; i += lanes) {
+      for (size_t j = 0; j < lanes; ++j) {
+        s += selected(i + j) ? (int64_t)v[i + j] : 0;
+        min_max(i, j);
+      }
+    }
+    sum_.add(s);
+  }
+
+  for (size_t j = 0; j < lanes; ++j) {
+    min_ = lo[j] < min_ ? lo[j] : min_;
+    max_ = hi[j] > max_ ? hi[j] : max_;
+  }
+  count_ += std::popcount(mask);
+}
+
+template <types::type T> requires (kernels::k_aggregatable<T>)
+void aggregates<T>::merge(aggregates const& other)
+{
+  count_ += other.count_;
+  min_ = other.min_ < min_ ? other.min_ : min_;
+  max_ = other.max_ > max_ ? other.max_ : max_;
+  sum_.add(other.sum_);
+}
+
+namespace kernels {
+
+  template <types::type T>
+  inline aggregates<T> aggregate(record_span<record> const& records, field const& f, selection const* where)
+  {
+    using V = scan_value_t<T>;
+
+    // 64 words (4096 records) per TBB task.
+    constexpr size_t k_grain_words = 64;
+
+    check_type<T>(f, "aggregate");
+    BOOST_ASSERT(!where || where->size() == records.size());
+
+    auto const stride = records.stride();
+    auto const base = records.data() + f.offset();
+
+    return tbb::parallel_reduce(tbb::blocked_range<size_t>(0, (records.size() + 63) / 64, k_grain_words), aggregates<T>{},
+      [&](tbb::blocked_range<size_t> const& range, aggregates<T> partial)
+      {
+        alignas(64) std::array<V, 64> block;
+        for (auto w = range.begin(); w < range.end(); ++w)
+        {
+          auto const n = std::min<size_t>(64, records.size() - w * 64);
+          auto const mask = (where ? where->words()[w] : ~uint64_t{0}) & (n == 64 ? ~uint64_t{0} : (uint64_t{1} << n) - 1);
+          if (mask) {
+            gather(block.data(), base + w * 64 * stride, stride, n);
+            partial.add_block(block.data(), mask);
+          }
+        }
+        return partial;
+      },
+      [](aggregates<T> a, aggregates<T> const& b) { a.merge(b); return a; });
+  }
+
+} // namespace kernels
+
+// Count, min, max, sum and mean of a field over records, in parallel.
+template <types::type T> requires (kernels::k_aggregatable<T>)
+inline aggregates<T> aggregate(record_span<record> records, field const& f)
+{
+  return kernels::aggregate<T>(records, f, nullptr);
+}
+
+// As above over the records selected by where, e.g. the result of select<T>() over the same records.
+template <types::type T> requires (kernels::k_aggregatable<T>)
+inline aggregates<T> aggregate(record_span<record> records, field const& f, selection const& where)
+{
+  return kernels::aggregate<T>(records, f, &where);
+}
+
+} // namespace rdf
@@ -0,0 +1,399 @@
+#pragma once
+#include "column_table.h"
+#include "key_dictionary.h"
+#include "record_span.h"
+#include "string_arena.h"
+
+#include <oneapi/tbb/parallel_for.h>
+
+#include <climits>
+#include <memory>
+
+// Arrow C Data Interface, https://arrow.apache.org/docs/format/CDataInterface.html
+// The structs are a stable ABI meant to be copied into producers, under the same guard as Arrow's own abi.h so either
+// may be included first. No Arrow library is needed to export, only to consume.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+extern "C" {
+
+struct ArrowSchema
+{
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+  void (*release)(struct ArrowSchema*);
+  void* private_data;
+};
+
+struct ArrowArray
+{
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+  void (*release)(struct ArrowArray*);
+  void* private_data;
+};
+
+} // extern "C"
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace rdf
+{
+
+struct arrow_export_options
+{
+  key_dictionary const* dictionary = nullptr;       // KeyDict fields become dictionary arrays, otherwise uint32 codes.
+  string_arena const* arena = nullptr;              // Resolves StringRef fields, otherwise only inline strings can be.
+};
+
+// Export of records to Arrow as a struct array with a non-nullable child per field, i.e. a record batch, e.g.
+//   ArrowSchema schema;
+//   ArrowArray array;
+//   export_arrow_schema(desc, &schema);
+//   export_arrow(table, &array);
+//   auto batch = arrow::ImportRecordBatch(&array, &schema);     // Or pyarrow.RecordBatch._import_from_c().
+// The consumer owns the structs and calls their release callbacks, which also release the children.
+//
+// Field types map to Arrow as:
+//   Int*, Uint*, Float16/32/64             the same width integer / float ("c" .. "L", "e", "f", "g")
+//   Utf_Char8/16/32                        uint8 / 16 / 32 code units
+//   Char                                   fixed size binary of 1 byte ("w:1")
+//   Timestamp                              timestamp[ns, UTC] ("tsn:UTC")
+//   KeyDict                                dictionary of utf8 with uint32 indices, or uint32 without a dictionary
+//   Key8/16, String8/16, StringRef         utf8 ("u")
+//   Float128                               float64, as Arrow has no wider float
+//   Bool                                   boolean, bit packed
+// Fixed width columns of a column_table are exported without a copy, the others are converted into buffers owned by
+// the array.
+inline void export_arrow_schema(descriptor const& desc, ArrowSchema* out,
+                                arrow_export_options const& opts = arrow_export_options{});
+
+// Rows [first, first + count) of a table. The zero copy columns view the table, which must outlive the array and
+// not be written while it is in use.
+inline void export_arrow(column_table const& table, size_t first, size_t count, ArrowArray* out,
+                         arrow_export_options const& opts = arrow_export_options{});
+inline void export_arrow(column_table const& table, ArrowArray* out,
+                         arrow_export_options const& opts = arrow_export_options{})
+{
+  export_arrow(table, 0, table.size(), out, opts);
+}
+
+// Records of desc, transposed (as column_table::from_rows()) into columns owned by the array, so records may be
+// released or reused once this returns.
+inline void export_arrow(descriptor const& desc, record_span<record> records, ArrowArray* out,
+                         arrow_export_options const& opts = arrow_export_options{});
+
+namespace detail {
+
+  // Owned buffers are cache line aligned, as column_table columns are and as Arrow recommends.
+  struct arrow_free_deleter { void operator()(mem_t* p) const { std::free(p); } };
+  using arrow_buffer = std::unique_ptr<mem_t, arrow_free_deleter>;
+
+  // The private_data of each exported struct. Children and dictionaries are released by their parent unless the
+  // consumer moved them out, and each keeps its own reference to the memory it views so it may outlive its parent.
+  struct arrow_schema_data
+  {
+    std::string name_;
+    std::vector<ArrowSchema> children_;
+    std::vector<ArrowSchema*> child_ptrs_;
+    std::unique_ptr<ArrowSchema> dictionary_;
+  };
+
+  struct arrow_array_data
+  {
+    std::shared_ptr<void const> owner_;
+    std::vector<arrow_buffer> owned_;
+    std::vector<void const*> buffers_;
+    std::vector<ArrowArray> children_;
+    std::vector<ArrowArray*> child_ptrs_;
+    std::unique_ptr<ArrowArray> dictionary_;
+  };
+
+  inline void release_arrow_schema(ArrowSchema* schema)
+  {
+    auto const data = static_cast<arrow_schema_data*>(schema->private_data);
+    for (auto& child : data->children_) {
+      if (child.release) {
+        child.release(&child);
+      }
+    }
+    if (data->dictionary_ && data->dictionary_->release) {
+      data->dictionary_->release(data->dictionary_.get());
+    }
+    delete data;
+    schema->release = nullptr;
+  }
+
+  inline void release_arrow_array(ArrowArray* array)
+  {
+    auto const data = static_cast<arrow_array_data*>(array->private_data);
+    for (auto& child : data->children_) {
+      if (child.release) {
+        child.release(&child);
+      }
+    }
+    if (data->dictionary_ && data->dictionary_->release) {
+      data->dictionary_->release(data->dictionary_.get());
+    }
+    delete data;
+    array->release = nullptr;
+  }
+
+  inline arrow_schema_data* make_arrow_schema(ArrowSchema* out, char const* format, string_t name, size_t children)
+  {
+    auto const data = new arrow_schema_data{std::string{name}, std::vector<ArrowSchema>(children), {}, {}};
+    for (auto& child : data->children_) {
+      data->child_ptrs_.push_back(&child);
+    }
+    *out = ArrowSchema{format, data->name_.c_str(), nullptr, 0, (int64_t)children,
+                       children ? data->child_ptrs_.data() : nullptr, nullptr, &release_arrow_schema, data};
+    return data;
+  }
+
+  inline arrow_array_data* make_arrow_array(ArrowArray* out, size_t length, size_t buffers, size_t children,
+                                            std::shared_ptr<void const> owner = nullptr)
+  {
+    auto const data = new arrow_array_data{std::move(owner), {}, std::vector<void const*>(buffers),
+                                           std::vector<ArrowArray>(children), {}, {}};
+    for (auto& child : data->children_) {
+      data->child_ptrs_.push_back(&child);
+    }
+    *out = ArrowArray{(int64_t)length, 0, 0, (int64_t)buffers, (int64_t)children, data->buffers_.data(),
+                      children ? data->child_ptrs_.data() : nullptr, nullptr, &release_arrow_array, data};
+    return data;
+  }
+
+  inline mem_t* own_arrow_buffer(arrow_array_data* data, size_t bytes)
+  {
+    auto const size = bal::align_up(std::max<size_t>(bytes, 1), column_table::k_column_align);
+    data->owned_.emplace_back((mem_t*)std::aligned_alloc(column_table::k_column_align, size));
+    if (!data->owned_.back()) {
+      throw std::bad_alloc{};
+    }
+    return data->owned_.back().get();
+  }
+
+  // A utf8 array of the count strings view(i) returns.
+  template <typename View>
+  void make_arrow_strings(ArrowArray* out, size_t count, View const& view)
+  {
+    auto const data = make_arrow_array(out, count, 3, 0);
+    auto const offsets = reinterpret_cast<int32_t*>(own_arrow_buffer(data, (count + 1) * sizeof(int32_t)));
+
+    size_t total = 0;
+    offsets[0] = 0;
+    for (size_t i = 0; i < count; ++i) {
+      total += view(i).size();
+      if (total > INT32_MAX) {
+        throw std::runtime_error(fmt::format("strings of {} rows exceed the 2GB of an Arrow utf8 array", count));
+      }
+      offsets[i + 1] = (int32_t)total;
+    }
+
+    auto const chars = own_arrow_buffer(data, total);
+    for (size_t i = 0; i < count; ++i) {
+      auto const s = view(i);
+      std::memcpy(chars + offsets[i], s.data(), s.size());
+    }
+    data->buffers_[1] = offsets;
+    data->buffers_[2] = chars;
+  }
+
+  inline char const* arrow_format(types::type t)
+  {
+    using namespace types;
+    switch (t)
+    {
+      case Key8:
+      case Key16:
+      case String8:
+      case String16:
+      case StringRef:  return "u";
+      case Timestamp:  return "tsn:UTC";
+      case Char:       return "w:1";
+      case Utf_Char8:  return "C";
+      case Utf_Char16: return "S";
+      case Utf_Char32: return "I";
+      case Int8:       return "c";
+      case Int16:      return "s";
+      case Int32:      return "i";
+      case Int64:      return "l";
+      case Uint8:      return "C";
+      case Uint16:     return "S";
+      case Uint32:     return "I";
+      case Uint64:     return "L";
+      case Float16:    return "e";
+      case Float32:    return "f";
+      case Float64:    return "g";
+      case Float128:   return "g";
+      case Bool:       return "b";
+      case KeyDict:    return "I";
+      case type_numof: break;
+    }
+    BOOST_ASSERT_MSG(false, "invalid field type");
+    return nullptr;
+  }
+
+  template <types::type T>
+  void export_arrow_column(column_table const& table, field const& f, size_t first, size_t count,
+                           std::shared_ptr<void const> const& owner, arrow_export_options const& opts, ArrowArray* out)
+  {
+    using namespace types;
+    if constexpr (string_type(T)) {
+      make_arrow_strings(out, count, [&](size_t i) { return table.get<T>(f, first + i); });
+    }
+    else if constexpr (T == StringRef) {
+      auto const refs = table.column<T>(f).subspan(first, count);
+      make_arrow_strings(out, count, [&](size_t i) -> string_t {
+        if (opts.arena) {
+          return opts.arena->view(refs[i]);
+        }
+        if (!refs[i].inlined()) {
+          throw std::runtime_error(fmt::format("field '{}': string of length {} needs a string_arena", f.name(), refs[i].length_));
+        }
+        return {refs[i].data_, refs[i].length_};
+      });
+    }
+    else if constexpr (T == Bool) {
+      auto const values = table.column<T>(f).subspan(first, count);
+      auto const data = make_arrow_array(out, count, 2, 0);
+      auto const bits = own_arrow_buffer(data, (count + 7) / 8);
+      for (size_t i = 0; i < count; i += 8) {
+        uint8_t byte = 0;
+        for (size_t b = 0; b < 8 && i + b < count; ++b) {
+          byte |= uint8_t(values[i + b] ? 1 : 0) << b;
+        }
+        bits[i / 8] = (mem_t)byte;
+      }
+      data->buffers_[1] = bits;
+    }
+    else if constexpr (T == Float128) {
+      auto const values = table.column<T>(f).subspan(first, count);
+      auto const data = make_arrow_array(out, count, 2, 0);
+      auto const doubles = reinterpret_cast<double*>(own_arrow_buffer(data, count * sizeof(double)));
+      std::ranges::transform(values, doubles, [](auto v) { return (double)v; });
+      data->buffers_[1] = doubles;
+    }
+    else {
+      // Zero copy, the table layout is the Arrow layout.
+      auto const data = make_arrow_array(out, count, 2, 0, owner);
+      data->buffers_[1] = table.data(f) + first * table.width(f);
+
+      if (T == KeyDict && opts.dictionary) {
+        auto const& dictionary = *opts.dictionary;
+        data->dictionary_ = std::make_unique<ArrowArray>();
+        make_arrow_strings(data->dictionary_.get(), dictionary.size(),
+                           [&](size_t code) { return dictionary.decode((key_code_t)code); });
+        out->dictionary = data->dictionary_.get();
+      }
+    }
+  }
+
+  inline void export_arrow_table(column_table const& table, size_t first, size_t count,
+                                 std::shared_ptr<void const> const& owner, arrow_export_options const& opts,
+                                 ArrowArray* out)
+  {
+    BOOST_ASSERT(first + count <= table.size());
+
+    #define EXPORT_FIELD(F) \
+      case F: \
+        export_arrow_column<F>(table, f, first, count, owner, opts, &data->children_[f.index()]); \
+        break;
+
+    auto const& fields = table.desc().fields();
+    auto const data = make_arrow_array(out, count, 1, fields.size());
+    try {
+      // Columns are independent, the conversions of strings, bools and Float128 run on TBB workers.
+      tbb::parallel_for(size_t{0}, fields.size(), [&](size_t i) {
+        using namespace types;
+        auto const& f = fields[i];
+        switch (f.type())
+        {
+          EXPORT_FIELD(Key8);
+          EXPORT_FIELD(Key16);
+          EXPORT_FIELD(String8);
+          EXPORT_FIELD(String16);
+          EXPORT_FIELD(Timestamp);
+          EXPORT_FIELD(Char);
+          EXPORT_FIELD(Utf_Char8);
+          EXPORT_FIELD(Utf_Char16);
+          EXPORT_FIELD(Utf_Char32);
+          EXPORT_FIELD(Int8);
+          EXPORT_FIELD(Int16);
+          EXPORT_FIELD(Int32);
+          EXPORT_FIELD(Int64);
+          EXPORT_FIELD(Uint8);
+          EXPORT_FIELD(Uint16);
+          EXPORT_FIELD(Uint32);
+          EXPORT_FIELD(Uint64);
+          EXPORT_FIELD(Float16);
+          EXPORT_FIELD(Float32);
+          EXPORT_FIELD(Float64);
+          EXPORT_FIELD(Float128);
+          EXPORT_FIELD(Bool);
+          EXPORT_FIELD(KeyDict);
+          EXPORT_FIELD(StringRef);
+          case type_numof:
+            BOOST_ASSERT_MSG(false, "invalid field type");
+            break;
+        }
+      });
+    }
+    catch (...) {
+      out->release(out);     // Releases the children exported so far.
+      throw;
+    }
+
+    #undef EXPORT_FIELD
+  }
+
+} // namespace detail
+
+void export_arrow_schema(descriptor const& desc, ArrowSchema* out, arrow_export_options const& opts)
+{
+  auto const& fields = desc.fields();
+  auto const data = detail::make_arrow_schema(out, "+s", desc.name(), fields.size());
+  for (auto const& f : fields) {
+    auto& child = data->children_[f.index()];
+    auto const child_data = detail::make_arrow_schema(&child, detail::arrow_format(f.type()), f.name(), 0);
+    if (f.type() == types::KeyDict && opts.dictionary) {
+      child_data->dictionary_ = std::make_unique<ArrowSchema>();
+      detail::make_arrow_schema(child_data->dictionary_.get(), "u", "", 0);
+      child.dictionary = child_data->dictionary_.get();
+    }
+  }
+}
+
+void export_arrow(column_table const& table, size_t first, size_t count, ArrowArray* out,
+                  arrow_export_options const& opts)
+{
+  if (first + count > table.size()) {
+    throw std::runtime_error(fmt::format("rows [{}, {}) are outside a table of {} rows", first, first + count, table.size()));
+  }
+  detail::export_arrow_table(table, first, count, nullptr, opts, out);
+}
+
+void export_arrow(descriptor const& desc, record_span<record> records, ArrowArray* out, arrow_export_options const& opts)
+{
+  BOOST_ASSERT(records.empty() || records.stride() == desc.mem_size());
+  auto const table = std::make_shared<column_table>(desc, records.size());
+  table->from_rows(records.data(), records.size());
+  detail::export_arrow_table(*table, 0, table->size(), table, opts, out);
+}
+
+} // namespace rdf
@@ -0,0 +1,398 @@
+#pragma once
+#include "table_file.h"
+
+// POSIX only.
+#include <fcntl.h>
+#include <unistd.h>
+#if TRDF_HAS_IO_URING
+  #include <linux/io_uring.h>
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+#endif
+
+#include <cstring>
+#include <functional>
+#include <future>
+#include <numeric>
+
+namespace rdf
+{
+
+#if TRDF_HAS_IO_URING
+// Minimal io_uring submission and completion queues over the raw system calls, enough to queue reads.
+// Used by a single thread.
+class uring
+{
+public:
+  inline explicit uring(unsigned entries);
+  inline ~uring();
+
+  uring(uring const&) = delete;
+  uring& operator=(uring const&) = delete;
+
+  // Queue and submit a read of len bytes at offset into buf.
+  inline void read(int fd, void* buf, unsigned len, uint64_t offset, uint64_t user_data);
+
+  // Block until a read completes. Returns its user_data and result (bytes read or -errno).
+  inline std::pair<uint64_t, int> wait();
+
+private:
+  inline void release();
+
+  static unsigned* at(void* ring, uint32_t offset) { return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset); }
+
+  int fd_ = -1;
+  void* sq_ring_ = MAP_FAILED;
+  void* cq_ring_ = MAP_FAILED;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe* sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+  size_t sqes_size_ = 0;
+  io_uring_params params_{};
+};
+
+uring::uring(unsigned entries)
+{
+  fd_ = (int)::syscall(__NR_io_uring_setup, entries, &params_);
+  if (fd_ < 0) {
+    throw std::runtime_error(fmt::format("io_uring_setup failed: {}", std::strerror(errno)));
+  }
+
+  sq_ring_size_ = params_.sq_off.array + params_.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+  auto const single = (params_.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+
+  sq_ring_ = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+  cq_ring_ = single ? sq_ring_ : ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+  sqes_size_ = params_.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = static_cast<io_uring_sqe*>(::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES));
+
+  if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+    auto const error = errno;
+    release();
+    throw std::runtime_error(fmt::format("io_uring mmap failed: {}", std::strerror(error)));
+  }
+}
+
+uring::~uring()
+{
+  release();
+}
+
+void uring::release()
+{
+  if (sqes_ != MAP_FAILED) {
+    ::munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+    ::munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != MAP_FAILED) {
+    ::munmap(sq_ring_, sq_ring_size_);
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+  sqes_ = static_cast<io_uring_sqe*>(MAP_FAILED);
+  sq_ring_ = cq_ring_ = MAP_FAILED;
+  fd_ = -1;
+}
+
+void uring::read(int fd, void* buf, unsigned len, uint64_t offset, uint64_t user_data)
+{
+  // The kernel only consumes entries, so the tail is ours and the mask and array need no synchronisation.
+  std::atomic_ref tail{*at(sq_ring_, params_.sq_off.tail)};
+  auto const t = tail.load(std::memory_order_relaxed);
+  auto const index = t & *at(sq_ring_, params_.sq_off.ring_mask);
+
+  auto& sqe = sqes_[index];
+  std::memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode = IORING_OP_READ;
+  sqe.fd = fd;
+  sqe.addr = reinterpret_cast<uint64_t>(buf);
+  sqe.len = len;
+  sqe.off = offset;
+  sqe.user_data = user_data;
+  at(sq_ring_, params_.sq_off.array)[index] = index;
+
+  tail.store(t + 1, std::memory_order_release);
+
+  while (::syscall(__NR_io_uring_enter, fd_, 1, 0, 0, nullptr, 0) < 0) {
+    if (errno != EINTR) {
+      throw std::runtime_error(fmt::format("io_uring_enter failed: {}", std::strerror(errno)));
+    }
+  }
+}
+
+std::pair<uint64_t, int> uring::wait()
+{
+  std::atomic_ref head{*at(cq_ring_, params_.cq_off.head)};
+  std::atomic_ref tail{*at(cq_ring_, params_.cq_off.tail)};
+  auto const h = head.load(std::memory_order_relaxed);
+
+  while (tail.load(std::memory_order_acquire) == h) {
+    if (::syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+      throw std::runtime_error(fmt::format("io_uring_enter failed: {}", std::strerror(errno)));
+    }
+  }
+
+  auto const cqes = reinterpret_cast<io_uring_cqe const*>(static_cast<char*>(cq_ring_) + params_.cq_off.cqes);
+  auto const& cqe = cqes[h & *at(cq_ring_, params_.cq_off.ring_mask)];
+  std::pair result{ cqe.user_data, cqe.res };
+  head.store(h + 1, std::memory_order_release);
+  return result;
+}
+#endif
+
+struct block_reader_options
+{
+  size_t block_bytes = 4 * 1024 * 1024;   // Rounded up to whole records and a multiple of k_direct_align.
+  size_t depth = 3;                       // Blocks in flight.
+  bool direct = false;                    // O_DIRECT.
+  bool use_io_uring = true;
+};
+
+// Streams the records of a table file through a small set of block buffers instead of mapping it, so throughput on
+// files that are not in the page cache does not depend on page fault handling.
+// depth reads are kept in flight (triple buffering by default) and each completed block is handed to the consumer,
+// in order, while the following blocks are being read. Reads are queued on io_uring where available and otherwise
+// issued with pread on worker threads. With direct = true the file is opened with O_DIRECT, bypassing the page cache
+// (the reader falls back to buffered reads if the file system does not support it).
+// Block sizes are a multiple of both the record size and k_direct_align, so a block always holds whole records.
+class block_reader
+{
+public:
+  static constexpr size_t k_direct_align = 4096;
+
+  using options = block_reader_options;
+
+  // Called with count whole records starting at record index first. The memory is reused once the call returns.
+  using consumer = std::function<void(record_span<record> records, size_t first)>;
+
+  inline explicit block_reader(std::filesystem::path const& path, options const& opts = options{});
+  inline ~block_reader();
+
+  block_reader(block_reader const&) = delete;
+  block_reader& operator=(block_reader const&) = delete;
+
+  descriptor const& desc() const { return file_.desc(); }
+  size_t size() const { return count_; }                  // Records committed when the reader was opened.
+  size_t block_records() const { return block_records_; }
+  bool direct() const { return direct_; }
+  inline bool uses_io_uring() const;
+
+  // Read records [first, first + count), calling consume once per block.
+  inline void read(consumer const& consume, size_t first = 0, size_t count = std::dynamic_extent);
+
+private:
+  struct free_deleter { void operator()(mem_t* p) const { std::free(p); } };
+
+  struct buffer
+  {
+    std::unique_ptr<mem_t, free_deleter> mem_;
+    size_t length_ = 0;           // Bytes requested, a multiple of k_direct_align.
+    size_t needed_ = 0;           // Bytes that must be read for the block to be complete.
+    uint64_t offset_ = 0;
+    bool pending_ = false;
+    std::future<void> future_;    // pread fallback.
+  };
+
+  inline void submit(buffer& b, uint64_t offset, size_t needed);
+  inline void wait(buffer& b);
+  inline void drain();
+  inline void read_fully(buffer& b) const;
+
+  table_file file_;               // Header and descriptor only, records are never touched through the mapping.
+  size_t count_;
+  size_t block_records_;
+  bool direct_;
+  int fd_ = -1;
+  std::vector<buffer> buffers_;
+#if TRDF_HAS_IO_URING
+  std::unique_ptr<uring> ring_;
+#endif
+};
+
+block_reader::block_reader(std::filesystem::path const& path, options const& opts)
+  : file_{table_file::open(path)},
+    count_{file_.size()},
+    block_records_{0},
+    direct_{opts.direct}
+{
+  // Smallest block holding whole records that is also a multiple of the direct I/O alignment.
+  auto const mem_size = desc().mem_size();
+  auto const unit = std::lcm(mem_size, k_direct_align);
+  auto const block_bytes = std::max<size_t>(1, (opts.block_bytes + unit - 1) / unit) * unit;
+  block_records_ = block_bytes / mem_size;
+
+  fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | (direct_ ? O_DIRECT : 0));
+  if (fd_ < 0 && direct_ && errno == EINVAL) {
+    direct_ = false;
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  }
+  if (fd_ < 0) {
+    throw std::runtime_error(fmt::format("failed to open table file '{}': {}", path.string(), std::strerror(errno)));
+  }
+  if (!direct_) {
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+
+  // One extra alignment unit for a range that does not start on an aligned offset.
+  buffers_.resize(std::max<size_t>(1, opts.depth));
+  for (auto& b : buffers_) {
+    b.mem_.reset((mem_t*)std::aligned_alloc(k_direct_align, block_bytes + k_direct_align));
+    if (!b.mem_) {
+      ::close(fd_);
+      throw std::bad_alloc{};
+    }
+  }
+
+#if TRDF_HAS_IO_URING
+  if (opts.use_io_uring) {
+    try {
+      ring_ = std::make_unique<uring>((unsigned)buffers_.size());
+    }
+    catch (std::runtime_error const&) {
+      // Not permitted or not supported by this kernel, use pread.
+    }
+  }
+#endif
+}
+
+block_reader::~block_reader()
+{
+  drain();
+  ::close(fd_);
+}
+
+bool block_reader::uses_io_uring() const
+{
+#if TRDF_HAS_IO_URING
+  return ring_ != nullptr;
+#else
+  return false;
+#endif
+}
+
+void block_reader::read_fully(buffer& b) const
+{
+  size_t done = 0;
+  while (done < b.needed_)
+  {
+    auto const n = ::pread(fd_, b.mem_.get() + done, b.length_ - done, b.offset_ + done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      throw std::runtime_error(fmt::format("read of table file '{}' failed: {}", file_.path().string(), std::strerror(errno)));
+    }
+    if (n == 0) {
+      throw std::runtime_error(fmt::format("unexpected end of table file '{}'", file_.path().string()));
+    }
+    done += n;
+  }
+}
+
+void block_reader::submit(buffer& b, uint64_t offset, size_t needed)
+{
+  namespace bal = boost::alignment;
+
+  // Reads start and end on k_direct_align boundaries, the block starts offset % k_direct_align bytes into the buffer.
+  b.offset_ = offset - offset % k_direct_align;
+  b.needed_ = (offset - b.offset_) + needed;
+  b.length_ = bal::align_up(b.needed_, k_direct_align);
+  b.pending_ = true;
+
+#if TRDF_HAS_IO_URING
+  if (ring_) {
+    ring_->read(fd_, b.mem_.get(), (unsigned)b.length_, b.offset_, (uint64_t)(&b - buffers_.data()));
+    return;
+  }
+#endif
+  b.future_ = std::async(std::launch::async, [this, &b] { read_fully(b); });
+}
+
+void block_reader::wait(buffer& b)
+{
+#if TRDF_HAS_IO_URING
+  if (ring_)
+  {
+    // Completions may arrive out of order, mark each one on its buffer.
+    while (b.pending_)
+    {
+      auto const [index, result] = ring_->wait();
+      auto& done = buffers_[index];
+      done.pending_ = false;
+      if (result < 0) {
+        throw std::runtime_error(fmt::format("read of table file '{}' failed: {}", file_.path().string(), std::strerror(-result)));
+      }
+      if ((size_t)result < done.needed_) {
+        read_fully(done);   // Short read, rare for regular files.
+      }
+    }
+    return;
+  }
+#endif
+  b.pending_ = false;
+  b.future_.get();
+}
+
+void block_reader::drain()
+{
+  for (auto& b : buffers_) {
+    try {
+      if (b.pending_) {
+        wait(b);
+      }
+    }
+    catch (std::runtime_error const&) {
+      // Only the buffer memory matters here.
+    }
+  }
+}
+
+void block_reader::read(consumer const& consume, size_t first, size_t count)
+{
+  if (first >= count_) {
+    return;
+  }
+  count = std::min(count, count_ - first);
+
+  auto const mem_size = desc().mem_size();
+  auto const base = file_.header().records_offset_ + first * mem_size;
+  auto const lead = base % k_direct_align;      // Same for every block as block sizes are aligned.
+  auto const blocks = (count + block_records_ - 1) / block_records_;
+  auto const depth = buffers_.size();
+
+  auto const block_count = [&](size_t k) { return std::min(block_records_, count - k * block_records_); };
+  auto const submit_block = [&](size_t k) {
+    submit(buffers_[k % depth], base + k * block_records_ * mem_size, block_count(k) * mem_size);
+  };
+
+  try
+  {
+    for (size_t k = 0; k < std::min(depth, blocks); ++k) {
+      submit_block(k);
+    }
+
+    for (size_t k = 0; k < blocks; ++k)
+    {
+      auto& b = buffers_[k % depth];
+      wait(b);
+      consume(record_span<record>{ b.mem_.get() + lead, mem_size, block_count(k) }, first + k * block_records_);
+      if (k + depth < blocks) {
+        submit_block(k + depth);
+      }
+    }
+  }
+  catch (...)
+  {
+    drain();    // No read may complete into a buffer after it is released.
+    throw;
+  }
+}
+
+} // namespace rdf
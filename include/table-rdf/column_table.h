@@ -0,0 +1,243 @@
+#pragma once
+#include "descriptor.h"
+
+#include <oneapi/tbb.h>
+
+#include <memory>
+#include <span>
+
+namespace rdf
+{
+
+// Columnar (structure of arrays) storage for records of a descriptor.
+// Each field is stored in its own contiguous, cache line aligned array of field.size() bytes per row, except string
+// fields which are split into a length column (the prefix) and a payload column of field.payload() bytes per row.
+// A scan of a single numeric field therefore reads only that field's bytes.
+// from_rows() / to_rows() transpose between the row-oriented RDF layout and this layout.
+class column_table
+{
+public:
+  static constexpr size_t k_column_align = 64;          // Cache line.
+  static constexpr size_t k_block_bytes = 32 * 1024;    // Row bytes per transpose block, roughly L1 sized.
+
+  inline column_table(descriptor const& desc, size_t capacity);
+
+  column_table(column_table const&) = delete;
+  column_table& operator=(column_table const&) = delete;
+  column_table(column_table&&) = default;
+  column_table& operator=(column_table&&) = default;
+
+  descriptor const& desc() const { return desc_; }
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+  void resize(size_t size) { BOOST_ASSERT(size <= capacity_); size_ = size; }
+
+  // Raw column of a field, width(f) bytes per row. For string fields this is the length prefix column.
+  mem_t const* data(field const& f) const { return parts_[columns_[f.index()]].data_; }
+  mem_t*       data(field const& f)       { return parts_[columns_[f.index()]].data_; }
+  size_t       width(field const& f) const { return parts_[columns_[f.index()]].width_; }
+
+  // Payload column of a string field, f.payload() bytes per row.
+  mem_t const* payload(field const& f) const { BOOST_ASSERT(string_type(f.type())); return parts_[columns_[f.index()] + 1].data_; }
+
+  // Typed view of a non-string column. Timestamp columns are viewed as raw_time_t.
+  template <types::type T> requires (!types::string_type(T))
+  auto column(field const& f) const;
+
+  template <types::type T> inline value_t<T> const get(field const& f, size_t row) const;
+  template <types::type T> inline void             set(field const& f, size_t row, value_t<T> const value);
+
+  // Transpose count rows into rows [first, first + count) of the table, growing size() if needed.
+  inline void from_rows(mem_t const* rows, size_t count, size_t first = 0);
+
+  // Transpose table rows [first, first + count) into count rows.
+  inline void to_rows(mem_t* rows, size_t count, size_t first = 0) const;
+
+private:
+  // A contiguous array holding width_ bytes per row, taken from row_offset_ of each RDF row.
+  struct part
+  {
+    mem_t* data_;
+    size_t width_;
+    field::offset_t row_offset_;
+  };
+
+  template <bool ToRows>
+  inline void transpose(mem_t* rows, size_t count, size_t first) const;
+
+  struct free_deleter { void operator()(mem_t* p) const { std::free(p); } };
+
+  descriptor desc_;
+  size_t capacity_;
+  size_t size_;
+  std::unique_ptr<mem_t, free_deleter> mem_;
+  std::vector<part> parts_;
+  std::vector<size_t> columns_;    // Index into parts_ for each field index.
+};
+
+column_table::column_table(descriptor const& desc, size_t capacity)
+  : desc_{desc},
+    capacity_{capacity},
+    size_{0}
+{
+  for (auto const& f : desc_.fields())
+  {
+    columns_.push_back(parts_.size());
+    if (string_type(f.type())) {
+      auto const prefix = k_type_props[f.type()].size_;
+      parts_.push_back({nullptr, prefix, f.offset()});
+      parts_.push_back({nullptr, f.payload(), f.offset() + prefix});
+    }
+    else {
+      parts_.push_back({nullptr, f.size(), f.offset()});
+    }
+  }
+
+  // One allocation, with each column starting on a cache line.
+  size_t total = 0;
+  for (auto const& p : parts_) {
+    total += bal::align_up(p.width_ * std::max<size_t>(capacity_, 1), k_column_align);
+  }
+  mem_.reset((mem_t*)std::aligned_alloc(k_column_align, total));
+  if (!mem_) {
+    throw std::bad_alloc{};
+  }
+
+  auto next = mem_.get();
+  for (auto& p : parts_) {
+    p.data_ = next;
+    next += bal::align_up(p.width_ * std::max<size_t>(capacity_, 1), k_column_align);
+  }
+}
+
+template <types::type T> requires (!types::string_type(T))
+auto column_table::column(field const& f) const
+{
+  BOOST_ASSERT(f.type() == T);
+  using V = std::conditional_t<concepts::timestamp<value_t<T>>, raw_time_t, value_t<T>>;
+  return std::span<V const>{reinterpret_cast<V const*>(data(f)), size_};
+}
+
+template <types::type T>
+value_t<T> const column_table::get(field const& f, size_t row) const
+{
+  BOOST_ASSERT(f.type() == T);
+  BOOST_ASSERT(row < size_);
+
+  if constexpr (string_type(T)) {
+    using prefix_t = traits<T>::prefix_t;
+    auto const length = reinterpret_cast<prefix_t const*>(data(f))[row];
+    return { reinterpret_cast<char const*>(payload(f) + row * f.payload()), length };
+  }
+  else if constexpr (concepts::timestamp<value_t<T>>) {
+    return util::make_timestamp(column<T>(f)[row]);
+  }
+  else {
+    return column<T>(f)[row];
+  }
+}
+
+template <types::type T>
+void column_table::set(field const& f, size_t row, value_t<T> const value)
+{
+  BOOST_ASSERT(f.type() == T);
+  BOOST_ASSERT(row < capacity_);
+
+  auto const p = columns_[f.index()];
+  if constexpr (string_type(T)) {
+    using prefix_t = traits<T>::prefix_t;
+    if (value.length() > f.payload()) {
+      throw std::runtime_error("string too large for payload");
+    }
+    else if (value.length() != (prefix_t)value.length()) {
+      throw std::runtime_error(fmt::format("string of type '{}' has length {} that does not fit in {}-bits", enum_names_type(T), value.length(), sizeof(prefix_t) * 8));
+    }
+    reinterpret_cast<prefix_t*>(parts_[p].data_)[row] = (prefix_t)value.length();
+    std::memcpy(parts_[p + 1].data_ + row * f.payload(), value.data(), value.length());
+  }
+  else if constexpr (concepts::timestamp<value_t<T>>) {
+    reinterpret_cast<raw_time_t*>(parts_[p].data_)[row] = value.time_since_epoch().count();
+  }
+  else {
+    reinterpret_cast<value_t<T>*>(parts_[p].data_)[row] = value;
+  }
+}
+
+namespace kernels {
+
+  // Copy n elements of W bytes between a strided (row) and a dense (column) array. A compile-time W turns each
+  // memcpy into a single load / store.
+  template <size_t W, bool ToRows>
+  inline void transpose_fixed(mem_t* rows, mem_t* col, size_t stride, size_t n)
+  {
+    for (size_t i = 0; i < n; ++i) {
+      if constexpr (ToRows) {
+        std::memcpy(rows + i * stride, col + i * W, W);
+      }
+      else {
+        std::memcpy(col + i * W, rows + i * stride, W);
+      }
+    }
+  }
+
+  template <bool ToRows>
+  inline void transpose(mem_t* rows, mem_t* col, size_t width, size_t stride, size_t n)
+  {
+    switch (width)
+    {
+      case 1:  transpose_fixed<1, ToRows>(rows, col, stride, n);  break;
+      case 2:  transpose_fixed<2, ToRows>(rows, col, stride, n);  break;
+      case 4:  transpose_fixed<4, ToRows>(rows, col, stride, n);  break;
+      case 8:  transpose_fixed<8, ToRows>(rows, col, stride, n);  break;
+      case 16: transpose_fixed<16, ToRows>(rows, col, stride, n); break;
+      default:
+        for (size_t i = 0; i < n; ++i) {
+          if constexpr (ToRows) {
+            std::memcpy(rows + i * stride, col + i * width, width);
+          }
+          else {
+            std::memcpy(col + i * width, rows + i * stride, width);
+          }
+        }
+    }
+  }
+
+} // namespace kernels
+
+template <bool ToRows>
+void column_table::transpose(mem_t* rows, size_t count, size_t first) const
+{
+  BOOST_ASSERT(first + count <= capacity_);
+
+  // Rows are processed in blocks that fit in L1 so each block is read from memory once, while every column is
+  // written (or read) sequentially. Blocks are distributed over TBB workers.
+  auto const stride = desc_.mem_size();
+  auto const block_rows = std::max<size_t>(1, k_block_bytes / stride);
+
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, count, block_rows),
+    [&](tbb::blocked_range<size_t> const& range)
+    {
+      for (size_t b = range.begin(); b < range.end(); b += block_rows)
+      {
+        auto const n = std::min(block_rows, range.end() - b);
+        auto const block = rows + b * stride;
+        for (auto const& p : parts_) {
+          kernels::transpose<ToRows>(block + p.row_offset_, p.data_ + (first + b) * p.width_, p.width_, stride, n);
+        }
+      }
+    });
+}
+
+void column_table::from_rows(mem_t const* rows, size_t count, size_t first)
+{
+  transpose<false>(const_cast<mem_t*>(rows), count, first);    // Rows are only read when ToRows is false.
+  size_ = std::max(size_, first + count);
+}
+
+void column_table::to_rows(mem_t* rows, size_t count, size_t first) const
+{
+  BOOST_ASSERT(first + count <= size_);
+  transpose<true>(rows, count, first);
+}
+
+} // namespace rdf
@@ -1,5 +1,7 @@
 #pragma once
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <string_view>
 
 namespace rdf
@@ -11,7 +13,7 @@ namespace rdf
   //    - lack of cbegin / cend (added back in for C++23 but not implemented in MSVC 10.0.19041.0).
   //    - lack of operator== for no good reason imo.
   // TODO: Would it be possible to use a static-extent span with dynamic descriptors.
-  // TODO: std::span also cannot have a runtime stride over it's data. We need a custom type.
+  // Note: std::span cannot have a runtime stride over it's data, see record_span for strided record access.
   // TODO: Switch to using my_mspan.size() instead of my_mspan.size_bytes() where appropriate, they should be equivalent.
   using mspan = std::span<mem_t const>;
   
@@ -25,7 +27,59 @@ namespace rdf
 
   using string_t = std::string_view;
   using key_t = string_t;
+  using key_code_t = uint32_t;     // Code of a dictionary encoded key, see key_dictionary.
+
+  // Value of a StringRef field, a string held out of line in a string_arena. Strings of up to k_inline bytes are
+  // stored in the reference itself, longer ones as their first k_prefix bytes and their offset into the arena, so
+  // most comparisons can be decided without touching the arena.
+  struct string_ref
+  {
+    static constexpr size_t k_inline = 12;
+    static constexpr size_t k_prefix = 4;
+
+    uint32_t length_ = 0;
+    char data_[k_inline] = {};    // The string, or the prefix followed by the 8 byte offset.
+
+    bool inlined() const { return length_ <= k_inline; }
+    uint64_t offset() const { uint64_t o; std::memcpy(&o, data_ + k_prefix, sizeof(o)); return o; }
+
+    bool operator==(string_ref const& other) const = default;
+  };
   
+  // SIMD code paths follow the target instruction set (see TRDF_NATIVE_ARCH in CMakeLists.txt).
+  // MSVC does not define the SSE feature macros so /arch:AVX and above are taken to imply SSSE3.
+  #if defined(__SSSE3__) || defined(__AVX__)
+    #define TRDF_HAS_SSSE3 1
+  #else
+    #define TRDF_HAS_SSSE3 0
+  #endif
+
+  // Gathers and vector compares for scan.h, AVX-512 when F, BW and DQ are all available.
+  #if defined(__AVX2__)
+    #define TRDF_HAS_AVX2 1
+  #else
+    #define TRDF_HAS_AVX2 0
+  #endif
+  #if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512DQ__)
+    #define TRDF_HAS_AVX512 1
+  #else
+    #define TRDF_HAS_AVX512 0
+  #endif
+
+  // File change notification for table_follower, other platforms fall back to polling.
+  #if defined(__linux__)
+    #define TRDF_HAS_INOTIFY 1
+  #else
+    #define TRDF_HAS_INOTIFY 0
+  #endif
+
+  // Asynchronous reads for block_reader, other platforms fall back to pread on worker threads.
+  #if defined(__linux__) && __has_include(<linux/io_uring.h>)
+    #define TRDF_HAS_IO_URING 1
+  #else
+    #define TRDF_HAS_IO_URING 0
+  #endif
+
   #if TRDF_HAS_CHRONO_PARSE
     #define CHRONO_PARSE_NAMESPACE std::chrono
   #else
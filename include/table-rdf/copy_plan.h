@@ -0,0 +1,232 @@
+#pragma once
+#include "descriptor.h"
+
+#include <utility>
+
+namespace rdf
+{
+
+namespace conversions {
+
+  using convert_fn = void (*)(mem_t* dest, mem_t const* src);
+
+  template <types::type S, types::type D>
+  void convert(mem_t* dest, mem_t const* src)
+  {
+    *reinterpret_cast<value_t<D>*>(dest) = static_cast<value_t<D>>(*reinterpret_cast<value_t<S> const*>(src));
+  }
+
+  template <types::type S, types::type D>
+  constexpr convert_fn make_converter()
+  {
+    // Dictionary codes are only meaningful to their dictionary, so are never converted.
+    if constexpr (concepts::numeric<value_t<S>> && concepts::numeric<value_t<D>> && S != KeyDict && D != KeyDict) {
+      return &convert<S, D>;
+    }
+    else {
+      return nullptr;
+    }
+  }
+
+  template <size_t... I>
+  constexpr auto make_converters(std::index_sequence<I...>)
+  {
+    return std::array<convert_fn, sizeof...(I)>{ make_converter<types::type(I / type_numof), types::type(I % type_numof)>()... };
+  }
+
+  // Flattened [source type][destination type] table of numeric converters, nullptr where no conversion exists.
+  inline constexpr auto k_numeric = make_converters(std::make_index_sequence<type_numof * type_numof>{});
+
+  inline convert_fn numeric(types::type src, types::type dest) { return k_numeric[src * type_numof + dest]; }
+
+} // namespace conversions
+
+// A precompiled plan for copying records laid out by a source descriptor into records laid out by a destination
+// descriptor. Fields are matched by name and the plan is built once per (source, destination) pair:
+//   - Fields with the same type (and a destination payload at least as large) become byte ranges, and ranges that are
+//     contiguous in both layouts are coalesced into a few wide memcpy runs.
+//   - String fields whose destination payload or prefix type differs are re-prefixed and length checked.
+//   - Numeric fields of different types are converted with a static_cast.
+// Destination fields without a source field of the same name are left untouched.
+// If both descriptors have identical layouts the whole batch is copied with a single memcpy.
+class copy_plan
+{
+public:
+  struct run
+  {
+    field::offset_t src_offset;
+    field::offset_t dest_offset;
+    size_t size;
+  };
+
+  inline copy_plan(descriptor const& src, descriptor const& dest);
+
+  // Copy a single record.
+  inline void copy(mem_t* dest, mem_t const* src) const;
+
+  // Copy count contiguous records.
+  inline void copy(mem_t* dest, mem_t const* src, size_t count) const;
+
+  bool trivial() const { return trivial_; }
+  std::vector<run> const& runs() const { return runs_; }
+  size_t special_count() const { return strings_.size() + conversions_.size(); }
+
+  size_t src_size() const { return src_size_; }
+  size_t dest_size() const { return dest_size_; }
+
+  // Logging.
+  inline std::string describe() const;
+
+private:
+  struct string_op
+  {
+    field::offset_t src_offset;
+    field::offset_t dest_offset;
+    size_t src_prefix;      // Size of the length prefix in bytes.
+    size_t dest_prefix;
+    size_t dest_payload;
+    std::string name;       // For error reporting.
+  };
+
+  struct convert_op
+  {
+    field::offset_t src_offset;
+    field::offset_t dest_offset;
+    conversions::convert_fn fn;
+  };
+
+  inline void copy_strings(mem_t* dest, mem_t const* src) const;
+
+private:
+  std::vector<run> runs_;
+  std::vector<string_op> strings_;
+  std::vector<convert_op> conversions_;
+  size_t src_size_;
+  size_t dest_size_;
+  bool trivial_;
+};
+
+copy_plan::copy_plan(descriptor const& src, descriptor const& dest)
+  : src_size_{src.mem_size()},
+    dest_size_{dest.mem_size()},
+    trivial_{false}
+{
+  // Destination byte ranges that must not be written by a coalesced run (fields with no source).
+  std::vector<run> untouched;
+
+  for (auto const& df : dest.fields())
+  {
+    if (!src.contains(df.name())) {
+      untouched.push_back({0, df.offset(), df.size()});
+      continue;
+    }
+    auto const& sf = src.fields(df.name());
+
+    if (sf.type() == df.type() && sf.payload() <= df.payload()) {
+      runs_.push_back({sf.offset(), df.offset(), sf.size()});
+    }
+    else if (string_type(sf.type()) && string_type(df.type())) {
+      strings_.push_back({sf.offset(), df.offset(), k_type_props[sf.type()].size_, k_type_props[df.type()].size_, df.payload(), df.name()});
+    }
+    else if (auto fn = conversions::numeric(sf.type(), df.type())) {
+      conversions_.push_back({sf.offset(), df.offset(), fn});
+    }
+    else {
+      throw std::runtime_error(fmt::format("cannot copy field '{}' of type '{}' to type '{}'", sf.name(), sf.type_name(), df.type_name()));
+    }
+  }
+
+  // Coalesce runs that are contiguous in both layouts. Runs may also be bridged over a gap of the same size in both
+  // layouts (i.e. padding or a field handled specially below) as long as no untouched destination field is overwritten.
+  std::ranges::sort(runs_, {}, &run::dest_offset);
+  std::vector<run> merged;
+  for (auto const& r : runs_)
+  {
+    if (!merged.empty())
+    {
+      auto& m = merged.back();
+      auto const dest_gap = r.dest_offset - (m.dest_offset + m.size);
+      auto const src_gap = (intptr_t)r.src_offset - (intptr_t)(m.src_offset + m.size);
+      auto const clobbers = std::ranges::any_of(untouched, [&](auto const& u) {
+        return u.dest_offset < r.dest_offset && u.dest_offset + u.size > m.dest_offset + m.size;
+      });
+      if (src_gap >= 0 && (size_t)src_gap == dest_gap && !clobbers) {
+        m.size = r.dest_offset + r.size - m.dest_offset;
+        continue;
+      }
+    }
+    merged.push_back(r);
+  }
+  runs_ = std::move(merged);
+
+  // Extend a single run over the trailing padding so identical layouts reduce to one memcpy per batch.
+  trivial_ = src_size_ == dest_size_ && special_count() == 0 && untouched.empty() &&
+             runs_.size() == 1 && runs_[0].src_offset == 0 && runs_[0].dest_offset == 0;
+  if (trivial_) {
+    runs_[0].size = dest_size_;
+  }
+}
+
+void copy_plan::copy_strings(mem_t* dest, mem_t const* src) const
+{
+  for (auto const& op : strings_)
+  {
+    size_t const length = op.src_prefix == sizeof(uint8_t) ? *reinterpret_cast<uint8_t const*>(src + op.src_offset)
+                                                           : *reinterpret_cast<uint16_t const*>(src + op.src_offset);
+    if (length > op.dest_payload) {
+      throw std::runtime_error(fmt::format("string of length {} too large for payload of field '{}'", length, op.name));
+    }
+
+    if (op.dest_prefix == sizeof(uint8_t)) {
+      *reinterpret_cast<uint8_t*>(dest + op.dest_offset) = (uint8_t)length;
+    }
+    else {
+      *reinterpret_cast<uint16_t*>(dest + op.dest_offset) = (uint16_t)length;
+    }
+    std::memcpy(dest + op.dest_offset + op.dest_prefix, src + op.src_offset + op.src_prefix, length);
+  }
+}
+
+void copy_plan::copy(mem_t* dest, mem_t const* src) const
+{
+  for (auto const& r : runs_) {
+    std::memcpy(dest + r.dest_offset, src + r.src_offset, r.size);
+  }
+  copy_strings(dest, src);
+  for (auto const& op : conversions_) {
+    op.fn(dest + op.dest_offset, src + op.src_offset);
+  }
+}
+
+void copy_plan::copy(mem_t* dest, mem_t const* src, size_t count) const
+{
+  if (trivial_) {
+    std::memcpy(dest, src, count * dest_size_);
+    return;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    copy(dest, src);
+    src += src_size_;
+    dest += dest_size_;
+  }
+}
+
+std::string copy_plan::describe() const
+{
+  std::stringstream ss;
+  ss << "\n--- copy plan" << (trivial() ? " (trivial)" : "") << " ---\n";
+  for (auto const& r : runs_) {
+    ss << fmt::format("[run] src offset: {:4} -> dest offset: {:4} size: {:4}\n", r.src_offset, r.dest_offset, r.size);
+  }
+  for (auto const& op : strings_) {
+    ss << fmt::format("[str] src offset: {:4} -> dest offset: {:4} '{}'\n", op.src_offset, op.dest_offset, op.name);
+  }
+  for (auto const& op : conversions_) {
+    ss << fmt::format("[cvt] src offset: {:4} -> dest offset: {:4}\n", op.src_offset, op.dest_offset);
+  }
+  ss << "--- src size: " << src_size() << ", dest size: " << dest_size() << " ---\n";
+  return ss.str();
+}
+
+} // namespace rdf
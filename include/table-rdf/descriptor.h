@@ -4,9 +4,8 @@
 #include "util.h"
 #include "field.h"
 #include "fields_builder.h"
+#include "name_table.h"
 
-#include <map>
-#include <unordered_map>
 #include <fmt/core.h>
 #include <array>
 
@@ -15,12 +14,21 @@ namespace rdf
 class descriptor
 {
 public:
+  // Order of the field offsets, see the constructors.
+  enum class layout_kind { unpacked, packed, hot_cold };
+
+  static constexpr size_t k_cache_line = 64;
+
+  // Relative access frequency of fields by name, e.g. the reads per record of typical scans, for a hot_cold layout.
+  // Fields not named have weight 0 and are cold.
+  using field_weights = std::vector<std::pair<std::string, double>>;
+
   // Construct a descriptor from a vector of fields.
   // The memory layout is computed to mimic C++ struct layout rules:
   //   - mem_align() is the size and alignment of the largest field.
   //   - Each offset will respect the corresponding field's alignment.
   //   - mem_size() includes padding for alignment to mem_align().
-  // If pack is true, field offsets are sorted by descending alignment.
+  // If pack is true, field offsets are sorted by descending alignment, fields of equal alignment keep their relative order.
   // The index order of the fields argument is always preserved in the descriptor, i.e. desc.fields(i) == fields[i].
   // Use describe() to print the descriptor layout.
   inline descriptor(std::string const& name,
@@ -31,13 +39,33 @@ public:
                     fields_builder const& builder,
                     bool pack = true);
 
+  // Cache line aware (hot_cold) layout. Fields with a weight > 0 are packed into the first cache lines, heaviest first,
+  // followed by hot strings, the cold fixed size fields and last the cold strings with their large payloads. Records
+  // are aligned and padded to a whole number of cache lines (or to a power of two if smaller than one) so the fields
+  // of each cache line are the same in every record. describe(true) shows the cache line boundaries.
+  inline descriptor(std::string const& name,
+                    std::vector<field> const& fields,
+                    field_weights const& weights);
+
+  inline descriptor(std::string const& name,
+                    fields_builder const& builder,
+                    field_weights const& weights);
+
   virtual ~descriptor() = default;
 
   std::string_view          name() const { return name_; }
+  bool                      packed() const { return layout_ != layout_kind::unpacked; }
+  layout_kind               layout() const { return layout_; }
+  double                    weight(field::index_t index) const { return weights_.empty() ? 0.0 : weights_[index]; }
 
   std::vector<field> const& fields() const { return fields_; }
                field const& fields(field::index_t index) const { BOOST_ASSERT(index < fields().size()); return fields()[index]; }
-               field const& fields(char const* name) const { return fields_by_name_.at(name); }
+               field const& fields(field_handle handle) const { BOOST_ASSERT(handle.index() < fields().size()); return fields_[handle.index()]; }
+  inline       field const& fields(field_name const& name) const;
+
+  // Resolve a field name once, subsequent access through the handle is a plain index.
+  inline field_handle handle(field_name const& name) const;
+  bool contains(field_name const& name) const { return names_.find(name, fields_) != field::k_null_index; }
   
   size_t mem_size() const { return mem_size_; }     // The in-memory size including padding for alignment to mem_align().
   size_t mem_align() const { return mem_align_; }
@@ -47,7 +75,6 @@ public:
   bool operator==(descriptor const& other) const {
     return name_ == other.name_ &&
            fields_ == other.fields_ &&
-           fields_by_name_ == other.fields_by_name_ &&
            mem_size_ == other.mem_size_ &&
            mem_align_ == other.mem_align_;
   }
@@ -61,9 +88,18 @@ public:
   inline std::string header() const;
 
 private:
+  // Field indices in offset order, each with the least offset it may be placed at.
+  using placement = std::vector<std::pair<field::index_t, field::offset_t>>;
+
+  inline placement sequential_placement(bool pack) const;
+  inline placement hot_cold_placement() const;
+  inline void place(placement const& order);
+
   std::string name_;
   std::vector<field> fields_;
-  std::map<std::string, field const&> fields_by_name_;
+  name_table names_;
+  layout_kind layout_;
+  std::vector<double> weights_;     // By field index, hot_cold only.
   size_t mem_size_;
   size_t mem_align_;
 };
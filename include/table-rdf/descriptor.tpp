@@ -1,4 +1,5 @@
 #pragma once
+#include <bit>
 #include <ranges>
 #include <numeric>
 
@@ -10,60 +11,184 @@ namespace rdf
                          bool pack)
       : name_{name},
         fields_{fields},
+        layout_{pack ? layout_kind::packed : layout_kind::unpacked},
         mem_size_{0},
         mem_align_{0}
   {
-    namespace bal = boost::alignment;
+    if (fields_.empty()) {
+      throw std::runtime_error("descriptor must have at least one field");
+    }
+
+    place(sequential_placement(pack));
+  }
+
+  descriptor::descriptor(std::string const& name,
+                         fields_builder const& builder,
+                         bool pack)
+    : descriptor(name, builder.get(), pack)
+  {
+  }
 
+  descriptor::descriptor(std::string const& name,
+                         std::vector<field> const& fields,
+                         field_weights const& weights)
+      : name_{name},
+        fields_{fields},
+        layout_{layout_kind::hot_cold},
+        weights_(fields.size(), 0.0),
+        mem_size_{0},
+        mem_align_{0}
+  {
     if (fields_.empty()) {
       throw std::runtime_error("descriptor must have at least one field");
     }
 
+    for (auto const& [field_name, weight] : weights) {
+      auto const it = std::ranges::find(fields_, field_name, &field::name);
+      if (it == fields_.end()) {
+        throw std::out_of_range(fmt::format("no field named '{}' in descriptor '{}'", field_name, name_));
+      }
+      if (!(weight >= 0)) {
+        throw std::runtime_error(fmt::format("field '{}' has invalid weight {}", field_name, weight));
+      }
+      weights_[it - fields_.begin()] = weight;
+    }
+
+    place(hot_cold_placement());
+  }
+
+  descriptor::descriptor(std::string const& name,
+                         fields_builder const& builder,
+                         field_weights const& weights)
+    : descriptor(name, builder.get(), weights)
+  {
+  }
+
+  descriptor::placement descriptor::sequential_placement(bool pack) const
+  {
     // Create a vector of field indices [0, 1, 2, ...].
     std::vector<field::index_t> indices(fields_.size());
     std::iota(std::begin(indices), std::end(indices), 0);
 
     if (pack)
     {
-      // Sort indices by descending alignment.
-      std::ranges::sort(indices, [&](auto a, auto b) {
+      // Sort indices by descending alignment. The sort is stable so that the layout is deterministic across
+      // standard library implementations (static_descriptor relies on this to reproduce it at compile time).
+      std::ranges::stable_sort(indices, [&](auto a, auto b) {
         return fields_[a].align() > fields_[b].align();
       });
     }
 
-    // Compute offsets so that the in-memory layout is in order of indices vector.
+    placement order;
+    for (auto i : indices) {
+      order.push_back({i, 0});
+    }
+    return order;
+  }
+
+  descriptor::placement descriptor::hot_cold_placement() const
+  {
+    // The fields of a record that fits in a cache line share it whatever their weight, so it is only packed.
+    auto order = sequential_placement(true);
+    field::offset_t end = 0;
+    for (auto [i, least] : order) {
+      end = boost::alignment::align_up(end, fields_[i].align()) + fields_[i].size();
+    }
+    if (end <= k_cache_line) {
+      return order;
+    }
+    order.clear();
+
+    std::vector<field::index_t> hot, hot_strings, cold, cold_strings;
+    for (field::index_t i = 0; i < fields_.size(); ++i) {
+      auto const is_string = types::string_type(fields_[i].type());
+      auto& group = weights_[i] > 0 ? (is_string ? hot_strings : hot) : (is_string ? cold_strings : cold);
+      group.push_back(i);
+    }
+
+    auto const by_align = [&](auto a, auto b) { return fields_[a].align() > fields_[b].align(); };
+    auto const by_size = [&](auto a, auto b) { return fields_[a].size() < fields_[b].size(); };
+    std::ranges::stable_sort(hot, [&](auto a, auto b) { return weights_[a] > weights_[b]; });
+
+    // First fit of the hot fields into cache lines, heaviest first, so lighter fields fill the gaps of earlier lines.
+    // Within a line fields are sorted by descending alignment, as their sizes are multiples of their alignment there
+    // is no padding.
+    std::vector<std::vector<field::index_t>> lines;
+    std::vector<size_t> used;
+    for (auto i : hot) {
+      auto const size = fields_[i].size();
+      auto const line = std::ranges::find_if(used, [&](auto u) { return u + size <= k_cache_line; }) - used.begin();
+      if (line == (ptrdiff_t)used.size()) {
+        lines.emplace_back();
+        used.push_back(0);
+      }
+      lines[line].push_back(i);
+      used[line] += size;
+    }
+
+    for (size_t line = 0; line < lines.size(); ++line) {
+      std::ranges::stable_sort(lines[line], by_align);
+      for (auto i : lines[line]) {
+        order.push_back({i, i == lines[line].front() ? line * k_cache_line : 0});
+      }
+    }
+
+    // Shorter strings first so more string prefixes share the hot lines, and cold payloads last.
+    std::ranges::stable_sort(hot_strings, by_size);
+    std::ranges::stable_sort(cold, by_align);
+    std::ranges::stable_sort(cold_strings, by_size);
+    for (auto const& group : { hot_strings, cold, cold_strings }) {
+      for (auto i : group) {
+        order.push_back({i, 0});
+      }
+    }
+    return order;
+  }
+
+  void descriptor::place(placement const& order)
+  {
+    namespace bal = boost::alignment;
+
+    // Compute offsets so that the in-memory layout is in order of placement.
     // The index order of the fields argument is always preserved in the descriptor, i.e. desc.fields(i) == fields[i].
-    auto const i0 = indices[0];
-    fields_[i0].offset_ = 0;
-    fields_[i0].index_ = i0;
-    auto max_align = fields_[i0].align();
-    for (auto [a, b] : indices | std::views::adjacent<2>)
+    field::offset_t end = 0;
+    size_t max_align = 1;
+    for (auto [i, least] : order)
     {
-      auto offset_ptr = (void*)(fields_[a].offset() + fields_[a].size());
-      fields_[b].offset_ = (field::offset_t)bal::align_up(offset_ptr, fields_[b].align());
-      fields_[b].index_ = b;
-      max_align = std::max(max_align, fields_[b].align());
+      fields_[i].offset_ = bal::align_up(std::max(end, least), fields_[i].align());
+      fields_[i].index_ = i;
+      end = fields_[i].offset_ + fields_[i].size();
+      max_align = std::max(max_align, fields_[i].align());
     }
 
-    // Set the alignment of the descriptor to the maximum alignment of its fields.
+    // Set the alignment of the descriptor to the maximum alignment of its fields, for a hot_cold layout at least that
+    // of a cache line, or of the power of two a smaller record fits in, so records never straddle more lines than
+    // needed.
     mem_align_ = max_align;
+    if (layout_ == layout_kind::hot_cold) {
+      mem_align_ = std::max(mem_align_, std::min(k_cache_line, std::bit_ceil(end)));
+    }
 
     // Compute total size including alignment padding.
-    auto last = fields_[indices.back()];
-    mem_size_ = bal::align_up(last.offset() + last.size(), mem_align_);
+    mem_size_ = bal::align_up(end, mem_align_);
     BOOST_ASSERT(mem_size_ % mem_align_ == 0);
 
-    // Build a map of field names to fields.
-    for (auto const& f : fields_) {
-      BOOST_VERIFY_MSG(fields_by_name_.insert({f.name(), f}).second, fmt::format("duplicate field name '{}'", f.name()).c_str());
+    // Build the field name lookup table. Throws on duplicate names.
+    names_ = name_table{fields_};
+  }
+
+  field const& descriptor::fields(field_name const& name) const
+  {
+    auto const index = names_.find(name, fields_);
+    if (index == field::k_null_index) {
+      throw std::out_of_range(fmt::format("no field named '{}' in descriptor '{}'", name.view(), name_));
     }
+    return fields_[index];
   }
 
-  descriptor::descriptor(std::string const& name,
-                         fields_builder const& builder,
-                         bool pack)
-    : descriptor(name, builder.get(), pack)
+  field_handle descriptor::handle(field_name const& name) const
   {
+    return field_handle{fields(name).index()};
   }
 
   field const& descriptor::find(type t) const
@@ -99,13 +224,23 @@ namespace rdf
       });
     }
 
-    auto const str = [&indices, this]() {
+    auto const str = [&indices, sort_by_offset, this]() {
       std::stringstream ss;
       ss << "\n--- " << name() << " ---\n";
+      auto line = size_t(-1);
       for (auto i : indices) {
-        ss << fields(i).describe(i) << "\n";
+        if (sort_by_offset && fields(i).offset() / k_cache_line != line) {
+          line = fields(i).offset() / k_cache_line;
+          ss << "  -- cache line " << line << " (offset " << line * k_cache_line << ") --\n";
+        }
+        ss << fields(i).describe(i);
+        if (layout_ == layout_kind::hot_cold) {
+          ss << " weight: " << weight(i);
+        }
+        ss << "\n";
       }
-      ss << "--- size: " << mem_size() << ", alignment: " << mem_align() << " ---\n";
+      ss << "--- size: " << mem_size() << ", alignment: " << mem_align()
+         << ", cache lines: " << (mem_size() + k_cache_line - 1) / k_cache_line << " ---\n";
       return ss.str();
     }();
     return str;
@@ -0,0 +1,828 @@
+#pragma once
+#include "column_table.h"
+#include "record_buffer.h"
+#include "string_arena.h"
+#include "table_file.h"
+
+#include <oneapi/tbb.h>
+
+#include <unordered_map>
+
+namespace rdf
+{
+
+// Lightweight column encodings for blocks of records, see encoded_table.
+// Each field of a block is encoded as one column:
+//   - Integers, characters, bools, timestamps and KeyDict codes take the smallest of
+//       for_pack     frame of reference: the minimum, then value - minimum bit-packed,
+//       delta        the first value, then the differences frame of reference packed,
+//       delta2       the first value and difference, then the differences of differences packed (regular ticks),
+//       rle          runs, their values and lengths each frame of reference packed.
+//   - String fields are dictionary encoded per block, the distinct strings then their codes as above. StringRef
+//       strings are resolved through a string_arena, so an archive does not depend on the arena of its records.
+//   - Floating point fields are stored plain.
+// Bit-packed values are grouped by 64, a group of width w taking exactly w words. Each width has its own unpack with
+// the word and shift of every value known at compile time, so a group decodes with straight-line shifts and masks.
+namespace encoding {
+
+  enum class codec : uint8_t { plain, for_pack, delta, delta2, rle, dict };
+
+  // Bit-pack n values of at most w bits.
+  inline void pack(uint64_t const* v, size_t n, unsigned w, std::string& out)
+  {
+    for (size_t g = 0; g < n; g += 64)
+    {
+      std::array<uint64_t, 65> words{};
+      for (size_t j = 0; j < std::min<size_t>(64, n - g); ++j)
+      {
+        auto const bit = j * w;
+        auto const shift = bit & 63;
+        words[bit >> 6] |= v[g + j] << shift;
+        if (shift + w > 64) {
+          words[(bit >> 6) + 1] |= v[g + j] >> (64 - shift);
+        }
+      }
+      out.append(reinterpret_cast<char const*>(words.data()), w * sizeof(uint64_t));
+    }
+  }
+
+  template <unsigned W>
+  inline void unpack64(uint64_t const* in, uint64_t* out)
+  {
+    constexpr uint64_t mask = W == 64 ? ~uint64_t{0} : (uint64_t{1} << W) - 1;
+    for (unsigned j = 0; j < 64; ++j)
+    {
+      auto const bit = j * W;
+      auto const shift = bit & 63;
+      auto v = W == 0 ? 0 : in[bit >> 6] >> shift;
+      if (W < 64 && shift + W > 64) {
+        v |= in[(bit >> 6) + 1] << ((64 - shift) & 63);
+      }
+      out[j] = v & mask;
+    }
+  }
+
+  using unpack_fn = void (*)(uint64_t const* in, uint64_t* out);
+
+  template <size_t... W>
+  constexpr auto make_unpackers(std::index_sequence<W...>) { return std::array<unpack_fn, sizeof...(W)>{ &unpack64<W>... }; }
+
+  inline constexpr auto k_unpack = make_unpackers(std::make_index_sequence<65>{});
+
+  // Bytes of n values bit-packed with width w.
+  inline constexpr size_t packed_size(size_t n, unsigned w) { return (n + 63) / 64 * w * sizeof(uint64_t); }
+
+  // Sequential reader of an encoded block, throwing on a truncated block.
+  class cursor
+  {
+  public:
+    explicit cursor(std::span<mem_t const> bytes) : bytes_{bytes} {}
+
+    std::span<mem_t const> take(size_t n) {
+      if (bytes_.size() < n) {
+        throw std::runtime_error("corrupt encoded block");
+      }
+      auto const s = bytes_.first(n);
+      bytes_ = bytes_.subspan(n);
+      return s;
+    }
+
+    template <class V>
+    V get() { V v; std::memcpy(&v, take(sizeof(V)).data(), sizeof(V)); return v; }
+
+  private:
+    std::span<mem_t const> bytes_;
+  };
+
+  template <class V>
+  inline void put(std::string& out, V v) { out.append(reinterpret_cast<char const*>(&v), sizeof(V)); }
+
+  // Minimum and bit width of the range of v.
+  inline std::pair<int64_t, unsigned> frame(int64_t const* v, size_t n)
+  {
+    if (n == 0) {
+      return { 0, 0 };
+    }
+    auto const [lo, hi] = std::minmax_element(v, v + n);
+    return { *lo, (unsigned)std::bit_width((uint64_t)*hi - (uint64_t)*lo) };
+  }
+
+  inline size_t frame_size(int64_t const* v, size_t n) { return sizeof(int64_t) + 1 + packed_size(n, frame(v, n).second); }
+
+  inline void put_frame(std::string& out, int64_t const* v, size_t n)
+  {
+    auto const [base, w] = frame(v, n);
+    put(out, base);
+    put(out, (uint8_t)w);
+    std::vector<uint64_t> offsets(n);
+    for (size_t i = 0; i < n; ++i) {
+      offsets[i] = (uint64_t)v[i] - (uint64_t)base;
+    }
+    pack(offsets.data(), n, w, out);
+  }
+
+  // Differences (wrapping) of v, d[i] = v[i + 1] - v[i].
+  inline std::vector<int64_t> differences(int64_t const* v, size_t n)
+  {
+    std::vector<int64_t> d(n > 1 ? n - 1 : 0);
+    for (size_t i = 0; i < d.size(); ++i) {
+      d[i] = (int64_t)((uint64_t)v[i + 1] - (uint64_t)v[i]);
+    }
+    return d;
+  }
+
+  // Encode n integers with the codec giving the smallest column.
+  inline void put_integers(std::string& out, int64_t const* v, size_t n)
+  {
+    auto const d = differences(v, n);
+    auto const dd = differences(d.data(), d.size());
+
+    std::vector<int64_t> run_values;
+    std::vector<int64_t> run_lengths;
+    for (size_t i = 0; i < n; ++i) {
+      if (run_values.empty() || run_values.back() != v[i]) {
+        run_values.push_back(v[i]);
+        run_lengths.push_back(0);
+      }
+      ++run_lengths.back();
+    }
+
+    std::array<size_t, 5> sizes{};
+    sizes[(int)codec::for_pack] = frame_size(v, n);
+    sizes[(int)codec::delta]    = n < 2 ? SIZE_MAX : sizeof(int64_t) + frame_size(d.data(), d.size());
+    sizes[(int)codec::delta2]   = n < 3 ? SIZE_MAX : 2 * sizeof(int64_t) + frame_size(dd.data(), dd.size());
+    sizes[(int)codec::rle]      = sizeof(uint64_t) + frame_size(run_values.data(), run_values.size()) +
+                                  frame_size(run_lengths.data(), run_lengths.size());
+    sizes[(int)codec::plain]    = SIZE_MAX;
+    auto const c = (codec)(std::ranges::min_element(sizes) - sizes.begin());
+
+    put(out, c);
+    switch (c)
+    {
+      case codec::delta:
+        put(out, v[0]);
+        put_frame(out, d.data(), d.size());
+        break;
+      case codec::delta2:
+        put(out, v[0]);
+        put(out, d[0]);
+        put_frame(out, dd.data(), dd.size());
+        break;
+      case codec::rle:
+        put(out, (uint64_t)run_values.size());
+        put_frame(out, run_values.data(), run_values.size());
+        put_frame(out, run_lengths.data(), run_lengths.size());
+        break;
+      default:
+        put_frame(out, v, n);
+        break;
+    }
+  }
+
+  // Sequential reader of values bit-packed by put_frame(), unpacking a group of 64 at a time.
+  class frame_reader
+  {
+  public:
+    frame_reader() = default;
+
+    frame_reader(cursor& in, size_t n)
+      : base_{in.get<int64_t>()},
+        width_{in.get<uint8_t>()}
+    {
+      if (width_ > 64) {
+        throw std::runtime_error("corrupt encoded block");
+      }
+      packed_ = in.take(packed_size(n, width_)).data();
+    }
+
+    void read(size_t count, int64_t* out)
+    {
+      while (count > 0)
+      {
+        if (next_ == 64) {
+          alignas(64) std::array<uint64_t, 64> words;
+          std::memcpy(words.data(), packed_ + group_++ * width_ * sizeof(uint64_t), width_ * sizeof(uint64_t));
+          k_unpack[width_](words.data(), values_.data());
+          next_ = 0;
+        }
+        // Copied then offset in place, so the loop only touches out and vectorizes.
+        auto const m = std::min<size_t>(count, 64 - next_);
+        std::memcpy(out, values_.data() + next_, m * sizeof(int64_t));
+        auto const base = (uint64_t)base_;
+        for (size_t j = 0; j < m; ++j) {
+          out[j] = (int64_t)((uint64_t)out[j] + base);
+        }
+        next_ += m;
+        out += m;
+        count -= m;
+      }
+    }
+
+  private:
+    int64_t base_ = 0;
+    unsigned width_ = 0;
+    mem_t const* packed_ = nullptr;
+    size_t group_ = 0;
+    size_t next_ = 64;
+    alignas(64) std::array<uint64_t, 64> values_;
+  };
+
+  // Sequential reader of a column written by put_integers(), so a block can be decoded a few rows at a time.
+  class integer_reader
+  {
+  public:
+    integer_reader() = default;
+
+    integer_reader(cursor& in, size_t n)
+      : codec_{in.get<codec>()}
+    {
+      switch (codec_)
+      {
+        case codec::for_pack:
+          frame_ = frame_reader{in, n};
+          break;
+        case codec::delta:
+        case codec::delta2:
+          if (n < (codec_ == codec::delta ? 2u : 3u)) {
+            throw std::runtime_error("corrupt encoded block");
+          }
+          first_ = in.get<int64_t>();
+          difference_ = codec_ == codec::delta2 ? in.get<int64_t>() : 0;
+          frame_ = frame_reader{in, codec_ == codec::delta ? n - 1 : n - 2};
+          break;
+        case codec::rle:
+        {
+          auto const runs = in.get<uint64_t>();
+          if (runs > n) {
+            throw std::runtime_error("corrupt encoded block");
+          }
+          run_values_.resize(runs);
+          run_lengths_.resize(runs);
+          frame_reader{in, runs}.read(runs, run_values_.data());
+          frame_reader{in, runs}.read(runs, run_lengths_.data());
+          uint64_t total = 0;
+          for (auto const length : run_lengths_) {
+            if (length < 0 || (uint64_t)length > n) {
+              throw std::runtime_error("corrupt encoded block");
+            }
+            total += length;
+          }
+          if (total != n) {
+            throw std::runtime_error("corrupt encoded block");
+          }
+          break;
+        }
+        default:
+          throw std::runtime_error("corrupt encoded block");
+      }
+    }
+
+    void read(size_t count, int64_t* out)
+    {
+      switch (codec_)
+      {
+        case codec::for_pack:
+          frame_.read(count, out);
+          break;
+        case codec::delta:
+          for (; count > 0 && read_ < 1; --count, ++read_) {
+            *out++ = previous_ = first_;
+          }
+          frame_.read(count, out);
+          for (size_t i = 0; i < count; ++i) {
+            out[i] = previous_ = (int64_t)((uint64_t)previous_ + (uint64_t)out[i]);
+          }
+          read_ += count;
+          break;
+        case codec::delta2:
+          for (; count > 0 && read_ < 2; --count, ++read_) {
+            *out++ = previous_ = read_ == 0 ? first_ : (int64_t)((uint64_t)first_ + (uint64_t)difference_);
+          }
+          frame_.read(count, out);
+          for (size_t i = 0; i < count; ++i) {
+            difference_ = (int64_t)((uint64_t)difference_ + (uint64_t)out[i]);
+            out[i] = previous_ = (int64_t)((uint64_t)previous_ + (uint64_t)difference_);
+          }
+          read_ += count;
+          break;
+        case codec::rle:
+          while (count > 0) {
+            if (run_left_ == 0) {
+              run_left_ = (size_t)run_lengths_[run_++];
+              continue;
+            }
+            auto const m = std::min(count, run_left_);
+            std::fill_n(out, m, run_values_[run_ - 1]);
+            out += m;
+            count -= m;
+            run_left_ -= m;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+
+  private:
+    codec codec_ = codec::for_pack;
+    frame_reader frame_;
+    size_t read_ = 0;
+    int64_t first_ = 0;
+    int64_t difference_ = 0;
+    int64_t previous_ = 0;
+    std::vector<int64_t> run_values_;
+    std::vector<int64_t> run_lengths_;
+    size_t run_ = 0;
+    size_t run_left_ = 0;
+  };
+
+  // Fields stored as integers, sign extended when signed.
+  inline constexpr bool integer_column(types::type t)
+  {
+    return t == types::Timestamp || (t >= types::Char && t <= types::Uint64) || t == types::Bool || t == types::KeyDict;
+  }
+
+  inline constexpr bool signed_column(types::type t)
+  {
+    return t == types::Timestamp || (t >= types::Int8 && t <= types::Int64) || (t == types::Char && std::is_signed_v<char>);
+  }
+
+  template <size_t W, bool Signed>
+  inline void read_integers(mem_t const* p, size_t stride, size_t n, int64_t* out)
+  {
+    using U = std::conditional_t<W == 1, uint8_t, std::conditional_t<W == 2, uint16_t, std::conditional_t<W == 4, uint32_t, uint64_t>>>;
+    using S = std::make_signed_t<U>;
+    for (size_t i = 0; i < n; ++i) {
+      U u;
+      std::memcpy(&u, p + i * stride, W);
+      out[i] = Signed ? (int64_t)(S)u : (int64_t)u;
+    }
+  }
+
+  template <size_t W>
+  inline void write_integers(int64_t const* v, size_t n, mem_t* p, size_t stride)
+  {
+    using U = std::conditional_t<W == 1, uint8_t, std::conditional_t<W == 2, uint16_t, std::conditional_t<W == 4, uint32_t, uint64_t>>>;
+    for (size_t i = 0; i < n; ++i) {
+      auto const u = (U)v[i];
+      std::memcpy(p + i * stride, &u, W);
+    }
+  }
+
+  template <bool Signed>
+  inline void read_integers(field const& f, mem_t const* p, size_t stride, size_t n, int64_t* out)
+  {
+    switch (f.size())
+    {
+      case 1: read_integers<1, Signed>(p, stride, n, out); break;
+      case 2: read_integers<2, Signed>(p, stride, n, out); break;
+      case 4: read_integers<4, Signed>(p, stride, n, out); break;
+      case 8: read_integers<8, Signed>(p, stride, n, out); break;
+      default: BOOST_ASSERT_MSG(false, "invalid integer width");
+    }
+  }
+
+  inline void write_integers(field const& f, int64_t const* v, size_t n, mem_t* p, size_t stride)
+  {
+    switch (f.size())
+    {
+      case 1: write_integers<1>(v, n, p, stride); break;
+      case 2: write_integers<2>(v, n, p, stride); break;
+      case 4: write_integers<4>(v, n, p, stride); break;
+      case 8: write_integers<8>(v, n, p, stride); break;
+      default: BOOST_ASSERT_MSG(false, "invalid integer width");
+    }
+  }
+
+  // Fields dictionary encoded as strings.
+  inline constexpr bool string_column(types::type t) { return types::string_type(t) || t == types::StringRef; }
+
+  // The string of a string column. Out of line StringRef strings need the arena.
+  inline string_t read_string(field const& f, mem_t const* mem, string_arena const* arena)
+  {
+    switch (f.type())
+    {
+      case types::Key8:     return f.read<types::Key8>(mem);
+      case types::Key16:    return f.read<types::Key16>(mem);
+      case types::String8:  return f.read<types::String8>(mem);
+      case types::String16: return f.read<types::String16>(mem);
+      case types::StringRef:
+        if (auto const ref = f.read<types::StringRef>(mem); !arena && !ref.inlined()) {
+          throw std::runtime_error(fmt::format("field '{}': string of length {} needs a string_arena", f.name(), ref.length_));
+        }
+        return arena ? arena->read(f, mem) : string_arena{}.read(f, mem);
+      default:              return {};
+    }
+  }
+
+  inline void write_string(field const& f, mem_t* mem, string_t s)
+  {
+    switch (f.type())
+    {
+      case types::Key8:     f.write<types::Key8>(mem, s);     break;
+      case types::Key16:    f.write<types::Key16>(mem, s);    break;
+      case types::String8:  f.write<types::String8>(mem, s);  break;
+      case types::String16: f.write<types::String16>(mem, s); break;
+      default: break;
+    }
+  }
+
+} // namespace encoding
+
+// Encode a block of records, see encoding. StringRef fields are resolved through arena, which may only be null if
+// all their strings are inline.
+inline std::string encode_block(descriptor const& desc, record_span<record> records, string_arena const* arena = nullptr);
+
+// Decode a block of desc records into out, which holds capacity records. Returns the number of records. Out of line
+// StringRef strings are appended to arena, which may only be null if there are none.
+inline size_t decode_block(descriptor const& desc, std::span<mem_t const> bytes, mem_t* out, size_t capacity,
+                           string_arena* arena = nullptr);
+
+// Records in an encoded block.
+inline size_t block_size(std::span<mem_t const> bytes) { return encoding::cursor{bytes}.get<uint64_t>(); }
+
+// Fixed size header at the start of an encoded table file, followed by the serialized descriptor, the blocks and an
+// index of the offset and size of each block.
+struct encoded_header
+{
+  static constexpr uint64_t k_magic = 0x3143'4e45'2d4c'4254;    // "TBL-ENC1" in little endian.
+  static constexpr uint32_t k_version = 1;
+
+  uint64_t magic_;
+  uint32_t version_;
+  uint32_t header_size_;        // sizeof(encoded_header).
+  uint64_t descriptor_size_;    // Bytes of serialized descriptor following the header.
+  uint64_t count_;              // Records.
+  uint64_t block_records_;      // Records per block, except the last.
+  uint64_t block_count_;
+  uint64_t index_offset_;       // File offset of the block index.
+  uint64_t reserved_;
+};
+
+static_assert(sizeof(encoded_header) == 64);
+
+// A read only table stored as encoded blocks, for archived tables where disk footprint and scans from slow storage
+// matter more than random access. Blocks are encoded and decoded in parallel, and decode into ordinary records.
+// The strings of StringRef fields are stored in the blocks, so they are written from a string_arena and decoded into
+// one, e.g.
+//   encoded_table::write("trades.enc", file.desc(), file.records(), encoded_table::k_block_records, &names);
+//   auto const archive = encoded_table::open("trades.enc");
+//   archive.scan([&](size_t first, record_span<record> records, string_arena const& strings) { ... });
+class encoded_table
+{
+public:
+  static constexpr size_t k_block_records = 64 * 1024;
+
+  struct block_entry
+  {
+    uint64_t offset_;
+    uint64_t size_;
+  };
+
+  // The arena resolves StringRef fields, see encode_block().
+  static inline void write(std::filesystem::path const& path, descriptor const& desc, record_span<record> records,
+                           size_t block_records = k_block_records, string_arena const* arena = nullptr);
+
+  static inline encoded_table open(std::filesystem::path const& path);
+
+  descriptor const& desc() const { return desc_; }
+  std::filesystem::path const& path() const { return path_; }
+  encoded_header const& header() const { return *reinterpret_cast<encoded_header const*>(region_.get_address()); }
+
+  size_t size() const { return header().count_; }
+  size_t size_bytes() const { return region_.get_size(); }
+  size_t block_count() const { return header().block_count_; }
+  size_t block_size(size_t b) const { BOOST_ASSERT(b < block_count()); return std::min(header().block_records_, size() - b * header().block_records_); }
+
+  // Ordinal of the first record of block b.
+  size_t block_first(size_t b) const { return b * header().block_records_; }
+
+  inline std::span<mem_t const> block(size_t b) const;
+
+  // Decode block b into out, which must hold block_size(b) records, see decode_block().
+  inline void decode(size_t b, mem_t* out, string_arena* arena = nullptr) const;
+
+  // Decode the whole table, appending out of line StringRef strings to arena.
+  inline record_buffer decode(string_arena* arena = nullptr) const;
+
+  // Call f(first, records) for each decoded block from TBB workers, records are only valid during the call. If f also
+  // takes a string_arena const& it is passed the strings of the StringRef fields of the block, otherwise these must
+  // all be inline.
+  template <class F>
+  inline void scan(F&& f) const;
+
+private:
+  inline encoded_table(std::filesystem::path const& path);
+
+  std::filesystem::path path_;
+  boost::interprocess::file_mapping mapping_;
+  boost::interprocess::mapped_region region_;
+  descriptor desc_;
+};
+
+std::string encode_block(descriptor const& desc, record_span<record> records, string_arena const* arena)
+{
+  auto const n = records.size();
+  auto const stride = records.stride();
+
+  std::string out;
+  encoding::put(out, (uint64_t)n);
+  std::vector<int64_t> values(n);
+  for (auto const& f : desc.fields())
+  {
+    auto const base = records.data() + f.offset();
+    if (encoding::integer_column(f.type()))
+    {
+      if (encoding::signed_column(f.type())) {
+        encoding::read_integers<true>(f, base, stride, n, values.data());
+      }
+      else {
+        encoding::read_integers<false>(f, base, stride, n, values.data());
+      }
+      encoding::put_integers(out, values.data(), n);
+    }
+    else if (encoding::string_column(f.type()))
+    {
+      // Codes in order of first appearance.
+      std::unordered_map<string_t, int64_t> codes;
+      std::vector<string_t> strings;
+      for (size_t i = 0; i < n; ++i) {
+        auto const s = encoding::read_string(f, records[i].cmem(), arena);
+        auto const [it, added] = codes.try_emplace(s, (int64_t)strings.size());
+        if (added) {
+          strings.push_back(s);
+        }
+        values[i] = it->second;
+      }
+      encoding::put(out, encoding::codec::dict);
+      encoding::put(out, (uint64_t)strings.size());
+      for (auto const s : strings) {
+        encoding::put(out, (uint32_t)s.size());
+        out.append(s);
+      }
+      encoding::put_integers(out, values.data(), n);
+    }
+    else
+    {
+      encoding::put(out, encoding::codec::plain);
+      auto const size = out.size();
+      out.resize(size + n * f.size());
+      kernels::transpose<false>(const_cast<mem_t*>(base), reinterpret_cast<mem_t*>(out.data() + size), f.size(), stride, n);
+    }
+  }
+  return out;
+}
+
+size_t decode_block(descriptor const& desc, std::span<mem_t const> bytes, mem_t* out, size_t capacity, string_arena* arena)
+{
+  encoding::cursor in{bytes};
+  auto const n = in.get<uint64_t>();
+  if (n > capacity) {
+    throw std::runtime_error("corrupt encoded block");
+  }
+
+  // Read the column headers, then decode every column a chunk of rows at a time so the rows being written stay in
+  // cache rather than each column making a pass over the whole block.
+  struct column
+  {
+    encoding::integer_reader integers_;     // Values, or codes into strings_.
+    std::vector<string_t> strings_;
+    std::vector<string_ref> refs_;          // Of strings_, for a StringRef field.
+    mem_t const* plain_ = nullptr;
+  };
+  std::vector<column> columns(desc.fields().size());
+  for (auto const& f : desc.fields())
+  {
+    auto& c = columns[f.index()];
+    if (encoding::integer_column(f.type())) {
+      c.integers_ = encoding::integer_reader{in, n};
+    }
+    else if (encoding::string_column(f.type()))
+    {
+      if (in.get<encoding::codec>() != encoding::codec::dict) {
+        throw std::runtime_error("corrupt encoded block");
+      }
+      auto const count = in.get<uint64_t>();
+      if (count > n) {
+        throw std::runtime_error("corrupt encoded block");
+      }
+      c.strings_.resize(count);
+      for (auto& s : c.strings_) {
+        auto const chars = in.take(in.get<uint32_t>());
+        s = { reinterpret_cast<char const*>(chars.data()), chars.size() };
+      }
+      if (f.type() == types::StringRef) {
+        // Each distinct string is appended to the arena once.
+        for (auto const s : c.strings_) {
+          if (!arena && s.size() > string_ref::k_inline) {
+            throw std::runtime_error(fmt::format("field '{}': string of length {} needs a string_arena", f.name(), s.size()));
+          }
+          c.refs_.push_back(arena ? arena->append(s) : string_arena{}.append(s));
+        }
+      }
+      c.integers_ = encoding::integer_reader{in, n};
+    }
+    else
+    {
+      if (in.get<encoding::codec>() != encoding::codec::plain) {
+        throw std::runtime_error("corrupt encoded block");
+      }
+      c.plain_ = in.take(n * f.size()).data();
+    }
+  }
+
+  auto const stride = desc.mem_size();
+  auto const chunk = std::max<size_t>(64, column_table::k_block_bytes / stride / 64 * 64);
+  std::vector<int64_t> values(std::min<size_t>(chunk, n));
+  for (size_t first = 0; first < n; first += chunk)
+  {
+    auto const m = std::min(chunk, n - first);
+    auto const rows = out + first * stride;
+    std::memset(rows, 0, m * stride);
+    for (auto const& f : desc.fields())
+    {
+      auto& c = columns[f.index()];
+      if (c.plain_) {
+        kernels::transpose<true>(rows + f.offset(), const_cast<mem_t*>(c.plain_ + first * f.size()), f.size(), stride, m);
+        continue;
+      }
+      c.integers_.read(m, values.data());
+      if (!encoding::string_column(f.type())) {
+        encoding::write_integers(f, values.data(), m, rows + f.offset(), stride);
+        continue;
+      }
+      for (size_t i = 0; i < m; ++i) {
+        if ((uint64_t)values[i] >= c.strings_.size()) {
+          throw std::runtime_error("corrupt encoded block");
+        }
+        if (f.type() == types::StringRef) {
+          f.write<types::StringRef>(rows + i * stride, c.refs_[values[i]]);
+        }
+        else {
+          encoding::write_string(f, rows + i * stride, c.strings_[values[i]]);
+        }
+      }
+    }
+  }
+  return n;
+}
+
+void encoded_table::write(std::filesystem::path const& path, descriptor const& desc, record_span<record> records,
+                          size_t block_records, string_arena const* arena)
+{
+  BOOST_ASSERT(block_records > 0);
+  auto const block_count = (records.size() + block_records - 1) / block_records;
+  std::vector<std::string> blocks(block_count);
+  tbb::parallel_for(size_t{0}, block_count, [&](size_t b) {
+    auto const first = b * block_records;
+    blocks[b] = encode_block(desc, records.subspan(first, std::min(block_records, records.size() - first)), arena);
+  });
+
+  auto const serialized = write_descriptor(desc);
+  std::vector<block_entry> index;
+  auto offset = sizeof(encoded_header) + serialized.size();
+  for (auto const& b : blocks) {
+    index.push_back({ offset, b.size() });
+    offset += b.size();
+  }
+
+  encoded_header const header {
+    .magic_           = encoded_header::k_magic,
+    .version_         = encoded_header::k_version,
+    .header_size_     = sizeof(encoded_header),
+    .descriptor_size_ = serialized.size(),
+    .count_           = records.size(),
+    .block_records_   = block_records,
+    .block_count_     = block_count,
+    .index_offset_    = offset,
+    .reserved_        = 0
+  };
+
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  if (!file) {
+    throw std::runtime_error(fmt::format("failed to create encoded table file '{}'", path.string()));
+  }
+  file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  file.write(serialized.data(), serialized.size());
+  for (auto const& b : blocks) {
+    file.write(b.data(), b.size());
+  }
+  file.write(reinterpret_cast<char const*>(index.data()), index.size() * sizeof(block_entry));
+  if (!file) {
+    throw std::runtime_error(fmt::format("failed to write encoded table file '{}'", path.string()));
+  }
+}
+
+encoded_table encoded_table::open(std::filesystem::path const& path)
+{
+  if (std::filesystem::file_size(path) < sizeof(encoded_header)) {
+    throw std::runtime_error(fmt::format("'{}' is too small to be an encoded table file", path.string()));
+  }
+  return encoded_table{path};
+}
+
+encoded_table::encoded_table(std::filesystem::path const& path)
+  : path_{path},
+    mapping_{path.string().c_str(), boost::interprocess::read_only},
+    region_{mapping_, boost::interprocess::read_only},
+    desc_{[&] {
+      auto const base = static_cast<mem_t const*>(region_.get_address());
+      auto const size = region_.get_size();
+
+      encoded_header header;
+      std::memcpy(&header, base, sizeof(header));
+      if (header.magic_ != encoded_header::k_magic) {
+        throw std::runtime_error(fmt::format("'{}' is not an encoded table file", path.string()));
+      }
+      if (header.version_ != encoded_header::k_version) {
+        throw std::runtime_error(fmt::format("unsupported version {} of encoded table file '{}'", header.version_, path.string()));
+      }
+      if (header.header_size_ != sizeof(encoded_header) || header.header_size_ + header.descriptor_size_ > size) {
+        throw std::runtime_error(fmt::format("corrupt header in encoded table file '{}'", path.string()));
+      }
+      if (header.block_records_ == 0 || header.block_count_ != (header.count_ + header.block_records_ - 1) / header.block_records_ ||
+          header.index_offset_ > size || (size - header.index_offset_) / sizeof(block_entry) < header.block_count_) {
+        throw std::runtime_error(fmt::format("encoded table file '{}' is truncated", path.string()));
+      }
+      return read_descriptor({ base + header.header_size_, header.descriptor_size_ });
+    }()}
+{
+}
+
+std::span<mem_t const> encoded_table::block(size_t b) const
+{
+  BOOST_ASSERT(b < block_count());
+  auto const base = static_cast<mem_t const*>(region_.get_address());
+  block_entry entry;
+  std::memcpy(&entry, base + header().index_offset_ + b * sizeof(block_entry), sizeof(entry));
+  if (entry.offset_ > header().index_offset_ || entry.size_ > header().index_offset_ - entry.offset_) {
+    throw std::runtime_error(fmt::format("corrupt block {} in encoded table file '{}'", b, path_.string()));
+  }
+  return { base + entry.offset_, entry.size_ };
+}
+
+void encoded_table::decode(size_t b, mem_t* out, string_arena* arena) const
+{
+  if (decode_block(desc_, block(b), out, block_size(b), arena) != block_size(b)) {
+    throw std::runtime_error(fmt::format("corrupt block {} in encoded table file '{}'", b, path_.string()));
+  }
+}
+
+record_buffer encoded_table::decode(string_arena* arena) const
+{
+  // Each block appends its strings to its own arena, moved into arena in block order once all are decoded.
+  record_buffer out{desc_, size()};
+  std::vector<string_arena> strings(arena ? block_count() : 0);
+  tbb::parallel_for(size_t{0}, block_count(), [&](size_t b) {
+    decode(b, out.data() + block_first(b) * desc_.mem_size(), arena ? &strings[b] : nullptr);
+  });
+  if (!arena) {
+    return out;
+  }
+
+  std::vector<uint64_t> bases;
+  for (auto const& s : strings) {
+    bases.push_back(arena->append(s));
+  }
+  auto const stride = desc_.mem_size();
+  tbb::parallel_for(size_t{0}, block_count(), [&](size_t b) {
+    if (bases[b] == 0) {
+      return;
+    }
+    auto const rows = out.data() + block_first(b) * stride;
+    for (auto const& f : desc_.fields()) {
+      if (f.type() == types::StringRef) {
+        for (size_t i = 0; i < block_size(b); ++i) {
+          f.write<types::StringRef>(rows + i * stride, string_arena::rebase(f.read<types::StringRef>(rows + i * stride), bases[b]));
+        }
+      }
+    }
+  });
+  return out;
+}
+
+template <class F>
+void encoded_table::scan(F&& f) const
+{
+  constexpr bool with_strings = std::is_invocable_v<F&, size_t, record_span<record>, string_arena const&>;
+  struct local
+  {
+    record_buffer buffer_;
+    string_arena strings_;
+  };
+  tbb::enumerable_thread_specific<local> locals{[&] { return local{record_buffer{desc_, header().block_records_}, {}}; }};
+  tbb::parallel_for(size_t{0}, block_count(), [&](size_t b) {
+    auto& [buffer, strings] = locals.local();
+    strings.clear();
+    decode(b, buffer.data(), with_strings ? &strings : nullptr);
+    record_span<record> const records{buffer.data(), desc_.mem_size(), block_size(b)};
+    if constexpr (with_strings) {
+      f(block_first(b), records, std::as_const(strings));
+    }
+    else {
+      f(block_first(b), records);
+    }
+  });
+}
+
+} // namespace rdf
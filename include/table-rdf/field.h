@@ -46,8 +46,8 @@ struct field
   template <types::type T> void                    write(mem_t* base, types::value_t<T> const value) const;
   template <types::type T> types::value_t<T> const read(mem_t const* base) const;
 
-  auto name() const { return name_; }
-  auto description() const { return description_; }
+  std::string const& name() const { return name_; }
+  std::string const& description() const { return description_; }
   auto type() const { return type_; }
   auto type_name() const { return types::enum_names_type(type_); }
   auto payload() const { return payload_; }
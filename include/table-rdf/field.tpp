@@ -52,6 +52,9 @@ void field::write(mem_t* base, value_t<T> const value) const
   else if constexpr(concepts::timestamp<V>) {
     *offset_ptr<raw_time_t>(base) = value.time_since_epoch().count();
   }
+  else if constexpr(concepts::string_ref<V>) {
+    *offset_ptr<V>(base) = value;
+  }
   else {
     static_assert(util::always_false_v<V>, "unsupported field value type");
   }
@@ -72,6 +75,9 @@ value_t<T> const field::read(mem_t const* base) const
   else if constexpr(concepts::timestamp<V>) {
     return timestamp_t{ timestamp_t::duration{ *offset_ptr<raw_time_t const>(base) } };
   }
+  else if constexpr(concepts::string_ref<V>) {
+    return *offset_ptr<V const>(base);
+  }
   else {
     static_assert(util::always_false_v<V>, "unsupported field value type");
   }
@@ -0,0 +1,564 @@
+#pragma once
+#include "aggregate.h"
+#include "record_buffer.h"
+
+#include <oneapi/tbb.h>
+
+namespace rdf
+{
+
+// One aggregate function of a group_by, reading an input field of each record and writing an output field of each
+// result record. Each group holds a state of size_ bytes (at most max_align_t aligned, trivially copyable) that is
+// set up by init_, updated by add_ for every record of the group, combined across threads by merge_ and finally
+// written to the result record by finish_. The factories cover count / sum / min / max / mean of any field
+// aggregate() accepts; custom functions fill in the members directly.
+struct group_aggregate
+{
+  using init_fn   = void (*)(mem_t* state);
+  using add_fn    = void (*)(group_aggregate const& a, mem_t* state, mem_t const* record);
+  using merge_fn  = void (*)(mem_t* state, mem_t const* other);
+  using finish_fn = void (*)(group_aggregate const& a, mem_t const* state, mem_t* result);
+
+  field input_;
+  field output_;
+  size_t size_;
+  size_t align_;
+  init_fn init_;
+  add_fn add_;
+  merge_fn merge_;
+  finish_fn finish_;
+
+  // Numeric outputs of any type take the value converted as by static_cast. Min, max and mean of a timestamp
+  // need a Timestamp output. Min and max of an empty group (only possible with custom functions) leave the output 0.
+  static inline group_aggregate count(field const& output);
+  static inline group_aggregate sum(field const& input, field const& output);
+  static inline group_aggregate min(field const& input, field const& output);
+  static inline group_aggregate max(field const& input, field const& output);
+  static inline group_aggregate mean(field const& input, field const& output);
+};
+
+// Hash aggregation of records grouped by the value of a key field (a string type, an integer, a timestamp or a
+// KeyDict code), e.g. the volume per symbol:
+//   group_by volume{trades.fields("Symbol"), rollup, rollup.fields("Symbol"),
+//                   { group_aggregate::sum(trades.fields("Size"), rollup.fields("Volume")),
+//                     group_aggregate::count(rollup.fields("Trades")) }};
+//   record_buffer const out = volume(records);
+// Each TBB worker aggregates into its own hash tables, partitioned by the high bits of the key hash. The partitions
+// are then merged in parallel, partition p of every worker into one table, so neither phase shares a table between
+// threads. The result holds one record per group, in no particular order. String keys are not copied until the
+// result is written, so the records must stay valid for the duration of the call.
+class group_by
+{
+public:
+  static constexpr size_t k_partitions = 64;
+
+  inline group_by(field const& key, descriptor const& result, field const& result_key, std::vector<group_aggregate> aggregates);
+
+  record_buffer operator()(record_span<record> records) const { return dispatch(records, nullptr); }
+  record_buffer operator()(record_span<record> records, selection const& where) const { return dispatch(records, &where); }
+
+  descriptor const& result() const { return result_; }
+
+private:
+  inline record_buffer dispatch(record_span<record> const& records, selection const* where) const;
+
+  template <types::type K>
+  inline record_buffer run(record_span<record> const& records, selection const* where) const;
+
+  field key_;
+  descriptor result_;
+  field result_key_;
+  std::vector<group_aggregate> aggregates_;
+  std::vector<size_t> offsets_;     // Of each aggregate state within a group state.
+  size_t state_size_ = 0;
+};
+
+namespace kernels {
+
+  inline constexpr bool numeric_type(types::type t) { return t >= types::Int8 && t <= types::Float128; }
+  inline constexpr bool integer_key_type(types::type t) { return (t >= types::Int8 && t <= types::Uint64) || t == types::Timestamp || t == types::KeyDict; }
+
+  // Write v to a numeric field of any type, converted as by static_cast.
+  template <class V>
+  inline void write_number(field const& f, mem_t* mem, V v)
+  {
+    using namespace types;
+    switch (f.type())
+    {
+      case Int8:     f.write<Int8>(mem, (int8_t)v);                   break;
+      case Int16:    f.write<Int16>(mem, (int16_t)v);                 break;
+      case Int32:    f.write<Int32>(mem, (int32_t)v);                 break;
+      case Int64:    f.write<Int64>(mem, (int64_t)v);                 break;
+      case Uint8:    f.write<Uint8>(mem, (uint8_t)v);                 break;
+      case Uint16:   f.write<Uint16>(mem, (uint16_t)v);               break;
+      case Uint32:   f.write<Uint32>(mem, (uint32_t)v);               break;
+      case Uint64:   f.write<Uint64>(mem, (uint64_t)v);               break;
+      case Float16:  f.write<Float16>(mem, (std::float16_t)v);        break;
+      case Float32:  f.write<Float32>(mem, (std::float32_t)v);        break;
+      case Float64:  f.write<Float64>(mem, (std::float64_t)v);        break;
+      case Float128: f.write<Float128>(mem, (std::float128_t)v);      break;
+      default:
+        BOOST_ASSERT_MSG(false, "not a numeric field");
+    }
+  }
+
+  // Call f.template operator()<T>() with the type T of input, which must be one aggregate() accepts.
+  template <class F>
+  inline group_aggregate visit_aggregatable(field const& input, F&& f)
+  {
+    using namespace types;
+    switch (input.type())
+    {
+      case Int8:      return f.template operator()<Int8>();
+      case Int16:     return f.template operator()<Int16>();
+      case Int32:     return f.template operator()<Int32>();
+      case Int64:     return f.template operator()<Int64>();
+      case Uint8:     return f.template operator()<Uint8>();
+      case Uint16:    return f.template operator()<Uint16>();
+      case Uint32:    return f.template operator()<Uint32>();
+      case Uint64:    return f.template operator()<Uint64>();
+      case Float16:   return f.template operator()<Float16>();
+      case Float32:   return f.template operator()<Float32>();
+      case Float64:   return f.template operator()<Float64>();
+      case Float128:  return f.template operator()<Float128>();
+      case Timestamp: return f.template operator()<Timestamp>();
+      default:
+        throw std::runtime_error(fmt::format("cannot aggregate field '{}' of type '{}'", input.name(), input.type_name()));
+    }
+  }
+
+  enum class group_fn { sum, min, max, mean };
+
+  inline constexpr char const* k_group_fn_names[] = { "sum", "min", "max", "mean" };
+
+  // Per group state of the built-in functions, a scalar aggregates<T> without the lanes of add_block() since there
+  // is one per group. Floating point sums are compensated, integer sums exact in 128 bits.
+  template <types::type T>
+  struct group_state
+  {
+    using V = scan_value_t<T>;
+    using A = std::conditional_t<T == types::Float128, std::float128_t, double>;
+    static constexpr bool k_floating = aggregates<T>::k_floating;
+    static constexpr bool k_signed   = aggregates<T>::k_signed;
+    static constexpr V k_min_identity = std::numeric_limits<V>::has_infinity ? std::numeric_limits<V>::infinity() : std::numeric_limits<V>::max();
+    static constexpr V k_max_identity = std::numeric_limits<V>::has_infinity ? -std::numeric_limits<V>::infinity() : std::numeric_limits<V>::lowest();
+
+    uint64_t count_ = 0;
+    V min_ = k_min_identity;
+    V max_ = k_max_identity;
+    std::conditional_t<k_floating, std::array<A, 2>, wide_sum> sum_{};     // Sum and compensation for floating point.
+
+    template <group_fn Fn>
+    void add(V x) {
+      ++count_;
+      if constexpr (Fn == group_fn::min) {
+        min_ = x < min_ ? x : min_;
+      }
+      else if constexpr (Fn == group_fn::max) {
+        max_ = x > max_ ? x : max_;
+      }
+      else if constexpr (k_floating) {
+        compensated_sum<A>::add(sum_[0], sum_[1], (A)x);
+      }
+      else if constexpr (k_signed) {
+        sum_.add((int64_t)x);
+      }
+      else {
+        sum_.add((uint64_t)x);
+      }
+    }
+
+    void merge(group_state const& other) {
+      count_ += other.count_;
+      min_ = other.min_ < min_ ? other.min_ : min_;
+      max_ = other.max_ > max_ ? other.max_ : max_;
+      if constexpr (k_floating) {
+        compensated_sum<A>::add(sum_[0], sum_[1], other.sum_[0]);
+        sum_[1] += other.sum_[1];
+      }
+      else {
+        sum_.add(other.sum_);
+      }
+    }
+
+    auto sum() const {
+      if constexpr (k_floating) {
+        return sum_[0] + sum_[1];
+      }
+      else {
+        if (k_signed ? !sum_.fits_int64() : !sum_.fits_uint64()) {
+          throw std::runtime_error(fmt::format("sum of {} values of type '{}' overflows", count_, types::enum_names_type(T)));
+        }
+        return std::conditional_t<k_signed, int64_t, uint64_t>(sum_.lo_);
+      }
+    }
+
+    auto mean() const {
+      if constexpr (k_floating) {
+        return sum() / (A)count_;
+      }
+      else {
+        return (double)(sum_.value() / count_);
+      }
+    }
+  };
+
+  // Built-in aggregate functions, all keeping a group_state<T>.
+  template <types::type T, group_fn Fn>
+  inline group_aggregate make_group_aggregate(field const& input, field const& output)
+  {
+    using state_t = group_state<T>;
+    static_assert(std::is_trivially_copyable_v<state_t>);
+    static_assert(alignof(state_t) <= alignof(std::max_align_t));
+
+    if (T == types::Timestamp && Fn == group_fn::sum) {
+      throw std::runtime_error(fmt::format("cannot sum field '{}' of type '{}'", input.name(), input.type_name()));
+    }
+    if (T == types::Timestamp ? output.type() != types::Timestamp : !numeric_type(output.type())) {
+      throw std::runtime_error(fmt::format("cannot write {} of field '{}' of type '{}' to field '{}' of type '{}'",
+                                           k_group_fn_names[(int)Fn], input.name(), input.type_name(),
+                                           output.name(), output.type_name()));
+    }
+
+    return group_aggregate{
+      input, output, sizeof(state_t), alignof(state_t),
+      [](mem_t* s) { new (s) state_t{}; },
+      [](group_aggregate const& a, mem_t* s, mem_t const* r) {
+        reinterpret_cast<state_t*>(s)->template add<Fn>(scan_value<T>(a.input_.read<T>(r)));
+      },
+      [](mem_t* s, mem_t const* other) { reinterpret_cast<state_t*>(s)->merge(*reinterpret_cast<state_t const*>(other)); },
+      [](group_aggregate const& a, mem_t const* s, mem_t* out)
+      {
+        auto const& st = *reinterpret_cast<state_t const*>(s);
+        if constexpr (T == types::Timestamp) {
+          if constexpr (Fn == group_fn::mean) {
+            a.output_.write<types::Timestamp>(out, util::make_timestamp((raw_time_t)std::llround(st.sum_.value() / st.count_)));
+          }
+          else if constexpr (Fn != group_fn::sum) {
+            a.output_.write<types::Timestamp>(out, util::make_timestamp(Fn == group_fn::min ? st.min_ : st.max_));
+          }
+        }
+        else if constexpr (Fn == group_fn::sum) {
+          write_number(a.output_, out, st.sum());
+        }
+        else if constexpr (Fn == group_fn::mean) {
+          write_number(a.output_, out, st.mean());
+        }
+        else {
+          write_number(a.output_, out, Fn == group_fn::min ? st.min_ : st.max_);
+        }
+      }
+    };
+  }
+
+  // Key bits and hash of a group.
+  template <class K>
+  inline uint64_t group_hash(K const& key)
+  {
+    if constexpr (std::is_same_v<K, string_t>) {
+      return std::hash<string_t>{}(key) | 1;
+    }
+    else {
+      // Integer keys are often sequential, so mix every bit into the high bits used for partitions and slots.
+      auto h = key;
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdull;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ull;
+      h ^= h >> 33;
+      return h | 1;
+    }
+  }
+
+  // Open addressing table from a group key (a string or integer bits) to the state of that group. Groups are numbered
+  // in insertion order and their hashes, keys and states stored contiguously in that order, so the slots are only
+  // 16 bytes (a hash and a group number) and iterating, merging or rehashing groups reads memory sequentially.
+  template <class K>
+  class group_table
+  {
+  public:
+    explicit group_table(size_t state_size)
+      : state_size_{state_size}
+    {
+      rehash(16);
+    }
+
+    size_t size() const { return keys_.size(); }
+    uint64_t hash(size_t group) const { return hashes_[group]; }
+    K const& key(size_t group) const { return keys_[group]; }
+    mem_t*       state(size_t group)       { return reinterpret_cast<mem_t*>(states_.data()) + group * state_size_; }
+    mem_t const* state(size_t group) const { return reinterpret_cast<mem_t const*>(states_.data()) + group * state_size_; }
+
+    // State of the group of key, a new group's state is set up by init(state).
+    template <class Init>
+    mem_t* find_or_insert(uint64_t hash, K const& key, Init&& init)
+    {
+      auto const mask = slots_.size() - 1;
+      for (auto i = home(hash);; i = (i + 1) & mask)
+      {
+        auto& s = slots_[i];
+        if (s.hash_ == hash && keys_[s.group_] == key) {
+          return state(s.group_);
+        }
+        if (s.hash_ == 0)
+        {
+          auto const group = keys_.size();
+          s = slot{ hash, group };
+          hashes_.push_back(hash);
+          keys_.push_back(key);
+          states_.resize((keys_.size() * state_size_ + sizeof(chunk) - 1) / sizeof(chunk));
+          init(state(group));
+
+          // Load factor of at most 1/2.
+          if (keys_.size() * 2 > slots_.size()) {
+            rehash(slots_.size() * 2);
+          }
+          return state(group);
+        }
+      }
+    }
+
+  private:
+    struct slot
+    {
+      uint64_t hash_;     // 0 when empty.
+      size_t group_;
+    };
+
+    // Group states are max_align_t aligned.
+    struct chunk { alignas(std::max_align_t) mem_t bytes_[alignof(std::max_align_t)]; };
+
+    size_t home(uint64_t h) const { return (size_t)((h * 0x9e3779b97f4a7c15ull) >> shift_); }
+
+    void rehash(size_t count)
+    {
+      slots_.assign(count, slot{ 0, 0 });
+      shift_ = 64 - std::countr_zero(count);
+      for (size_t g = 0; g < hashes_.size(); ++g) {
+        auto i = home(hashes_[g]);
+        while (slots_[i].hash_) {
+          i = (i + 1) & (count - 1);
+        }
+        slots_[i] = slot{ hashes_[g], g };
+      }
+    }
+
+    size_t state_size_;
+    std::vector<slot> slots_;
+    std::vector<uint64_t> hashes_;
+    std::vector<K> keys_;
+    std::vector<chunk> states_;
+    unsigned shift_ = 64;
+  };
+
+} // namespace kernels
+
+group_aggregate group_aggregate::count(field const& output)
+{
+  if (!kernels::numeric_type(output.type())) {
+    throw std::runtime_error(fmt::format("cannot write count to field '{}' of type '{}'", output.name(), output.type_name()));
+  }
+  return group_aggregate{
+    output, output, sizeof(uint64_t), alignof(uint64_t),
+    [](mem_t* s) { *reinterpret_cast<uint64_t*>(s) = 0; },
+    [](group_aggregate const&, mem_t* s, mem_t const*) { ++*reinterpret_cast<uint64_t*>(s); },
+    [](mem_t* s, mem_t const* other) { *reinterpret_cast<uint64_t*>(s) += *reinterpret_cast<uint64_t const*>(other); },
+    [](group_aggregate const& a, mem_t const* s, mem_t* out) { kernels::write_number(a.output_, out, *reinterpret_cast<uint64_t const*>(s)); }
+  };
+}
+
+group_aggregate group_aggregate::sum(field const& input, field const& output)
+{
+  return kernels::visit_aggregatable(input, [&]<types::type T>() { return kernels::make_group_aggregate<T, kernels::group_fn::sum>(input, output); });
+}
+
+group_aggregate group_aggregate::min(field const& input, field const& output)
+{
+  return kernels::visit_aggregatable(input, [&]<types::type T>() { return kernels::make_group_aggregate<T, kernels::group_fn::min>(input, output); });
+}
+
+group_aggregate group_aggregate::max(field const& input, field const& output)
+{
+  return kernels::visit_aggregatable(input, [&]<types::type T>() { return kernels::make_group_aggregate<T, kernels::group_fn::max>(input, output); });
+}
+
+group_aggregate group_aggregate::mean(field const& input, field const& output)
+{
+  return kernels::visit_aggregatable(input, [&]<types::type T>() { return kernels::make_group_aggregate<T, kernels::group_fn::mean>(input, output); });
+}
+
+group_by::group_by(field const& key, descriptor const& result, field const& result_key, std::vector<group_aggregate> aggregates)
+  : key_{key},
+    result_{result},
+    result_key_{result_key},
+    aggregates_{std::move(aggregates)}
+{
+  auto const key_error = [&] {
+    return std::runtime_error(fmt::format("cannot group field '{}' of type '{}' into field '{}' of type '{}'",
+                                          key.name(), key.type_name(), result_key.name(), result_key.type_name()));
+  };
+  if (types::string_type(key.type()) ? !types::string_type(result_key.type()) :
+      !kernels::integer_key_type(key.type()) || !kernels::integer_key_type(result_key.type()) ||
+      (key.type() == types::Timestamp) != (result_key.type() == types::Timestamp) ||
+      (key.type() == types::KeyDict) != (result_key.type() == types::KeyDict)) {
+    throw key_error();
+  }
+
+  for (auto const& a : aggregates_)
+  {
+    BOOST_ASSERT(a.align_ <= alignof(std::max_align_t));
+    BOOST_ASSERT(a.output_.offset() + a.output_.size() <= result.mem_size());
+    state_size_ = boost::alignment::align_up(state_size_, a.align_);
+    offsets_.push_back(state_size_);
+    state_size_ += a.size_;
+  }
+  state_size_ = boost::alignment::align_up(std::max<size_t>(state_size_, 1), alignof(std::max_align_t));
+}
+
+record_buffer group_by::dispatch(record_span<record> const& records, selection const* where) const
+{
+  BOOST_ASSERT(!where || where->size() == records.size());
+
+  using namespace types;
+  switch (key_.type())
+  {
+    case Key8:      return run<Key8>(records, where);
+    case Key16:     return run<Key16>(records, where);
+    case String8:   return run<String8>(records, where);
+    case String16:  return run<String16>(records, where);
+    case Int8:      return run<Int8>(records, where);
+    case Int16:     return run<Int16>(records, where);
+    case Int32:     return run<Int32>(records, where);
+    case Int64:     return run<Int64>(records, where);
+    case Uint8:     return run<Uint8>(records, where);
+    case Uint16:    return run<Uint16>(records, where);
+    case Uint32:    return run<Uint32>(records, where);
+    case Uint64:    return run<Uint64>(records, where);
+    case Timestamp: return run<Timestamp>(records, where);
+    case KeyDict:   return run<KeyDict>(records, where);
+    default:
+      BOOST_ASSERT_MSG(false, "invalid key field type");
+      return record_buffer{result_, 0};
+  }
+}
+
+template <types::type K>
+record_buffer group_by::run(record_span<record> const& records, selection const* where) const
+{
+  // Strings are grouped by value, integers, timestamps and dictionary codes by their (sign extended) bits.
+  using key_t = std::conditional_t<types::string_type(K), string_t, uint64_t>;
+  using table = kernels::group_table<key_t>;
+
+  auto const read_key = [&](mem_t const* mem) -> key_t {
+    if constexpr (K == types::Timestamp) {
+      return (uint64_t)key_.read<K>(mem).time_since_epoch().count();
+    }
+    else if constexpr (types::string_type(K)) {
+      return key_.read<K>(mem);
+    }
+    else {
+      return (uint64_t)(int64_t)key_.read<K>(mem);
+    }
+  };
+
+  auto const init = [&](mem_t* state) {
+    for (size_t a = 0; a < aggregates_.size(); ++a) {
+      aggregates_[a].init_(state + offsets_[a]);
+    }
+  };
+
+  // Partition of a hash from its top bits, the slots within a partition are placed by a multiplicative hash of all bits.
+  auto const partition = [](uint64_t h) { return (size_t)(h >> 58) % k_partitions; };
+
+  // Aggregate into per-thread partitioned tables.
+  tbb::enumerable_thread_specific<std::vector<table>> locals{[&] { return std::vector<table>(k_partitions, table{state_size_}); }};
+  tbb::parallel_for(records.with_grain(4096), [&](record_span<record> const& range)
+  {
+    auto& tables = locals.local();
+    auto const first = (size_t)((range.data() - records.data()) / records.stride());
+    for (size_t i = 0; i < range.size(); ++i)
+    {
+      if (where && !where->test(first + i)) {
+        continue;
+      }
+      auto const mem = range[i].cmem();
+      auto const key = read_key(mem);
+      auto const h = kernels::group_hash(key);
+      auto const state = tables[partition(h)].find_or_insert(h, key, init);
+      for (size_t a = 0; a < aggregates_.size(); ++a) {
+        aggregates_[a].add_(aggregates_[a], state + offsets_[a], mem);
+      }
+    }
+  });
+
+  // Merge partition p of every thread into the first thread's partition p, each partition in parallel.
+  std::vector<table> merged;
+  auto base = locals.begin();
+  if (base == locals.end()) {
+    merged.assign(k_partitions, table{state_size_});
+  }
+  else {
+    merged = std::move(*base);
+    tbb::parallel_for(size_t{0}, k_partitions, [&](size_t p)
+    {
+      for (auto tables = std::next(base); tables != locals.end(); ++tables)
+      {
+        auto const& other = (*tables)[p];
+        for (size_t g = 0; g < other.size(); ++g)
+        {
+          auto const state = merged[p].find_or_insert(other.hash(g), other.key(g), init);
+          for (size_t a = 0; a < aggregates_.size(); ++a) {
+            aggregates_[a].merge_(state + offsets_[a], other.state(g) + offsets_[a]);
+          }
+        }
+      }
+    });
+  }
+
+  // Write one result record per group.
+  std::vector<size_t> firsts(k_partitions + 1, 0);
+  for (size_t p = 0; p < k_partitions; ++p) {
+    firsts[p + 1] = firsts[p] + merged[p].size();
+  }
+
+  record_buffer out{result_, firsts.back()};
+  tbb::parallel_for(size_t{0}, k_partitions, [&](size_t p)
+  {
+    for (size_t g = 0; g < merged[p].size(); ++g)
+    {
+      auto const mem = out[firsts[p] + g];
+      auto const& key = merged[p].key(g);
+      if constexpr (types::string_type(K))
+      {
+        switch (result_key_.type()) {
+          case types::Key8:     result_key_.write<types::Key8>(mem, key);     break;
+          case types::Key16:    result_key_.write<types::Key16>(mem, key);    break;
+          case types::String8:  result_key_.write<types::String8>(mem, key);  break;
+          case types::String16: result_key_.write<types::String16>(mem, key); break;
+          default: break;
+        }
+      }
+      else if constexpr (K == types::Timestamp) {
+        result_key_.write<types::Timestamp>(mem, util::make_timestamp((raw_time_t)key));
+      }
+      else if constexpr (K == types::KeyDict) {
+        result_key_.write<types::KeyDict>(mem, (key_code_t)key);
+      }
+      else if constexpr (std::is_signed_v<types::value_t<K>>) {
+        kernels::write_number(result_key_, mem, (int64_t)key);
+      }
+      else {
+        kernels::write_number(result_key_, mem, key);
+      }
+
+      auto const state = merged[p].state(g);
+      for (size_t a = 0; a < aggregates_.size(); ++a) {
+        aggregates_[a].finish_(aggregates_[a], state + offsets_[a], mem);
+      }
+    }
+  });
+
+  return out;
+}
+
+} // namespace rdf
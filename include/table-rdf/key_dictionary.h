@@ -0,0 +1,138 @@
+#pragma once
+#include "record_span.h"
+
+#include <oneapi/tbb/concurrent_unordered_map.h>
+#include <oneapi/tbb/concurrent_vector.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace rdf
+{
+
+// Dictionary of the distinct strings of KeyDict fields. A record stores a 4 byte key_code_t in place of the string,
+// e.g. a Key16 symbol with a 254 byte payload becomes 4 bytes, and equality, scans and group_by work on the codes.
+// Codes are dense, 0 for the first key encoded, and never change, so a dictionary may be shared by many tables.
+// Keys are stored once in a concurrent_vector whose elements never move. decode() and find() are lock free and safe
+// alongside encode(), which takes a mutex only to add a new key.
+class key_dictionary
+{
+public:
+  static constexpr key_code_t k_null_code = key_code_t(-1);
+
+  key_dictionary() = default;
+
+  // Keys are given codes in order, and must be distinct.
+  inline explicit key_dictionary(std::span<std::string const> keys);
+
+  // The map holds views of the stored keys, so a dictionary is neither copied nor moved.
+  key_dictionary(key_dictionary const&) = delete;
+  key_dictionary& operator=(key_dictionary const&) = delete;
+
+  // Code of key, adding it if new. Safe to call concurrently.
+  inline key_code_t encode(string_t key);
+
+  // Code of key or k_null_code.
+  inline key_code_t find(string_t key) const;
+
+  // Key of a code returned by encode() or find().
+  string_t decode(key_code_t code) const { BOOST_ASSERT(code < size()); return keys_[code]; }
+
+  // Keys are only published once fully added, so any code below size() decodes.
+  size_t size() const { return size_.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+
+  // Field access, f must be a KeyDict field.
+  void write(field const& f, mem_t* mem, string_t key) { f.write<types::KeyDict>(mem, encode(key)); }
+  string_t read(field const& f, mem_t const* mem) const { return decode(f.read<types::KeyDict>(mem)); }
+
+private:
+  tbb::concurrent_vector<std::string> keys_;
+  tbb::concurrent_unordered_map<string_t, key_code_t> codes_;     // Views of keys_.
+  std::atomic<size_t> size_ = 0;
+  std::mutex mutex_;
+};
+
+// Binary dictionary encoding: the key count then each key's length and bytes, in code order.
+inline std::string    write_dictionary(key_dictionary const& d);
+inline key_dictionary read_dictionary(std::span<mem_t const> bytes);
+
+key_dictionary::key_dictionary(std::span<std::string const> keys)
+{
+  for (auto const& key : keys) {
+    if (auto const code = size(); encode(key) != code) {
+      throw std::runtime_error(fmt::format("duplicate dictionary key '{}'", key));
+    }
+  }
+}
+
+key_code_t key_dictionary::encode(string_t key)
+{
+  if (auto const code = find(key); code != k_null_code) {
+    return code;
+  }
+
+  std::lock_guard lock{mutex_};
+  if (auto const code = find(key); code != k_null_code) {     // Added by another thread.
+    return code;
+  }
+  auto const code = keys_.size();
+  if (code >= k_null_code) {
+    throw std::runtime_error("key dictionary is full");
+  }
+  auto const& stored = *keys_.emplace_back(key);
+  size_.store(code + 1, std::memory_order_release);     // Before the code can be found.
+  codes_.emplace(string_t{stored}, (key_code_t)code);
+  return (key_code_t)code;
+}
+
+key_code_t key_dictionary::find(string_t key) const
+{
+  auto const it = codes_.find(key);
+  return it == codes_.end() ? k_null_code : it->second;
+}
+
+std::string write_dictionary(key_dictionary const& d)
+{
+  std::string out;
+  auto const put = [&out](uint64_t v) { out.append(reinterpret_cast<char const*>(&v), sizeof(v)); };
+
+  auto const count = d.size();
+  put(count);
+  for (size_t code = 0; code < count; ++code) {
+    auto const key = d.decode((key_code_t)code);
+    put(key.size());
+    out.append(key);
+  }
+  return out;
+}
+
+key_dictionary read_dictionary(std::span<mem_t const> bytes)
+{
+  auto const get = [&bytes](size_t n) {
+    if (bytes.size() < n) {
+      throw std::runtime_error("truncated dictionary");
+    }
+    auto const s = bytes.first(n);
+    bytes = bytes.subspan(n);
+    return s;
+  };
+  auto const get_u64 = [&]() {
+    uint64_t v;
+    std::memcpy(&v, get(sizeof(v)).data(), sizeof(v));
+    return v;
+  };
+
+  auto const count = get_u64();
+  if (count > bytes.size() / sizeof(uint64_t)) {
+    throw std::runtime_error("truncated dictionary");
+  }
+  std::vector<std::string> keys(count);
+  for (auto& key : keys) {
+    auto const s = get(get_u64());
+    key.assign(reinterpret_cast<char const*>(s.data()), s.size());
+  }
+  return key_dictionary{keys};
+}
+
+} // namespace rdf
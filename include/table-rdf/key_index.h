@@ -0,0 +1,188 @@
+#pragma once
+#include "record_span.h"
+
+#include <oneapi/tbb.h>
+
+#include <bit>
+
+namespace rdf
+{
+
+// Hash index from the value of a key field (Key8 / Key16, or any string field) to the ordinal of the latest record
+// holding that key, e.g. the current quote for a symbol.
+// Slots are 16 bytes, a key hash and an ordinal, in one flat open addressing table with linear probing, so a lookup
+// normally touches a single cache line of the index and then the record itself to confirm the key. Key strings are
+// never copied into the index, which is why find() and update() take the records the index was built from.
+// The table grows with the distinct keys, not the records. build() indexes ranges of records into per thread tables
+// with TBB and merges them, update() indexes records appended since the last build() or update().
+class key_index
+{
+public:
+  static constexpr size_t k_npos = size_t(-1);
+
+  inline explicit key_index(field const& key);
+
+  // Index records [0, records.size()), replacing any previous contents.
+  inline void build(record_span<record> records);
+
+  // Index records [indexed(), records.size()).
+  inline void update(record_span<record> records);
+
+  // Ordinal of the latest record with the given key, or k_npos.
+  inline size_t find(string_t key, record_span<record> records) const;
+
+  size_t size() const { return keys_; }            // Distinct keys.
+  size_t indexed() const { return indexed_; }       // Records indexed.
+  size_t slot_count() const { return slots_.size(); }
+
+private:
+  struct slot
+  {
+    uint64_t hash_;       // 0 when empty.
+    uint64_t ordinal_;    // Ordinal + 1 of the latest record with the key, meaningless while hash_ is 0.
+  };
+
+  static uint64_t hash(string_t key) { return std::hash<string_t>{}(key) | 1; }   // Never 0.
+  size_t home(uint64_t h) const { return (size_t)((h * 0x9e3779b97f4a7c15ull) >> shift_); }
+
+  inline string_t key(mem_t const* mem) const;
+
+  // Insert or raise the ordinal of the slot for key, growing the table for a new key. Returns true if the key was new.
+  inline bool insert(uint64_t h, size_t ordinal, record_span<record> const& records);
+
+  // Add the keys of other, an index of other records of the same span, keeping the latest ordinal of each.
+  inline void merge(key_index const& other, record_span<record> const& records);
+
+  inline void resize(size_t keys);
+
+  field key_;
+  std::vector<slot> slots_;
+  unsigned shift_ = 64;
+  size_t keys_ = 0;
+  size_t indexed_ = 0;
+};
+
+key_index::key_index(field const& key)
+  : key_{key}
+{
+  if (!types::string_type(key.type())) {
+    throw std::runtime_error(fmt::format("cannot index field '{}' of type '{}'", key.name(), key.type_name()));
+  }
+  resize(0);
+}
+
+string_t key_index::key(mem_t const* mem) const
+{
+  switch (key_.type()) {
+    case types::Key8:     return key_.read<types::Key8>(mem);
+    case types::Key16:    return key_.read<types::Key16>(mem);
+    case types::String8:  return key_.read<types::String8>(mem);
+    case types::String16: return key_.read<types::String16>(mem);
+    default:
+      BOOST_ASSERT_MSG(false, "invalid key field type");
+      return {};
+  }
+}
+
+void key_index::resize(size_t keys)
+{
+  // Load factor of at most 1/2.
+  auto const bits = std::max<int>(4, (int)std::bit_width(keys * 2));
+  std::vector<slot> old{std::exchange(slots_, std::vector<slot>(size_t{1} << bits, slot{0, 0}))};
+  shift_ = 64 - bits;
+
+  for (auto const& s : old) {
+    if (s.hash_) {
+      auto i = home(s.hash_);
+      while (slots_[i].hash_) {
+        i = (i + 1) & (slots_.size() - 1);
+      }
+      slots_[i] = s;
+    }
+  }
+}
+
+bool key_index::insert(uint64_t h, size_t ordinal, record_span<record> const& records)
+{
+  if ((keys_ + 1) * 2 > slots_.size()) {
+    resize(keys_ + 1);
+  }
+
+  auto const mask = slots_.size() - 1;
+  for (auto i = home(h);; i = (i + 1) & mask)
+  {
+    auto& s = slots_[i];
+    if (s.hash_ == 0) {
+      s = slot{h, ordinal + 1};
+      ++keys_;
+      return true;
+    }
+
+    // Same hash, confirm the key against the indexed record (a 64-bit hash collision continues probing).
+    if (s.hash_ == h && key(records[s.ordinal_ - 1].cmem()) == key(records[ordinal].cmem())) {
+      s.ordinal_ = std::max<uint64_t>(s.ordinal_, ordinal + 1);     // Keep the latest ordinal.
+      return false;
+    }
+  }
+}
+
+void key_index::merge(key_index const& other, record_span<record> const& records)
+{
+  for (auto const& s : other.slots_) {
+    if (s.hash_) {
+      insert(s.hash_, s.ordinal_ - 1, records);
+    }
+  }
+}
+
+void key_index::build(record_span<record> records)
+{
+  // Each thread indexes its ranges into its own table, so memory follows the distinct keys (per thread) rather than
+  // the record count, and inserts need no atomics.
+  tbb::enumerable_thread_specific<key_index> locals{[this] { return key_index{key_}; }};
+  tbb::parallel_for(records.with_grain(4096), [&](record_span<record> const& range)
+  {
+    auto& local = locals.local();
+    auto const first = (size_t)((range.data() - records.data()) / records.stride());
+    for (size_t i = 0; i < range.size(); ++i) {
+      local.insert(hash(key(range[i].cmem())), first + i, records);
+    }
+  });
+
+  slots_.clear();
+  keys_ = 0;
+  resize(0);
+  for (auto const& local : locals) {
+    if (local.keys_ * 2 > slots_.size()) {
+      resize(local.keys_);
+    }
+    merge(local, records);
+  }
+  indexed_ = records.size();
+}
+
+void key_index::update(record_span<record> records)
+{
+  BOOST_ASSERT(indexed_ <= records.size());
+  for (auto i = indexed_; i < records.size(); ++i) {
+    insert(hash(key(records[i].cmem())), i, records);
+  }
+  indexed_ = records.size();
+}
+
+size_t key_index::find(string_t k, record_span<record> records) const
+{
+  auto const h = hash(k);
+  auto const mask = slots_.size() - 1;
+  for (auto i = home(h); slots_[i].hash_; i = (i + 1) & mask) {
+    if (slots_[i].hash_ == h) {
+      auto const ordinal = slots_[i].ordinal_ - 1;
+      if (key(records[ordinal].cmem()) == k) {
+        return ordinal;
+      }
+    }
+  }
+  return k_npos;
+}
+
+} // namespace rdf
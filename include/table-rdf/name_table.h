@@ -0,0 +1,113 @@
+#pragma once
+#include "common.h"
+#include "util.h"
+#include "field.h"
+
+#include <stdexcept>
+
+namespace rdf {
+
+// A field name together with its hash. Tokens declared constexpr are hashed at compile time, e.g.
+//   static constexpr field_name k_price{"Price"};
+// so a lookup is a multiply, a shift and a single string comparison.
+class field_name
+{
+public:
+  constexpr field_name(std::string_view name)
+    : name_{name},
+      hash_{util::hash(name)}
+  {}
+
+  constexpr field_name(char const* name) : field_name{std::string_view{name}} {}
+  field_name(std::string const& name) : field_name{std::string_view{name}} {}
+
+  constexpr std::string_view view() const { return name_; }
+  constexpr uint64_t hash() const { return hash_; }
+
+private:
+  std::string_view name_;
+  uint64_t hash_;
+};
+
+// A field resolved against a descriptor. Obtain with descriptor::handle(), afterwards descriptor::fields(handle)
+// is a plain index with no hashing, string comparison or allocation.
+class field_handle
+{
+public:
+  constexpr field_handle() = default;
+  constexpr explicit field_handle(field::index_t index) : index_{index} {}
+
+  constexpr field::index_t index() const { return index_; }
+  constexpr bool valid() const { return index_ != field::k_null_index; }
+
+  constexpr bool operator==(field_handle const& other) const = default;
+
+private:
+  field::index_t index_ = field::k_null_index;
+};
+
+// Flat hash table from field names to field indices.
+// Open addressing with linear probing at a load factor of at most 1/2, so the table is linear in the field count and
+// a lookup usually touches one slot, at most a short run of adjacent slots. Slots are addressed with multiply-shift
+// hashing, (hash * k_seed) >> shift, and lookups neither hash nor allocate beyond the field_name.
+class name_table
+{
+public:
+  name_table() = default;
+  inline explicit name_table(std::vector<field> const& fields);
+
+  // Index of the field with the given name or field::k_null_index. fields must be the vector the table was built from.
+  inline field::index_t find(field_name const& name, std::vector<field> const& fields) const;
+
+  size_t slot_count() const { return slots_.size(); }
+
+private:
+  static constexpr uint64_t k_seed = 0x9e3779b97f4a7c15ull;     // Odd, 2^64 / golden ratio.
+
+  struct slot
+  {
+    uint64_t hash_;
+    field::index_t index_;
+  };
+
+  size_t slot_of(uint64_t hash) const { return shift_ == 64 ? 0 : (size_t)((hash * k_seed) >> shift_); }
+  size_t next(size_t s) const { return (s + 1) & (slots_.size() - 1); }
+
+  std::vector<slot> slots_;
+  unsigned shift_ = 64;
+};
+
+name_table::name_table(std::vector<field> const& fields)
+{
+  // A power of two of at least twice the field count, so probe runs stay short and always end at an empty slot.
+  unsigned const bits = std::bit_width(std::max<size_t>(1, fields.size() * 2 - 1));
+  slots_.assign(size_t{1} << bits, slot{0, field::k_null_index});
+  shift_ = 64 - bits;
+
+  for (field::index_t i = 0; i < fields.size(); ++i)
+  {
+    auto const hash = util::hash(fields[i].name());
+    auto s = slot_of(hash);
+    for (; slots_[s].index_ != field::k_null_index; s = next(s)) {
+      if (slots_[s].hash_ == hash && fields[slots_[s].index_].name() == fields[i].name()) {
+        throw std::runtime_error(fmt::format("duplicate field name '{}'", fields[i].name()));
+      }
+    }
+    slots_[s] = slot{hash, i};
+  }
+}
+
+field::index_t name_table::find(field_name const& name, std::vector<field> const& fields) const
+{
+  if (slots_.empty()) {
+    return field::k_null_index;
+  }
+  for (auto s = slot_of(name.hash()); slots_[s].index_ != field::k_null_index; s = next(s)) {
+    if (slots_[s].hash_ == name.hash() && fields[slots_[s].index_].name() == name.view()) {
+      return slots_[s].index_;
+    }
+  }
+  return field::k_null_index;
+}
+
+} // namespace rdf
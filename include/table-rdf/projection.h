@@ -0,0 +1,98 @@
+#pragma once
+#include "copy_plan.h"
+
+#include <oneapi/tbb.h>
+
+#if TRDF_HAS_SSSE3
+  #include <immintrin.h>
+#endif
+
+namespace rdf
+{
+
+// Converts batches of records from a source layout to a target layout, matching fields by name (see copy_plan).
+// The offset shuffle is precomputed once and batches are split over TBB ranges.
+// When both records fit in a 16 byte vector and every target field is a plain byte copy, each record is converted
+// with a single SSSE3 byte shuffle instead of a series of memcpy runs (requires building with SSSE3 enabled, e.g.
+// TRDF_NATIVE_ARCH=ON).
+class projection
+{
+public:
+  static constexpr size_t k_vector_size = 16;
+
+  inline projection(descriptor const& src, descriptor const& dest);
+
+  // Convert count contiguous records in parallel.
+  inline void operator()(mem_t* dest, mem_t const* src, size_t count) const;
+
+  // Convert count contiguous records on the calling thread.
+  inline void convert(mem_t* dest, mem_t const* src, size_t count) const;
+
+  copy_plan const& plan() const { return plan_; }
+  bool shuffled() const { return shuffled_; }
+
+private:
+  copy_plan plan_;
+  std::array<uint8_t, k_vector_size> shuffle_;   // Destination byte i is taken from source byte shuffle_[i] (0x80 -> zero).
+  bool shuffled_;
+  size_t grain_;                                 // Records per TBB task.
+};
+
+projection::projection(descriptor const& src, descriptor const& dest)
+  : plan_{src, dest},
+    shuffle_{},
+    shuffled_{false},
+    grain_{std::max<size_t>(1, (64 * 1024) / std::max(src.mem_size(), dest.mem_size()))}
+{
+#if TRDF_HAS_SSSE3
+  auto const complete = std::ranges::all_of(dest.fields(), [&](auto const& df) { return src.contains(df.name()); });
+
+  if (complete && plan_.special_count() == 0 && src.mem_size() <= k_vector_size && dest.mem_size() <= k_vector_size)
+  {
+    shuffle_.fill(0x80);
+    for (auto const& r : plan_.runs()) {
+      for (size_t i = 0; i < r.size; ++i) {
+        shuffle_[r.dest_offset + i] = (uint8_t)(r.src_offset + i);
+      }
+    }
+    shuffled_ = true;
+  }
+#endif
+}
+
+void projection::convert(mem_t* dest, mem_t const* src, size_t count) const
+{
+  size_t i = 0;
+
+#if TRDF_HAS_SSSE3
+  if (shuffled_)
+  {
+    auto const src_size = plan_.src_size();
+    auto const dest_size = plan_.dest_size();
+    auto const mask = _mm_loadu_si128(reinterpret_cast<__m128i const*>(shuffle_.data()));
+
+    // Full vector loads may read past the end of a record, so the last few records fall through to the plan.
+    auto const vector_count = count - std::min(count, (k_vector_size + src_size - 1) / src_size);
+    for (; i < vector_count; ++i)
+    {
+      auto const v = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i * src_size)), mask);
+      alignas(k_vector_size) std::array<mem_t, k_vector_size> out;
+      _mm_store_si128(reinterpret_cast<__m128i*>(out.data()), v);
+      std::memcpy(dest + i * dest_size, out.data(), dest_size);
+    }
+  }
+#endif
+
+  plan_.copy(dest + i * plan_.dest_size(), src + i * plan_.src_size(), count - i);
+}
+
+void projection::operator()(mem_t* dest, mem_t const* src, size_t count) const
+{
+  tbb::parallel_for(tbb::blocked_range<size_t>(0, count, grain_),
+    [&](tbb::blocked_range<size_t> const& range)
+    {
+      convert(dest + range.begin() * plan_.dest_size(), src + range.begin() * plan_.src_size(), range.size());
+    });
+}
+
+} // namespace rdf
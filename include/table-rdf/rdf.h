@@ -3,6 +3,31 @@
 #include <functional>
 #include "descriptor.h"
 #include "record.h"
+#include "record_span.h"
+#include "seqlock.h"
+#include "static_descriptor.h"
+#include "copy_plan.h"
+#include "projection.h"
+#include "column_table.h"
+#include "table_file.h"
+#include "table_appender.h"
+#include "table_follower.h"
+#include "record_ring.h"
+#include "key_index.h"
+#include "key_dictionary.h"
+#include "string_arena.h"
+#include "time_index.h"
+#include "scan.h"
+#include "aggregate.h"
+#include "record_buffer.h"
+#include "group_by.h"
+#include "encoded_table.h"
+#include "record_formatter.h"
+#include "record_parser.h"
+#include "arrow_export.h"
+#if !defined(_WIN32)
+  #include "block_reader.h"
+#endif
 
 namespace rdf
 {
@@ -11,9 +36,7 @@ namespace rdf
 
     template<concepts::record R>
     auto records(mspan const& memory, descriptor const& d) {
-      return memory | 
-             std::views::stride(d.mem_size()) |
-             std::views::transform(mem_to_record<R>);
+      return record_span<R>{memory, d};
     }
     template<concepts::record R>
     using records_view_t = decltype(std::function(records<R>))::result_type;
@@ -21,5 +44,7 @@ namespace rdf
   }
 
   static_assert(std::ranges::random_access_range<rdf::views::records_view_t<rdf::record>>);
+  static_assert(std::ranges::view<record_span<record>>);
+  static_assert(std::ranges::sized_range<record_span<record>>);
 
 } // namespace rdf
\ No newline at end of file
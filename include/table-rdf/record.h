@@ -1,5 +1,6 @@
 #pragma once
 #include "descriptor.h"
+#include "seqlock.h"
 
 #include <fmt/core.h>
 
@@ -25,6 +26,13 @@ public:
     return f.read<T>(cmem());
   }
 
+  // Read a field of a record that may be updated concurrently, retrying on a torn read. Strings are returned by value.
+  template <types::type T>
+  inline auto get(const field& f, record_seqlock const& lock) const
+  {
+    return lock.get<T>(cmem(), f);
+  }
+
   mem_t const* cmem() const;
   mem_t* mem();
 
@@ -103,6 +111,14 @@ inline std::string record::to_string(descriptor const& desc) const
         break;
       }
       FMT_FIELD(Bool);
+      FMT_FIELD(KeyDict);     // The code, decode with the key_dictionary.
+      case StringRef: {
+        // Without the arena only inline strings can be shown.
+        auto const ref = get<StringRef>(f);
+        out_it = ref.inlined() ? fmt::format_to(out_it, f.fmt(), string_t{ref.data_, ref.length_})
+                               : fmt::format_to(out_it, f.fmt(), fmt::format("<{}B @{}>", ref.length_, ref.offset()));
+        break;
+      }
       case type_numof:
         BOOST_ASSERT_MSG(false, "invalid field type");
         break;
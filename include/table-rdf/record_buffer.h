@@ -0,0 +1,56 @@
+#pragma once
+#include "record_span.h"
+
+#include <memory>
+
+namespace rdf
+{
+
+// Owning, zero initialised buffer of records laid out by a descriptor, e.g. the output of group_by. Memory is
+// aligned to a cache line and to mem_align().
+class record_buffer
+{
+public:
+  static constexpr size_t k_cache_line = 64;
+
+  inline record_buffer(descriptor const& desc, size_t count);
+
+  descriptor const& desc() const { return desc_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t size_bytes() const { return size_ * desc_.mem_size(); }
+
+  mem_t*       data()       { return mem_.get(); }
+  mem_t const* data() const { return mem_.get(); }
+
+  mem_t*       operator[](size_t i)       { BOOST_ASSERT(i < size_); return data() + i * desc_.mem_size(); }
+  mem_t const* operator[](size_t i) const { BOOST_ASSERT(i < size_); return data() + i * desc_.mem_size(); }
+
+  // Drops the records from count on, keeping the memory.
+  void shrink(size_t count) { BOOST_ASSERT(count <= size_); size_ = count; }
+
+  template <concepts::record R = record>
+  record_span<R> records() const { return record_span<R>{data(), desc_.mem_size(), size_}; }
+
+private:
+  struct free_deleter { void operator()(mem_t* p) const { std::free(p); } };
+
+  descriptor desc_;
+  size_t size_;
+  std::unique_ptr<mem_t, free_deleter> mem_;
+};
+
+record_buffer::record_buffer(descriptor const& desc, size_t count)
+  : desc_{desc},
+    size_{count}
+{
+  auto const align = std::max(desc.mem_align(), k_cache_line);
+  auto const bytes = boost::alignment::align_up(std::max<size_t>(1, size_bytes()), align);
+  mem_.reset((mem_t*)std::aligned_alloc(align, bytes));
+  if (!mem_) {
+    throw std::bad_alloc{};
+  }
+  std::memset(mem_.get(), 0, bytes);
+}
+
+} // namespace rdf
@@ -0,0 +1,304 @@
+#pragma once
+#include "key_dictionary.h"
+#include "record_span.h"
+#include "string_arena.h"
+
+#include <oneapi/tbb/parallel_pipeline.h>
+
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+
+namespace rdf
+{
+
+struct record_formatter_options
+{
+  char delimiter = ',';                             // '\t' for TSV.
+  bool header = true;                               // A first line of field names, see export_text().
+  std::string time_format = k_str_to_time_fmt;      // See util::time_fmt.
+  key_dictionary const* dictionary = nullptr;       // Decodes KeyDict fields, otherwise their codes are written.
+  string_arena const* arena = nullptr;              // Resolves StringRef fields, otherwise only inline strings are.
+};
+
+// Delimited text (CSV / TSV) formatting of the records of a descriptor. The writer of each field is resolved once when
+// the formatter is made, so formatting a record is one indirect call per field with no format string parsing:
+// integers and floats go through std::to_chars (floats in their shortest round trip form), timestamps through a
+// compiled util::time_fmt. Strings are quoted, as in RFC 4180, when they hold the delimiter, a quote or a line break.
+// Unlike record::to_string() the field fmt() specs, which pad for logging, are not used. A formatter is immutable, so
+// one may be shared by many threads, each formatting into its own buffer, e.g.
+//   record_formatter const csv{desc};
+//   std::string text;
+//   csv.format(records, text);      // Appends a line per record.
+class record_formatter
+{
+public:
+  using options = record_formatter_options;
+
+  inline explicit record_formatter(descriptor const& desc, options const& opts = options{});
+
+  // Appends a line of field names.
+  inline void header(std::string& text) const;
+
+  // Appends a line per record. text is grown geometrically and can be reused across calls to avoid reallocation.
+  inline void format(record_span<record> records, std::string& text) const;
+  void format(record const& r, std::string& text) const { format(record_span<record>{r.cmem(), desc_.mem_size(), 1}, text); }
+
+  descriptor const& desc() const { return desc_; }
+  options const& opts() const { return opts_; }
+
+private:
+  // Writes to text past size_, growing it ahead of each value.
+  struct output
+  {
+    char* reserve(size_t n) {
+      if (size_ + n > text_.size()) {
+        text_.resize(std::max(text_.size() * 2, size_ + n));
+      }
+      return text_.data() + size_;
+    }
+    void commit(char const* end) { size_ = end - text_.data(); }
+    void put(char c) { *reserve(1) = c; ++size_; }
+
+    std::string& text_;
+    size_t size_;
+  };
+
+  struct column;
+  using writer = void (*)(record_formatter const&, column const&, mem_t const*, output&);
+
+  struct column
+  {
+    field field_;
+    writer write_;
+  };
+
+  template <types::type T> static void write_value(record_formatter const& self, column const& c, mem_t const* mem, output& out);
+  inline void write_string(string_t s, output& out) const;
+
+  descriptor desc_;
+  options opts_;
+  util::time_fmt time_fmt_;
+  std::vector<column> columns_;
+};
+
+// Writes records as delimited text, a header line first if opts().header. Chunks of chunk_records are formatted on
+// TBB workers and written in order, with a bounded number of chunks in flight. Returns the bytes written.
+inline size_t export_text(std::ostream& os, record_formatter const& formatter, record_span<record> records,
+                          size_t chunk_records = 16 * 1024);
+inline size_t export_text(std::filesystem::path const& path, descriptor const& desc, record_span<record> records,
+                          record_formatter::options const& opts = record_formatter::options{});
+
+record_formatter::record_formatter(descriptor const& desc, options const& opts)
+  : desc_{desc},
+    opts_{opts},
+    time_fmt_{opts.time_format}
+{
+  if (opts_.delimiter == '"' || opts_.delimiter == '\n' || opts_.delimiter == '\r') {
+    throw std::runtime_error(fmt::format("invalid delimiter '{}'", opts_.delimiter));
+  }
+
+  #define WRITE_FIELD(F) \
+    case F: \
+      w = &write_value<F>; \
+      break;
+
+  for (auto const& f : desc_.fields()) {
+    writer w = nullptr;
+    switch (f.type())
+    {
+      WRITE_FIELD(Key8);
+      WRITE_FIELD(Key16);
+      WRITE_FIELD(String8);
+      WRITE_FIELD(String16);
+      WRITE_FIELD(Timestamp);
+      WRITE_FIELD(Char);
+      WRITE_FIELD(Utf_Char8);
+      WRITE_FIELD(Utf_Char16);
+      WRITE_FIELD(Utf_Char32);
+      WRITE_FIELD(Int8);
+      WRITE_FIELD(Int16);
+      WRITE_FIELD(Int32);
+      WRITE_FIELD(Int64);
+      WRITE_FIELD(Uint8);
+      WRITE_FIELD(Uint16);
+      WRITE_FIELD(Uint32);
+      WRITE_FIELD(Uint64);
+      WRITE_FIELD(Float16);
+      WRITE_FIELD(Float32);
+      WRITE_FIELD(Float64);
+      WRITE_FIELD(Float128);
+      WRITE_FIELD(Bool);
+      WRITE_FIELD(KeyDict);
+      WRITE_FIELD(StringRef);
+      case type_numof:
+        BOOST_ASSERT_MSG(false, "invalid field type");
+        break;
+    }
+    columns_.push_back({f, w});
+  }
+
+  #undef WRITE_FIELD
+}
+
+void record_formatter::header(std::string& text) const
+{
+  output out{text, text.size()};
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    if (i > 0) {
+      out.put(opts_.delimiter);
+    }
+    write_string(columns_[i].field_.name(), out);
+  }
+  out.put('\n');
+  text.resize(out.size_);
+}
+
+void record_formatter::format(record_span<record> records, std::string& text) const
+{
+  output out{text, text.size()};
+  for (auto r : records) {
+    auto const mem = r.cmem();
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      if (i > 0) {
+        out.put(opts_.delimiter);
+      }
+      columns_[i].write_(*this, columns_[i], mem, out);
+    }
+    out.put('\n');
+  }
+  text.resize(out.size_);
+}
+
+template <types::type T>
+void record_formatter::write_value(record_formatter const& self, column const& c, mem_t const* mem, output& out)
+{
+  auto const v = c.field_.read<T>(mem);
+  using V = std::remove_const_t<decltype(v)>;
+
+  // Longest to_chars output of the numeric types written, a shortest round trip Float128 with sign and exponent.
+  constexpr size_t k_max_number = 48;
+
+  if constexpr (concepts::string<V>) {
+    self.write_string(v, out);
+  }
+  else if constexpr (concepts::timestamp<V>) {
+    if (self.time_fmt_.compiled()) {
+      out.commit(self.time_fmt_.to_chars(out.reserve(self.time_fmt_.size()), v));
+    }
+    else {
+      self.write_string(self.time_fmt_.to_str(v), out);
+    }
+  }
+  else if constexpr (concepts::string_ref<V>) {
+    if (self.opts_.arena) {
+      self.write_string(self.opts_.arena->view(v), out);
+    }
+    else if (v.inlined()) {
+      self.write_string({v.data_, v.length_}, out);
+    }
+    else {
+      self.write_string(fmt::format("<{}B @{}>", v.length_, v.offset()), out);
+    }
+  }
+  else if constexpr (T == KeyDict) {
+    if (self.opts_.dictionary) {
+      self.write_string(self.opts_.dictionary->decode(v), out);
+    }
+    else {
+      auto const p = out.reserve(k_max_number);
+      out.commit(std::to_chars(p, p + k_max_number, v).ptr);
+    }
+  }
+  else if constexpr (T == Char) {
+    self.write_string({&v, 1}, out);
+  }
+  else if constexpr (T == Bool) {
+    auto const s = v ? string_t{"true"} : string_t{"false"};
+    auto const p = out.reserve(s.size());
+    out.commit(std::copy(s.begin(), s.end(), p));
+  }
+  else {
+    // As record::to_string(), characters are written as numbers. Float16 is written through float, which is exact,
+    // and Float128 at full precision.
+    using N = std::conditional_t<T == Utf_Char8 || T == Utf_Char16 || T == Utf_Char32, uint64_t,
+              std::conditional_t<T == Float16, float, V>>;
+    auto const p = out.reserve(k_max_number);
+    out.commit(std::to_chars(p, p + k_max_number, (N)v).ptr);
+  }
+}
+
+void record_formatter::write_string(string_t s, output& out) const
+{
+  auto const d = opts_.delimiter;
+  auto const plain = std::ranges::none_of(s, [d](char c) { return c == d || c == '"' || c == '\n' || c == '\r'; });
+  if (plain) {
+    auto const p = out.reserve(s.size());
+    out.commit(std::copy(s.begin(), s.end(), p));
+    return;
+  }
+
+  auto p = out.reserve(s.size() * 2 + 2);
+  *p++ = '"';
+  for (auto c : s) {
+    if (c == '"') {
+      *p++ = '"';
+    }
+    *p++ = c;
+  }
+  *p++ = '"';
+  out.commit(p);
+}
+
+size_t export_text(std::ostream& os, record_formatter const& formatter, record_span<record> records, size_t chunk_records)
+{
+  BOOST_ASSERT(chunk_records > 0);
+  size_t bytes = 0;
+  if (formatter.opts().header) {
+    std::string text;
+    formatter.header(text);
+    os.write(text.data(), text.size());
+    bytes += text.size();
+  }
+
+  auto const chunk_count = (records.size() + chunk_records - 1) / chunk_records;
+  size_t next = 0;
+  tbb::parallel_pipeline(2 * tbb::this_task_arena::max_concurrency(),
+    tbb::make_filter<void, size_t>(tbb::filter_mode::serial_in_order,
+      [&](tbb::flow_control& fc) {
+        if (next == chunk_count) {
+          fc.stop();
+        }
+        return next++;
+      }) &
+    tbb::make_filter<size_t, std::string>(tbb::filter_mode::parallel,
+      [&](size_t chunk) {
+        std::string text;
+        auto const first = chunk * chunk_records;
+        formatter.format(records.subspan(first, std::min(chunk_records, records.size() - first)), text);
+        return text;
+      }) &
+    tbb::make_filter<std::string, void>(tbb::filter_mode::serial_in_order,
+      [&](std::string const& text) {
+        os.write(text.data(), text.size());
+        bytes += text.size();
+      }));
+  return bytes;
+}
+
+size_t export_text(std::filesystem::path const& path, descriptor const& desc, record_span<record> records,
+                   record_formatter::options const& opts)
+{
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  if (!file) {
+    throw std::runtime_error(fmt::format("failed to create text file '{}'", path.string()));
+  }
+  auto const bytes = export_text(file, record_formatter{desc, opts}, records);
+  file.flush();
+  if (!file) {
+    throw std::runtime_error(fmt::format("failed to write text file '{}'", path.string()));
+  }
+  return bytes;
+}
+
+} // namespace rdf
@@ -0,0 +1,640 @@
+#pragma once
+#include "key_dictionary.h"
+#include "record_buffer.h"
+#include "string_arena.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <oneapi/tbb.h>
+
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <filesystem>
+#include <numeric>
+
+#if TRDF_HAS_SSSE3
+  #include <immintrin.h>
+#endif
+
+namespace rdf
+{
+
+struct record_parser_options
+{
+  char delimiter = ',';                             // '\t' for TSV.
+  bool header = true;                               // A first line of column names, matched to fields by name.
+  std::string time_format = k_str_to_time_fmt;      // See util::time_fmt.
+  key_dictionary* dictionary = nullptr;             // Encodes KeyDict fields, otherwise they are read as codes.
+  string_arena* arena = nullptr;                    // Holds StringRef strings, otherwise only inline ones are accepted.
+  size_t chunk_bytes = 4 * 1024 * 1024;             // Input parsed per task.
+};
+
+// A row that could not be parsed. Rows are numbered from 0 after any header, offsets are into the whole input.
+struct import_error
+{
+  size_t row;
+  size_t offset;
+  std::string message;
+};
+
+struct import_result
+{
+  record_buffer records;                // The rows parsed, in input order.
+  std::vector<import_error> errors;     // The rows skipped, in input order.
+};
+
+// Delimited text (CSV / TSV) parsing into the records of a descriptor, the inverse of record_formatter. Columns are
+// matched to fields by the header names, columns without a field are skipped and fields without a column left
+// zero, or are the fields in order when there is no header. The reader of each field is resolved once. Quoted fields
+// follow RFC 4180, the end of a row is "\n" or "\r\n", and blank lines are skipped. Empty fields leave the field zero.
+// Values are written with field::write(), so e.g. a string longer than its payload, an out of range integer or a
+// timestamp not in time_format is an error for its row. KeyDict strings are encoded by the dictionary, which may be
+// shared with other imports running at the same time. The arena must not be used by anything else during an import.
+class record_parser
+{
+public:
+  using options = record_parser_options;
+
+  inline record_parser(descriptor const& desc, options const& opts = options{});
+
+  descriptor const& desc() const { return desc_; }
+  options const& opts() const { return opts_; }
+
+  // Parses text, which holds the header line if opts().header, on TBB workers in chunks split at row boundaries.
+  inline import_result parse(string_t text) const;
+
+private:
+  using reader = void (*)(record_parser const&, field const&, string_t, mem_t*, string_arena&);
+  using columns = std::vector<field::index_t>;     // The field of each column, k_null_index if skipped.
+
+  // The rows starting in one chunk, parsed into the records from first_.
+  struct chunk
+  {
+    size_t begin_ = 0;     // Offset of the first row parsed, past the chunk if none.
+    size_t end_ = 0;       // Offset of the first row after those parsed.
+    size_t first_ = 0;
+    size_t capacity_ = 0;
+    size_t count_ = 0;
+    size_t rows_ = 0;
+    std::vector<import_error> errors_;
+    string_arena arena_;
+  };
+
+  // A row of text split into fields.
+  class tokenizer;
+
+  inline columns bind(std::vector<std::string> const& names) const;
+  inline bool parse_chunk(string_t text, columns const& cols, size_t pos, size_t last, mem_t* records, chunk& out) const;
+
+  template <types::type T> static void read_value(record_parser const& self, field const& f, string_t s, mem_t* mem, string_arena& arena);
+  template <class V> static V read_number(field const& f, string_t s);
+
+  descriptor desc_;
+  options opts_;
+  util::time_fmt time_fmt_;
+  std::vector<reader> readers_;     // By field index.
+};
+
+// Maps the file at path and parses it, see record_parser.
+inline import_result import_text(std::filesystem::path const& path, descriptor const& desc,
+                                 record_parser::options const& opts = record_parser::options{});
+
+namespace detail {
+
+// First of the delimiter, '\n' or '\r' in [p, end), or end.
+inline char const* find_field_break(char const* p, char const* end, char delimiter)
+{
+#if TRDF_HAS_SSSE3
+  auto const d = _mm_set1_epi8(delimiter);
+  auto const n = _mm_set1_epi8('\n');
+  auto const r = _mm_set1_epi8('\r');
+  for (; end - p >= 16; p += 16) {
+    auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+    auto const hits = _mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_or_si128(_mm_cmpeq_epi8(v, n), _mm_cmpeq_epi8(v, r)));
+    if (auto const mask = (unsigned)_mm_movemask_epi8(hits)) {
+      return p + std::countr_zero(mask);
+    }
+  }
+#endif
+  while (p < end && *p != delimiter && *p != '\n' && *p != '\r') {
+    ++p;
+  }
+  return p;
+}
+
+// True if a row ends at p. A '\r' only ends a row before a '\n' or at the end of the text, so rows end exactly where
+// count_row_ends() counts them, and a bare '\r' is field data.
+inline bool is_row_break(char const* p, char const* end)
+{
+  return p < end && (*p == '\n' || (*p == '\r' && (p + 1 == end || p[1] == '\n')));
+}
+
+// First delimiter or row break in [p, end), or end.
+inline char const* find_field_end(char const* p, char const* end, char delimiter)
+{
+  for (;;) {
+    p = find_field_break(p, end, delimiter);
+    if (p == end || *p == delimiter || is_row_break(p, end)) {
+      return p;
+    }
+    ++p;     // A bare '\r'.
+  }
+}
+
+// Number of '"' in [p, end).
+inline size_t count_quotes(char const* p, char const* end)
+{
+  size_t count = 0;
+#if TRDF_HAS_SSSE3
+  auto const q = _mm_set1_epi8('"');
+  for (; end - p >= 16; p += 16) {
+    auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+    count += std::popcount((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)));
+  }
+#endif
+  return count + std::count(p, end, '"');
+}
+
+// Number of '\n' outside quotes in [p, end), quoted if p is inside quotes.
+inline size_t count_row_ends(char const* p, char const* end, bool quoted)
+{
+  size_t count = 0;
+#if TRDF_HAS_SSSE3
+  // 64 chars at a time: a prefix xor of the quote bits sets the bits of the chars inside quotes.
+  auto const q = _mm_set1_epi8('"');
+  auto const n = _mm_set1_epi8('\n');
+  uint64_t inside = quoted ? ~0ull : 0;
+  for (; end - p >= 64; p += 64) {
+    uint64_t quotes = 0;
+    uint64_t newlines = 0;
+    for (int i = 0; i < 4; ++i) {
+      auto const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i * 16));
+      quotes |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)) << (i * 16);
+      newlines |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, n)) << (i * 16);
+    }
+    for (int shift = 1; shift < 64; shift *= 2) {
+      quotes ^= quotes << shift;
+    }
+    quotes ^= inside;
+    count += std::popcount(newlines & ~quotes);
+    inside = quotes >> 63 ? ~0ull : 0;
+  }
+  quoted = inside;
+#endif
+  for (; p < end; ++p) {
+    quoted ^= *p == '"';
+    count += !quoted && *p == '\n';
+  }
+  return count;
+}
+
+} // namespace detail
+
+class record_parser::tokenizer
+{
+public:
+  tokenizer(string_t text, size_t pos, char delimiter) : text_{text}, pos_{pos}, delimiter_{delimiter} {}
+
+  size_t pos() const { return pos_; }
+  bool done() const { return pos_ >= text_.size(); }
+
+  // Skips blank lines, false at the end of the text.
+  bool start_row() {
+    while (detail::is_row_break(text_.data() + pos_, text_.data() + text_.size())) {
+      ++pos_;
+    }
+    at_row_end_ = done();
+    return !done();
+  }
+
+  bool at_row_end() const { return at_row_end_; }
+
+  // The next field of the row. Unescaped quoted fields are copied to scratch_. Throws on a malformed quoted field,
+  // leaving the rest of the row to skip_row().
+  string_t next() {
+    BOOST_ASSERT(!at_row_end_);
+    auto const begin = text_.data() + pos_;
+    auto const end = text_.data() + text_.size();
+    string_t field;
+    char const* p;
+    if (begin < end && *begin == '"') {
+      scratch_.clear();
+      p = begin + 1;
+      for (;;) {
+        auto const quote = static_cast<char const*>(std::memchr(p, '"', end - p));
+        if (!quote) {
+          pos_ = text_.size();
+          at_row_end_ = true;
+          throw std::runtime_error("unterminated quoted field");
+        }
+        scratch_.append(p, quote);
+        p = quote + 1;
+        if (p < end && *p == '"') {     // An escaped quote.
+          scratch_ += '"';
+          ++p;
+          continue;
+        }
+        break;
+      }
+      field = scratch_;
+      if (p < end && *p != delimiter_ && !detail::is_row_break(p, end)) {
+        pos_ = p - text_.data();
+        throw std::runtime_error("unexpected character after a quoted field");
+      }
+    }
+    else {
+      p = detail::find_field_end(begin, end, delimiter_);
+      field = { begin, size_t(p - begin) };
+    }
+    end_field(p);
+    return field;
+  }
+
+  // Moves past the end of the row, e.g. after an error.
+  void skip_row() {
+    while (!at_row_end_) {
+      try {
+        next();
+      }
+      catch (std::runtime_error const&) {
+        auto const end = text_.data() + text_.size();
+        end_field(detail::find_field_end(text_.data() + pos_, end, delimiter_));
+      }
+    }
+  }
+
+private:
+  void end_field(char const* p) {
+    auto const end = text_.data() + text_.size();
+    if (p < end && *p == delimiter_) {
+      pos_ = p + 1 - text_.data();
+      return;
+    }
+    BOOST_ASSERT(p == end || detail::is_row_break(p, end));
+    if (p < end && *p == '\r') {
+      ++p;
+    }
+    if (p < end && *p == '\n') {
+      ++p;
+    }
+    pos_ = p - text_.data();
+    at_row_end_ = true;
+  }
+
+  string_t text_;
+  size_t pos_;
+  char delimiter_;
+  bool at_row_end_ = true;
+  std::string scratch_;
+};
+
+record_parser::record_parser(descriptor const& desc, options const& opts)
+  : desc_{desc},
+    opts_{opts},
+    time_fmt_{opts.time_format}
+{
+  if (opts_.delimiter == '"' || opts_.delimiter == '\n' || opts_.delimiter == '\r') {
+    throw std::runtime_error(fmt::format("invalid delimiter '{}'", opts_.delimiter));
+  }
+  BOOST_ASSERT(opts_.chunk_bytes > 0);
+
+  #define READ_FIELD(F) \
+    case F: \
+      r = &read_value<F>; \
+      break;
+
+  for (auto const& f : desc_.fields()) {
+    reader r = nullptr;
+    switch (f.type())
+    {
+      READ_FIELD(Key8);
+      READ_FIELD(Key16);
+      READ_FIELD(String8);
+      READ_FIELD(String16);
+      READ_FIELD(Timestamp);
+      READ_FIELD(Char);
+      READ_FIELD(Utf_Char8);
+      READ_FIELD(Utf_Char16);
+      READ_FIELD(Utf_Char32);
+      READ_FIELD(Int8);
+      READ_FIELD(Int16);
+      READ_FIELD(Int32);
+      READ_FIELD(Int64);
+      READ_FIELD(Uint8);
+      READ_FIELD(Uint16);
+      READ_FIELD(Uint32);
+      READ_FIELD(Uint64);
+      READ_FIELD(Float16);
+      READ_FIELD(Float32);
+      READ_FIELD(Float64);
+      READ_FIELD(Float128);
+      READ_FIELD(Bool);
+      READ_FIELD(KeyDict);
+      READ_FIELD(StringRef);
+      case type_numof:
+        BOOST_ASSERT_MSG(false, "invalid field type");
+        break;
+    }
+    readers_.push_back(r);
+  }
+
+  #undef READ_FIELD
+}
+
+record_parser::columns record_parser::bind(std::vector<std::string> const& names) const
+{
+  columns cols;
+  for (auto const& name : names) {
+    auto const it = std::ranges::find_if(desc_.fields(), [&](auto const& f) { return f.name() == name; });
+    auto const index = it == desc_.fields().end() ? field::k_null_index : it->index();
+    if (index != field::k_null_index && std::ranges::find(cols, index) != cols.end()) {
+      throw std::runtime_error(fmt::format("duplicate column '{}'", name));
+    }
+    cols.push_back(index);
+  }
+  return cols;
+}
+
+import_result record_parser::parse(string_t text) const
+{
+  // Skip a UTF-8 byte order mark, then match the header names to fields.
+  size_t start = text.starts_with("\xEF\xBB\xBF") ? 3 : 0;
+  columns cols;
+  if (opts_.header) {
+    tokenizer header{text, start, opts_.delimiter};
+    std::vector<std::string> names;
+    if (header.start_row()) {
+      while (!header.at_row_end()) {
+        names.emplace_back(header.next());
+      }
+    }
+    cols = bind(names);
+    start = header.pos();
+  }
+  else {
+    for (auto const& f : desc_.fields()) {
+      cols.push_back(f.index());
+    }
+  }
+
+  // Rows start after a newline outside quotes, so each chunk finds its first row from the count of quotes before it.
+  // The rows starting in each chunk are counted from the newlines outside quotes, so each is parsed straight into
+  // its place. Blank lines and bad rows leave gaps, closed once all chunks are parsed.
+  // A quote inside an unquoted field, e.g. 12", is data to the tokenizer but flips the count of quotes, so the
+  // chunks may then start or count their rows wrongly. If so the text is split again by tokenizing it in order.
+  auto const chunk_count = std::max<size_t>(1, (text.size() - start + opts_.chunk_bytes - 1) / opts_.chunk_bytes);
+  auto const chunk_begin = [&](size_t c) { return std::min(text.size(), start + c * opts_.chunk_bytes); };
+  std::vector<size_t> quotes(chunk_count + 1);
+  tbb::parallel_for(size_t{0}, chunk_count, [&](size_t c) {
+    quotes[c + 1] = detail::count_quotes(text.data() + chunk_begin(c), text.data() + chunk_begin(c + 1));
+  });
+  std::partial_sum(quotes.begin(), quotes.end(), quotes.begin());
+
+  // A row starts at start and after each newline outside quotes before the end. A newline does not change the count
+  // of quotes, so the count before a chunk also holds for the char before it.
+  auto const row_end = [&](size_t pos, size_t c) { return pos < text.size() && text[pos] == '\n' && quotes[c] % 2 == 0; };
+  std::vector<chunk> chunks(chunk_count);
+  tbb::parallel_for(size_t{0}, chunk_count, [&](size_t c) {
+    auto const first = chunk_begin(c);
+    auto const last = chunk_begin(c + 1);
+    chunks[c].capacity_ = detail::count_row_ends(text.data() + first, text.data() + last, quotes[c] % 2) +
+                          (c == 0 ? first < last : row_end(first - 1, c)) - (last > first && row_end(last - 1, c + 1));
+  });
+  size_t capacity = 0;
+  for (auto& ch : chunks) {
+    ch.first_ = capacity;
+    capacity += ch.capacity_;
+  }
+
+  // After the first chunk rows start after the first newline outside quotes at or after first - 1. A '\n' does not
+  // change the count of quotes, so it also holds for first - 1.
+  std::vector<size_t> begins(chunk_count);
+  tbb::parallel_for(size_t{0}, chunk_count, [&](size_t c) {
+    auto const last = chunk_begin(c + 1);
+    auto pos = chunk_begin(c);
+    auto quoted = quotes[c] % 2 == 1;
+    if (c > 0 && (quoted || text[pos - 1] != '\n')) {
+      while (pos < last && (quoted || text[pos] != '\n')) {
+        quoted ^= text[pos++] == '"';
+      }
+      pos = std::min(pos + 1, last);
+    }
+    begins[c] = pos;
+  });
+
+  auto const parse_chunks = [&](record_buffer& records) {
+    std::atomic<bool> counted = true;
+    tbb::parallel_for(size_t{0}, chunk_count, [&](size_t c) {
+      if (!parse_chunk(text, cols, begins[c], chunk_begin(c + 1), records.data() + chunks[c].first_ * desc_.mem_size(), chunks[c])) {
+        counted = false;
+      }
+    });
+    return counted.load();
+  };
+
+  record_buffer records{desc_, capacity};
+  auto split = parse_chunks(records);
+
+  // The split was right if each chunk starts at the first row after those of the chunks before it, or has no rows
+  // when that row is past its end.
+  auto next = chunks[0].end_;
+  for (size_t c = 1; split && c < chunk_count; ++c) {
+    auto const last = chunk_begin(c + 1);
+    split = next < last ? chunks[c].begin_ == next : chunks[c].begin_ >= last;
+    if (chunks[c].begin_ < last) {
+      next = chunks[c].end_;
+    }
+  }
+
+  if (!split) {
+    // Split at the rows found by the tokenizer, which parse_chunk() always agrees with.
+    std::ranges::fill(begins, text.size());
+    for (auto& ch : chunks) {
+      ch = chunk{};
+    }
+    tokenizer tok{text, start, opts_.delimiter};
+    for (size_t c = 0; tok.start_row(); tok.skip_row()) {
+      while (tok.pos() >= chunk_begin(c + 1)) {
+        ++c;
+      }
+      if (chunks[c].capacity_++ == 0) {
+        begins[c] = tok.pos();
+      }
+    }
+    capacity = 0;
+    for (auto& ch : chunks) {
+      ch.first_ = capacity;
+      capacity += ch.capacity_;
+    }
+
+    records = record_buffer{desc_, capacity};
+    if (!parse_chunks(records)) {
+      throw std::runtime_error("rows do not match the rows counted when split in order");
+    }
+  }
+
+  // Close the gaps and gather the errors in order, moving the strings of each chunk into the arena.
+  auto const stride = desc_.mem_size();
+  std::vector<import_error> errors;
+  std::vector<uint64_t> bases;
+  size_t total = 0;
+  size_t rows = 0;
+  for (auto& ch : chunks) {
+    if (ch.first_ != total) {
+      std::memmove(records.data() + total * stride, records.data() + ch.first_ * stride, ch.count_ * stride);
+      ch.first_ = total;
+    }
+    bases.push_back(opts_.arena ? opts_.arena->append(ch.arena_) : 0);
+    for (auto& e : ch.errors_) {
+      e.row += rows;
+      errors.push_back(std::move(e));
+    }
+    total += ch.count_;
+    rows += ch.rows_;
+  }
+  std::memset(records.data() + total * stride, 0, (capacity - total) * stride);
+  records.shrink(total);
+
+  tbb::parallel_for(size_t{0}, chunk_count, [&](size_t c) {
+    if (bases[c] == 0) {
+      return;
+    }
+    auto const dest = records.data() + chunks[c].first_ * stride;
+    for (auto const& f : desc_.fields()) {
+      if (f.type() == StringRef) {
+        for (size_t i = 0; i < chunks[c].count_; ++i) {
+          f.write<StringRef>(dest + i * stride, string_arena::rebase(f.read<StringRef>(dest + i * stride), bases[c]));
+        }
+      }
+    }
+  });
+  return { std::move(records), std::move(errors) };
+}
+
+bool record_parser::parse_chunk(string_t text, columns const& cols, size_t pos, size_t last, mem_t* records,
+                                chunk& out) const
+{
+  auto const stride = desc_.mem_size();
+  tokenizer tok{text, pos, opts_.delimiter};
+  tok.start_row();
+  out.begin_ = tok.pos();
+  while (tok.pos() < last && !tok.done()) {     // Blank lines may run into the next chunk.
+    auto const row_offset = tok.pos();
+    if (out.count_ == out.capacity_) {     // The rows of a chunk are written in place, never past its count.
+      return false;
+    }
+    auto const mem = records + out.count_ * stride;
+
+    auto index = field::k_null_index;     // Of the field being read, for errors.
+    try {
+      size_t column = 0;
+      for (; !tok.at_row_end(); ++column) {
+        index = column < cols.size() ? cols[column] : field::k_null_index;
+        auto const s = tok.next();
+        if (index != field::k_null_index && !s.empty()) {
+          readers_[index](*this, desc_.fields(index), s, mem, out.arena_);
+        }
+      }
+      index = field::k_null_index;
+      if (column != cols.size()) {
+        throw std::runtime_error(fmt::format("row has {} fields, expected {}", column, cols.size()));
+      }
+      ++out.count_;
+    }
+    catch (std::runtime_error const& e) {
+      out.errors_.push_back({ out.rows_, row_offset, index == field::k_null_index ? e.what()
+                                                       : fmt::format("field '{}': {}", desc_.fields(index).name(), e.what()) });
+      tok.skip_row();
+      std::memset(mem, 0, stride);
+    }
+    ++out.rows_;
+    tok.start_row();
+  }
+  out.end_ = tok.pos();
+  return true;
+}
+
+template <class V>
+V record_parser::read_number(field const& f, string_t s)
+{
+  // Integers are range checked through the widest type of their sign.
+  using W = std::conditional_t<std::is_floating_point_v<V>, V, std::conditional_t<std::is_signed_v<V>, int64_t, uint64_t>>;
+  W w;
+  auto const [end, ec] = std::from_chars(s.data(), s.data() + s.size(), w);
+  auto ok = ec == std::errc{} && end == s.data() + s.size();
+  if constexpr (std::is_integral_v<V>) {
+    ok = ok && std::in_range<V>(w);
+  }
+  if (!ok) {
+    throw std::runtime_error(fmt::format("invalid {} value '{}'", f.type_name(), s));
+  }
+  return (V)w;
+}
+
+template <types::type T>
+void record_parser::read_value(record_parser const& self, field const& f, string_t s, mem_t* mem, string_arena& arena)
+{
+  using V = std::remove_const_t<value_t<T>>;
+
+  if constexpr (concepts::string<V>) {
+    f.write<T>(mem, s);
+  }
+  else if constexpr (concepts::timestamp<V>) {
+    f.write<T>(mem, self.time_fmt_.to_time(s));
+  }
+  else if constexpr (concepts::string_ref<V>) {
+    if (self.opts_.arena) {
+      f.write<T>(mem, arena.append(s));
+    }
+    else if (s.size() <= string_ref::k_inline) {
+      f.write<T>(mem, string_arena{}.append(s));
+    }
+    else {
+      throw std::runtime_error(fmt::format("string of length {} needs a string_arena", s.size()));
+    }
+  }
+  else if constexpr (T == KeyDict) {
+    f.write<T>(mem, self.opts_.dictionary ? self.opts_.dictionary->encode(s) : read_number<key_code_t>(f, s));
+  }
+  else if constexpr (T == Char) {
+    if (s.size() != 1) {
+      throw std::runtime_error(fmt::format("invalid {} value '{}'", f.type_name(), s));
+    }
+    f.write<T>(mem, s[0]);
+  }
+  else if constexpr (T == Bool) {
+    if (s != "true" && s != "false" && s != "1" && s != "0") {
+      throw std::runtime_error(fmt::format("invalid {} value '{}'", f.type_name(), s));
+    }
+    f.write<T>(mem, s == "true" || s == "1");
+  }
+  else {
+    // As record_formatter, characters are numbers. Float16 is read through float and rounded, Float128 at full
+    // precision.
+    using N = std::conditional_t<T == Utf_Char8, uint8_t,
+              std::conditional_t<T == Utf_Char16, uint16_t,
+              std::conditional_t<T == Utf_Char32, uint32_t,
+              std::conditional_t<T == Float16 || T == Float32, float,
+              std::conditional_t<T == Float64, double, V>>>>>;
+    f.write<T>(mem, (V)read_number<N>(f, s));
+  }
+}
+
+import_result import_text(std::filesystem::path const& path, descriptor const& desc, record_parser::options const& opts)
+{
+  if (!std::filesystem::exists(path)) {
+    throw std::runtime_error(fmt::format("text file '{}' does not exist", path.string()));
+  }
+  record_parser const parser{desc, opts};
+  if (std::filesystem::file_size(path) == 0) {
+    return parser.parse({});
+  }
+  boost::interprocess::file_mapping const mapping{path.string().c_str(), boost::interprocess::read_only};
+  boost::interprocess::mapped_region region{mapping, boost::interprocess::read_only};
+  region.advise(boost::interprocess::mapped_region::advice_sequential);
+  return parser.parse({ static_cast<char const*>(region.get_address()), region.get_size() });
+}
+
+} // namespace rdf
@@ -0,0 +1,186 @@
+#pragma once
+#include "descriptor.h"
+#include "record.h"
+
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <thread>
+
+namespace rdf
+{
+
+// Bounded lock-free ring of record slots sized and aligned by a descriptor.
+// Producers fill a slot in place, e.g. ring.try_push([&](mem_t* mem) { price.write<Float64>(mem, p); }), and
+// consumers read it in place through a record, e.g. ring.try_pop([&](record r) { use(r.get<Float64>(price)); }),
+// so records are never copied through an intermediate object.
+//   Multi = false: single producer, single consumer. Records are packed at mem_size() and each side caches the
+//                  other side's position, so the shared positions are only read when the ring looks full / empty.
+//   Multi = true:  any number of producers and consumers (Vyukov's bounded queue). Each slot carries a sequence
+//                  number in front of the record.
+template <bool Multi>
+class record_ring
+{
+public:
+  static constexpr size_t k_cache_line = 64;
+
+  // Capacity is rounded up to a power of two.
+  inline record_ring(descriptor const& desc, size_t capacity);
+
+  record_ring(record_ring const&) = delete;
+  record_ring& operator=(record_ring const&) = delete;
+
+  descriptor const& desc() const { return desc_; }
+  size_t capacity() const { return capacity_; }
+
+  // Approximate number of records in the ring.
+  size_t size() const { return producer_.pos_.load(std::memory_order_relaxed) - consumer_.pos_.load(std::memory_order_relaxed); }
+
+  // Call fill(mem_t*) on a free slot and publish it. Returns false if the ring is full.
+  template <class F> inline bool try_push(F&& fill);
+
+  // Call consume(record) on the oldest published slot and release it. Returns false if the ring is empty.
+  template <class F> inline bool try_pop(F&& consume);
+
+  template <class F> void push(F&& fill)       { while (!try_push(fill)) { std::this_thread::yield(); } }
+  template <class F> void pop(F&& consume)     { while (!try_pop(consume)) { std::this_thread::yield(); } }
+
+private:
+  // Position of one side, on its own cache line together with that side's cached copy of the other position.
+  struct alignas(k_cache_line) side
+  {
+    std::atomic<uint64_t> pos_{0};
+    uint64_t cached_{0};     // Spsc only.
+  };
+
+  mem_t* slot(uint64_t pos) const { return mem_.get() + (pos & mask_) * stride_; }
+  std::atomic_ref<uint64_t> sequence(uint64_t pos) const { return std::atomic_ref{*reinterpret_cast<uint64_t*>(slot(pos))}; }
+
+  struct free_deleter { void operator()(mem_t* p) const { std::free(p); } };
+
+  descriptor desc_;
+  size_t capacity_;
+  size_t mask_;
+  size_t record_offset_;    // Offset of the record within a slot, after the sequence number when Multi.
+  size_t stride_;           // When Multi, a multiple of alignof(uint64_t) so every sequence number is aligned.
+  std::unique_ptr<mem_t, free_deleter> mem_;
+  side producer_;
+  side consumer_;
+};
+
+using spsc_ring = record_ring<false>;
+using mpmc_ring = record_ring<true>;
+
+template <bool Multi>
+record_ring<Multi>::record_ring(descriptor const& desc, size_t capacity)
+  : desc_{desc},
+    capacity_{std::bit_ceil(std::max<size_t>(capacity, 1))},
+    mask_{capacity_ - 1},
+    record_offset_{Multi ? boost::alignment::align_up(sizeof(uint64_t), desc.mem_align()) : 0},
+    stride_{Multi ? boost::alignment::align_up(record_offset_ + desc.mem_size(), std::max(desc.mem_align(), alignof(uint64_t)))
+                  : desc.mem_size()}
+{
+  // Slots and the sequence numbers within them keep the record alignment.
+  auto const align = std::max({ desc.mem_align(), alignof(uint64_t), k_cache_line });
+  mem_.reset((mem_t*)std::aligned_alloc(align, boost::alignment::align_up(stride_ * capacity_, align)));
+  if (!mem_) {
+    throw std::bad_alloc{};
+  }
+  std::memset(mem_.get(), 0, stride_ * capacity_);
+
+  if constexpr (Multi) {
+    for (uint64_t i = 0; i < capacity_; ++i) {
+      sequence(i).store(i, std::memory_order_relaxed);
+    }
+  }
+}
+
+template <bool Multi>
+template <class F>
+bool record_ring<Multi>::try_push(F&& fill)
+{
+  if constexpr (Multi)
+  {
+    // A slot is free for position pos when its sequence equals pos.
+    auto pos = producer_.pos_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      auto const diff = (int64_t)(sequence(pos).load(std::memory_order_acquire) - pos);
+      if (diff == 0) {
+        if (producer_.pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      }
+      else if (diff < 0) {
+        return false;
+      }
+      else {
+        pos = producer_.pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    fill(slot(pos) + record_offset_);
+    sequence(pos).store(pos + 1, std::memory_order_release);
+  }
+  else
+  {
+    auto const pos = producer_.pos_.load(std::memory_order_relaxed);
+    if (pos - producer_.cached_ == capacity_)
+    {
+      producer_.cached_ = consumer_.pos_.load(std::memory_order_acquire);
+      if (pos - producer_.cached_ == capacity_) {
+        return false;
+      }
+    }
+
+    fill(slot(pos));
+    producer_.pos_.store(pos + 1, std::memory_order_release);
+  }
+  return true;
+}
+
+template <bool Multi>
+template <class F>
+bool record_ring<Multi>::try_pop(F&& consume)
+{
+  if constexpr (Multi)
+  {
+    // A slot is published for position pos when its sequence equals pos + 1.
+    auto pos = consumer_.pos_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      auto const diff = (int64_t)(sequence(pos).load(std::memory_order_acquire) - (pos + 1));
+      if (diff == 0) {
+        if (consumer_.pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      }
+      else if (diff < 0) {
+        return false;
+      }
+      else {
+        pos = consumer_.pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    consume(record{slot(pos) + record_offset_});
+    sequence(pos).store(pos + capacity_, std::memory_order_release);   // Free for the producer one lap later.
+  }
+  else
+  {
+    auto const pos = consumer_.pos_.load(std::memory_order_relaxed);
+    if (pos == consumer_.cached_)
+    {
+      consumer_.cached_ = producer_.pos_.load(std::memory_order_acquire);
+      if (pos == consumer_.cached_) {
+        return false;
+      }
+    }
+
+    consume(record{slot(pos)});
+    consumer_.pos_.store(pos + 1, std::memory_order_release);
+  }
+  return true;
+}
+
+} // namespace rdf
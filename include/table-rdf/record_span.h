@@ -0,0 +1,143 @@
+#pragma once
+#include "record.h"
+
+#include <oneapi/tbb.h>
+
+#include <compare>
+#include <numeric>
+#include <ranges>
+
+namespace rdf
+{
+
+// A non-owning view of count records of stride bytes starting at base.
+// Unlike mspan | std::views::stride, iterating is a pointer bump and a pointer compare per record, and slicing is O(1).
+// Also models a TBB Range so it can be passed straight to tbb::parallel_for, splitting only on cache line multiples.
+template <concepts::record R>
+class record_span : public std::ranges::view_interface<record_span<R>>
+{
+public:
+  static constexpr size_t k_cache_line = 64;
+
+  class iterator
+  {
+  public:
+    using iterator_concept  = std::random_access_iterator_tag;
+    using iterator_category = std::input_iterator_tag;          // Dereferencing yields a prvalue, as with transform.
+    using value_type        = R;
+    using difference_type   = std::ptrdiff_t;
+
+    iterator() = default;
+    iterator(mem_t const* ptr, size_t stride) : ptr_{ptr}, stride_{(difference_type)stride} {}
+
+    R operator*() const { return R{ptr_}; }
+    R operator[](difference_type n) const { return R{ptr_ + n * stride_}; }
+
+    iterator& operator++() { ptr_ += stride_; return *this; }
+    iterator& operator--() { ptr_ -= stride_; return *this; }
+    iterator operator++(int) { auto tmp = *this; ptr_ += stride_; return tmp; }
+    iterator operator--(int) { auto tmp = *this; ptr_ -= stride_; return tmp; }
+
+    iterator& operator+=(difference_type n) { ptr_ += n * stride_; return *this; }
+    iterator& operator-=(difference_type n) { ptr_ -= n * stride_; return *this; }
+
+    friend iterator operator+(iterator it, difference_type n) { return it += n; }
+    friend iterator operator+(difference_type n, iterator it) { return it += n; }
+    friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+    friend difference_type operator-(iterator const& a, iterator const& b) {
+      BOOST_ASSERT(a.stride_ == b.stride_);
+      return (a.ptr_ - b.ptr_) / a.stride_;
+    }
+
+    bool operator==(iterator const& other) const { return ptr_ == other.ptr_; }
+    auto operator<=>(iterator const& other) const { return ptr_ <=> other.ptr_; }
+
+    mem_t const* mem() const { return ptr_; }
+
+  private:
+    mem_t const* ptr_ = nullptr;
+    difference_type stride_ = 0;
+  };
+
+  record_span() = default;
+
+  record_span(mem_t const* base, size_t stride, size_t count)
+    : base_{base},
+      stride_{stride},
+      count_{count},
+      grain_{period(stride)}
+  {
+    BOOST_ASSERT(stride > 0);
+  }
+
+  // Every whole record in memory.
+  record_span(mspan memory, descriptor const& d)
+    : record_span{memory.data(), d.mem_size(), memory.size() / d.mem_size()}
+  {}
+
+  // TBB splitting constructor, takes the upper part of other.
+  record_span(record_span& other, tbb::split)
+    : record_span{other}
+  {
+    BOOST_ASSERT(other.is_divisible());
+    auto const mid = split_point(other.count_);
+    *this = other.subspan(mid);
+    other.count_ = mid;
+  }
+
+  iterator begin() const { return {base_, stride_}; }
+  iterator end() const { return {base_ + count_ * stride_, stride_}; }
+
+  size_t size() const { return count_; }
+  bool empty() const { return count_ == 0; }
+  mem_t const* data() const { return base_; }
+  size_t stride() const { return stride_; }
+  size_t size_bytes() const { return count_ * stride_; }
+
+  R operator[](size_t i) const { BOOST_ASSERT(i < count_); return R{base_ + i * stride_}; }
+
+  record_span subspan(size_t offset, size_t count = std::dynamic_extent) const
+  {
+    BOOST_ASSERT(offset <= count_);
+    count = std::min(count, count_ - offset);
+    auto s = *this;
+    s.base_ += offset * stride_;
+    s.count_ = count;
+    return s;
+  }
+  record_span first(size_t count) const { BOOST_ASSERT(count <= count_); return subspan(0, count); }
+  record_span last(size_t count) const  { BOOST_ASSERT(count <= count_); return subspan(count_ - count); }
+
+  // TBB Range interface. A span is split into chunks of at least grain() records, where the grain is always a multiple
+  // of period(), so when base is cache line aligned no two TBB tasks write to the same cache line.
+  bool is_divisible() const { return count_ >= 2 * grain_; }
+  size_t grain() const { return grain_; }
+
+  // Copy of this span that splits into chunks of at least the given number of records (rounded up to the period).
+  record_span with_grain(size_t records) const
+  {
+    auto s = *this;
+    auto const p = period(stride_);
+    s.grain_ = std::max<size_t>(1, (records + p - 1) / p) * p;
+    return s;
+  }
+
+  // Smallest number of records spanning a whole number of cache lines.
+  static constexpr size_t period(size_t stride) { return k_cache_line / std::gcd(stride, k_cache_line); }
+
+private:
+  size_t split_point(size_t count) const
+  {
+    return (count / 2) / grain_ * grain_;    // At least grain_ as count >= 2 * grain_.
+  }
+
+  mem_t const* base_ = nullptr;
+  size_t stride_ = 1;
+  size_t count_ = 0;
+  size_t grain_ = 1;
+};
+
+} // namespace rdf
+
+template <rdf::concepts::record R>
+inline constexpr bool std::ranges::enable_borrowed_range<rdf::record_span<R>> = true;
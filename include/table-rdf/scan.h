@@ -0,0 +1,350 @@
+#pragma once
+#include "record_span.h"
+#include "selection.h"
+
+#include <oneapi/tbb.h>
+
+#if TRDF_HAS_AVX2
+  #include <immintrin.h>
+#endif
+
+namespace rdf
+{
+
+enum class compare_op { eq, ne, lt, le, gt, ge };
+
+// Filters over a numeric or timestamp field of a record range, producing a selection with bit i set when record i
+// matches, e.g.
+//   auto s = select<Float64>(records, price, compare_op::gt, 100.0)
+//          & select_between<Timestamp>(records, ts, from, to)
+//          & select_in<Uint32>(records, venue, {1, 4, 7});
+// Records are scanned 64 at a time, one selection word. The field is gathered from the strided records into a dense
+// block (AVX2 / AVX-512 gathers for 4 and 8 byte fields), compared a vector at a time and the comparison masks are
+// packed into the word, so there is no branch per record. Words are distributed over TBB workers.
+// Other field types use the same blocks with scalar, branch-free comparisons.
+
+namespace kernels {
+
+  // Value type compared by the kernels: timestamps as raw ticks, Float32 / Float64 as the builtin types the
+  // intrinsics take.
+  template <types::type T>
+  using scan_value_t = std::conditional_t<T == types::Timestamp, raw_time_t,
+                       std::conditional_t<T == types::Float32, float,
+                       std::conditional_t<T == types::Float64, double, types::value_t<T>>>>;
+
+  template <class V>
+  inline constexpr bool k_vectorized = (TRDF_HAS_AVX2 || TRDF_HAS_AVX512) &&
+    (std::is_same_v<V, int32_t> || std::is_same_v<V, uint32_t> || std::is_same_v<V, int64_t> ||
+     std::is_same_v<V, uint64_t> || std::is_same_v<V, float> || std::is_same_v<V, double>);
+
+  // Index vectors of 32-bit byte offsets limit the stride for 4 byte gathers.
+  inline constexpr size_t k_max_gather_stride = INT32_MAX / 16;
+
+  // In-sets up to this size are compared value by value, larger sets are binary searched.
+  inline constexpr size_t k_max_vector_in = 16;
+
+  template <class V>
+  struct predicate
+  {
+    enum kind_t { compare, between, in };
+
+    kind_t kind_;
+    compare_op op_;
+    V a_;                     // Compare operand or lower bound.
+    V b_;                     // Upper bound.
+    std::vector<V> set_;      // Sorted.
+  };
+
+  template <compare_op Op, class V>
+  constexpr bool compare(V v, V a)
+  {
+    if constexpr (Op == compare_op::eq) return v == a;
+    if constexpr (Op == compare_op::ne) return v != a;
+    if constexpr (Op == compare_op::lt) return v < a;
+    if constexpr (Op == compare_op::le) return v <= a;
+    if constexpr (Op == compare_op::gt) return v > a;
+    if constexpr (Op == compare_op::ge) return v >= a;
+  }
+
+  // Copy n <= 64 values of V at p, p + stride, ... into the 64-byte aligned block out, zero filling the rest.
+  template <class V>
+  inline void gather(V* out, mem_t const* p, size_t stride, size_t n)
+  {
+    if constexpr (k_vectorized<V>)
+    {
+      if (n == 64 && stride <= k_max_gather_stride)
+      {
+#if TRDF_HAS_AVX512
+        if constexpr (sizeof(V) == 8) {
+          auto const idx = _mm512_set_epi64(7 * stride, 6 * stride, 5 * stride, 4 * stride,
+                                            3 * stride, 2 * stride, stride, 0);
+          for (size_t i = 0; i < 64; i += 8, p += 8 * stride) {
+            _mm512_store_si512(out + i, _mm512_i64gather_epi64(idx, p, 1));
+          }
+        }
+        else {
+          auto const s = (int)stride;
+          auto const idx = _mm512_set_epi32(15 * s, 14 * s, 13 * s, 12 * s, 11 * s, 10 * s, 9 * s, 8 * s,
+                                            7 * s, 6 * s, 5 * s, 4 * s, 3 * s, 2 * s, s, 0);
+          for (size_t i = 0; i < 64; i += 16, p += 16 * stride) {
+            _mm512_store_si512(out + i, _mm512_i32gather_epi32(idx, p, 1));
+          }
+        }
+#elif TRDF_HAS_AVX2
+        if constexpr (sizeof(V) == 8) {
+          auto const idx = _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0);
+          for (size_t i = 0; i < 64; i += 4, p += 4 * stride) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(out + i),
+                               _mm256_i64gather_epi64(reinterpret_cast<long long const*>(p), idx, 1));
+          }
+        }
+        else {
+          auto const s = (int)stride;
+          auto const idx = _mm256_set_epi32(7 * s, 6 * s, 5 * s, 4 * s, 3 * s, 2 * s, s, 0);
+          for (size_t i = 0; i < 64; i += 8, p += 8 * stride) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(out + i),
+                               _mm256_i32gather_epi32(reinterpret_cast<int const*>(p), idx, 1));
+          }
+        }
+#endif
+        return;
+      }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+      std::memcpy(out + i, p + i * stride, sizeof(V));
+    }
+    std::fill(out + n, out + 64, V{});
+  }
+
+#if TRDF_HAS_AVX512
+  template <compare_op Op>
+  inline constexpr int k_int_predicate = Op == compare_op::eq ? _MM_CMPINT_EQ  : Op == compare_op::ne ? _MM_CMPINT_NE :
+                                         Op == compare_op::lt ? _MM_CMPINT_LT  : Op == compare_op::le ? _MM_CMPINT_LE :
+                                         Op == compare_op::gt ? _MM_CMPINT_NLE : _MM_CMPINT_NLT;
+#endif
+#if TRDF_HAS_AVX2
+  // Ordered compares, except ne which is true for NaN as in C++.
+  template <compare_op Op>
+  inline constexpr int k_fp_predicate = Op == compare_op::eq ? _CMP_EQ_OQ : Op == compare_op::ne ? _CMP_NEQ_UQ :
+                                        Op == compare_op::lt ? _CMP_LT_OQ : Op == compare_op::le ? _CMP_LE_OQ :
+                                        Op == compare_op::gt ? _CMP_GT_OQ : _CMP_GE_OQ;
+#endif
+
+  // Bit i set when v[i] Op a, for a block of 64 values.
+  template <compare_op Op, class V>
+  inline uint64_t compare_block(V const* v, V a)
+  {
+    uint64_t bits = 0;
+
+    if constexpr (k_vectorized<V>)
+    {
+#if TRDF_HAS_AVX512
+      constexpr size_t lanes = 64 / sizeof(V);
+      for (size_t i = 0; i < 64; i += lanes)
+      {
+        uint64_t m;
+        if constexpr (std::is_same_v<V, float>)
+          m = _mm512_cmp_ps_mask(_mm512_load_ps(v + i), _mm512_set1_ps(a), k_fp_predicate<Op>);
+        else if constexpr (std::is_same_v<V, double>)
+          m = _mm512_cmp_pd_mask(_mm512_load_pd(v + i), _mm512_set1_pd(a), k_fp_predicate<Op>);
+        else if constexpr (std::is_same_v<V, int32_t>)
+          m = _mm512_cmp_epi32_mask(_mm512_load_si512(v + i), _mm512_set1_epi32(a), k_int_predicate<Op>);
+        else if constexpr (std::is_same_v<V, uint32_t>)
+          m = _mm512_cmp_epu32_mask(_mm512_load_si512(v + i), _mm512_set1_epi32((int)a), k_int_predicate<Op>);
+        else if constexpr (std::is_same_v<V, int64_t>)
+          m = _mm512_cmp_epi64_mask(_mm512_load_si512(v + i), _mm512_set1_epi64(a), k_int_predicate<Op>);
+        else
+          m = _mm512_cmp_epu64_mask(_mm512_load_si512(v + i), _mm512_set1_epi64((long long)a), k_int_predicate<Op>);
+        bits |= m << i;
+      }
+      return bits;
+#elif TRDF_HAS_AVX2
+      constexpr size_t lanes = 32 / sizeof(V);
+      for (size_t i = 0; i < 64; i += lanes)
+      {
+        uint64_t m;
+        if constexpr (std::is_same_v<V, float>) {
+          m = (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(_mm256_load_ps(v + i), _mm256_set1_ps(a), k_fp_predicate<Op>));
+        }
+        else if constexpr (std::is_same_v<V, double>) {
+          m = (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(_mm256_load_pd(v + i), _mm256_set1_pd(a), k_fp_predicate<Op>));
+        }
+        else
+        {
+          // Only signed eq and gt exist, unsigned values are biased into signed order and the other predicates
+          // are derived by swapping operands and inverting the mask.
+          constexpr bool wide = sizeof(V) == 8;
+          auto x = _mm256_load_si256(reinterpret_cast<__m256i const*>(v + i));
+          auto y = wide ? _mm256_set1_epi64x((long long)a) : _mm256_set1_epi32((int)a);
+          if constexpr (std::is_unsigned_v<V>) {
+            auto const bias = wide ? _mm256_set1_epi64x(INT64_MIN) : _mm256_set1_epi32(INT32_MIN);
+            x = _mm256_xor_si256(x, bias);
+            y = _mm256_xor_si256(y, bias);
+          }
+          auto const eq = [](__m256i l, __m256i r) { return wide ? _mm256_cmpeq_epi64(l, r) : _mm256_cmpeq_epi32(l, r); };
+          auto const gt = [](__m256i l, __m256i r) { return wide ? _mm256_cmpgt_epi64(l, r) : _mm256_cmpgt_epi32(l, r); };
+          auto const movemask = [](__m256i c) {
+            return (uint64_t)(wide ? _mm256_movemask_pd(_mm256_castsi256_pd(c)) : _mm256_movemask_ps(_mm256_castsi256_ps(c)));
+          };
+
+          constexpr bool invert = Op == compare_op::ne || Op == compare_op::le || Op == compare_op::ge;
+          if constexpr (Op == compare_op::eq || Op == compare_op::ne) m = movemask(eq(x, y));
+          if constexpr (Op == compare_op::gt || Op == compare_op::le) m = movemask(gt(x, y));
+          if constexpr (Op == compare_op::lt || Op == compare_op::ge) m = movemask(gt(y, x));
+          if constexpr (invert) {
+            m ^= (uint64_t{1} << lanes) - 1;
+          }
+        }
+        bits |= m << i;
+      }
+      return bits;
+#endif
+    }
+
+    for (size_t i = 0; i < 64; ++i) {
+      bits |= uint64_t{compare<Op>(v[i], a)} << i;
+    }
+    return bits;
+  }
+
+  template <class V>
+  inline uint64_t compare_block(V const* v, compare_op op, V a)
+  {
+    switch (op)
+    {
+      case compare_op::eq: return compare_block<compare_op::eq>(v, a);
+      case compare_op::ne: return compare_block<compare_op::ne>(v, a);
+      case compare_op::lt: return compare_block<compare_op::lt>(v, a);
+      case compare_op::le: return compare_block<compare_op::le>(v, a);
+      case compare_op::gt: return compare_block<compare_op::gt>(v, a);
+      case compare_op::ge: return compare_block<compare_op::ge>(v, a);
+    }
+    return 0;
+  }
+
+  // Bit i set when v[i] satisfies p, for a block of 64 values.
+  template <class V>
+  inline uint64_t match_block(V const* v, predicate<V> const& p)
+  {
+    switch (p.kind_)
+    {
+      case predicate<V>::compare:
+        return compare_block(v, p.op_, p.a_);
+
+      case predicate<V>::between:
+        return compare_block<compare_op::ge>(v, p.a_) & compare_block<compare_op::le>(v, p.b_);
+
+      case predicate<V>::in:
+      {
+        uint64_t bits = 0;
+        if (p.set_.size() <= k_max_vector_in) {
+          for (auto s : p.set_) {
+            bits |= compare_block<compare_op::eq>(v, s);
+          }
+        }
+        else {
+          for (size_t i = 0; i < 64; ++i) {
+            bits |= uint64_t{std::binary_search(p.set_.begin(), p.set_.end(), v[i])} << i;
+          }
+        }
+        return bits;
+      }
+    }
+    return 0;
+  }
+
+  template <class V>
+  inline void scan(record_span<record> const& records, field const& f, predicate<V> const& p, selection& out)
+  {
+    // 64 words (4096 records) per TBB task.
+    constexpr size_t k_grain_words = 64;
+
+    auto const words = out.words();
+    auto const stride = records.stride();
+    auto const base = records.data() + f.offset();
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, words.size(), k_grain_words),
+      [&](tbb::blocked_range<size_t> const& range)
+      {
+        alignas(64) std::array<V, 64> block;
+        for (auto w = range.begin(); w < range.end(); ++w)
+        {
+          auto const n = std::min<size_t>(64, records.size() - w * 64);
+          gather(block.data(), base + w * 64 * stride, stride, n);
+          words[w] = match_block(block.data(), p) & (n == 64 ? ~uint64_t{0} : (uint64_t{1} << n) - 1);
+        }
+      });
+  }
+
+  template <types::type T>
+  inline auto scan_value(types::value_t<T> value)
+  {
+    if constexpr (T == types::Timestamp) {
+      return value.time_since_epoch().count();
+    }
+    else {
+      return (scan_value_t<T>)value;
+    }
+  }
+
+  template <types::type T>
+  inline void check_type(field const& f, char const* operation)
+  {
+    if (f.type() != T) {
+      throw std::runtime_error(fmt::format("cannot {} field '{}' of type '{}' as '{}'",
+                                           operation, f.name(), f.type_name(), types::enum_names_type(T)));
+    }
+  }
+
+  template <types::type T>
+  inline selection scan(record_span<record> const& records, field const& f, predicate<scan_value_t<T>> const& p)
+  {
+    check_type<T>(f, "scan");
+    selection out{records.size()};
+    scan(records, f, p, out);
+    return out;
+  }
+
+} // namespace kernels
+
+// Records where field op value.
+template <types::type T> requires (!types::string_type(T))
+inline selection select(record_span<record> records, field const& f, compare_op op, types::value_t<T> value)
+{
+  using V = kernels::scan_value_t<T>;
+  return kernels::scan<T>(records, f, kernels::predicate<V>{ kernels::predicate<V>::compare, op, kernels::scan_value<T>(value), V{}, {} });
+}
+
+// Records where lo <= field <= hi.
+template <types::type T> requires (!types::string_type(T))
+inline selection select_between(record_span<record> records, field const& f, types::value_t<T> lo, types::value_t<T> hi)
+{
+  using V = kernels::scan_value_t<T>;
+  return kernels::scan<T>(records, f, kernels::predicate<V>{ kernels::predicate<V>::between, compare_op::ge,
+                                                              kernels::scan_value<T>(lo), kernels::scan_value<T>(hi), {} });
+}
+
+// Records where field equals one of values.
+template <types::type T> requires (!types::string_type(T))
+inline selection select_in(record_span<record> records, field const& f, std::span<types::value_t<T> const> values)
+{
+  using V = kernels::scan_value_t<T>;
+  kernels::predicate<V> p{ kernels::predicate<V>::in, compare_op::eq, V{}, V{}, {} };
+  for (auto v : values) {
+    if (auto const s = kernels::scan_value<T>(v); s == s) {     // NaN never matches, and would break the sort.
+      p.set_.push_back(s);
+    }
+  }
+  std::ranges::sort(p.set_);
+  p.set_.erase(std::unique(p.set_.begin(), p.set_.end()), p.set_.end());
+  return kernels::scan<T>(records, f, p);
+}
+
+template <types::type T> requires (!types::string_type(T))
+inline selection select_in(record_span<record> records, field const& f, std::initializer_list<types::value_t<T>> values)
+{
+  return select_in<T>(records, f, std::span<types::value_t<T> const>{values.begin(), values.size()});
+}
+
+} // namespace rdf
@@ -0,0 +1,96 @@
+#pragma once
+#include "common.h"
+
+#include <boost/assert.hpp>
+
+#include <bit>
+#include <span>
+#include <vector>
+
+namespace rdf
+{
+
+// Bitmap of selected records in a record range, bit i for record i. Produced by scan kernels (see scan.h), combined
+// with & | ~ and consumed by later stages such as aggregation. Bits past size() are always clear.
+class selection
+{
+public:
+  selection() = default;
+
+  explicit selection(size_t size, bool value = false)
+    : words_((size + 63) / 64, value ? ~uint64_t{0} : 0),
+      size_{size}
+  {
+    clear_tail();
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  bool test(size_t i) const { BOOST_ASSERT(i < size_); return (words_[i / 64] >> (i % 64)) & 1; }
+  void set(size_t i, bool value = true) {
+    BOOST_ASSERT(i < size_);
+    auto const bit = uint64_t{1} << (i % 64);
+    words_[i / 64] = value ? words_[i / 64] | bit : words_[i / 64] & ~bit;
+  }
+
+  // Number of selected records.
+  size_t count() const {
+    size_t n = 0;
+    for (auto w : words_) {
+      n += std::popcount(w);
+    }
+    return n;
+  }
+
+  selection& operator&=(selection const& other) { combine(other, [](auto a, auto b) { return a & b; }); return *this; }
+  selection& operator|=(selection const& other) { combine(other, [](auto a, auto b) { return a | b; }); return *this; }
+
+  friend selection operator&(selection a, selection const& b) { return a &= b; }
+  friend selection operator|(selection a, selection const& b) { return a |= b; }
+
+  selection operator~() const {
+    auto s = *this;
+    for (auto& w : s.words_) {
+      w = ~w;
+    }
+    s.clear_tail();
+    return s;
+  }
+
+  bool operator==(selection const& other) const = default;
+
+  // Call f(i) for each selected record, in order.
+  template <class F>
+  void for_each(F&& f) const {
+    for (size_t w = 0; w < words_.size(); ++w) {
+      for (auto bits = words_[w]; bits; bits &= bits - 1) {
+        f(w * 64 + std::countr_zero(bits));
+      }
+    }
+  }
+
+  // 64 records per word, for kernels.
+  std::span<uint64_t>       words()       { return words_; }
+  std::span<uint64_t const> words() const { return words_; }
+
+private:
+  template <class Op>
+  void combine(selection const& other, Op op) {
+    BOOST_ASSERT(size_ == other.size_);
+    for (size_t i = 0; i < words_.size(); ++i) {
+      words_[i] = op(words_[i], other.words_[i]);
+    }
+  }
+
+  void clear_tail() {
+    if (size_ % 64) {
+      words_.back() &= (uint64_t{1} << (size_ % 64)) - 1;
+    }
+  }
+
+  std::vector<uint64_t> words_;
+  size_t size_ = 0;
+};
+
+} // namespace rdf
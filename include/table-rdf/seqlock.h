@@ -0,0 +1,118 @@
+#pragma once
+#include "field.h"
+
+#include <atomic>
+#include <thread>
+
+namespace rdf
+{
+
+// Sequence lock over a 64-bit counter that lives in shared (e.g. mapped) memory, so it can guard a single record or a
+// block of records. The counter is odd while an update is in progress. Readers never block the writer: they copy
+// what they need and retry if the counter was odd or changed meanwhile.
+// Values returned by the read function must not refer into the guarded memory (copy string views).
+namespace seqlock
+{
+  static_assert(std::atomic_ref<uint64_t>::is_always_lock_free);
+
+  // Apply update exclusively. Concurrent writers of the same counter are serialised.
+  template <class F>
+  void write(uint64_t& seq, F&& update)
+  {
+    std::atomic_ref<uint64_t> s{seq};
+    auto v = s.load(std::memory_order_relaxed);
+    for (;;) {
+      if (v & 1) {
+        std::this_thread::yield();
+        v = s.load(std::memory_order_relaxed);
+      }
+      else if (s.compare_exchange_weak(v, v + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    std::atomic_thread_fence(std::memory_order_release);   // Counter is odd before any data store is visible.
+
+    update();
+
+    s.store(v + 2, std::memory_order_release);
+  }
+
+  // Call read until it observes no concurrent update and return its result.
+  template <class F>
+  auto read(uint64_t const& seq, F&& read)
+  {
+    std::atomic_ref<uint64_t> s{const_cast<uint64_t&>(seq)};
+    for (;;)
+    {
+      auto const before = s.load(std::memory_order_acquire);
+      if (before & 1) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      auto result = read();
+
+      std::atomic_thread_fence(std::memory_order_acquire);   // Data loads complete before the counter is re-read.
+      if (s.load(std::memory_order_relaxed) == before) {
+        return result;
+      }
+    }
+  }
+} // namespace seqlock
+
+// Per-record sequence lock whose counter is a Uint64 field of the record, e.g.
+//   builder.push({ "Sequence", "update sequence", Uint64 });
+//   record_seqlock lock{desc.fields("Sequence")};
+//   lock.write(mem, [&] { price.write<Float64>(mem, p); size.write<Int64>(mem, s); });
+//   auto [p, s] = lock.read(mem, [&] { return std::pair{ price.read<Float64>(mem), size.read<Int64>(mem) }; });
+class record_seqlock
+{
+public:
+  explicit record_seqlock(field const& seq)
+    : offset_{seq.offset()}
+  {
+    if (seq.type() != types::Uint64) {
+      throw std::runtime_error(fmt::format("sequence field '{}' must be of type '{}', not '{}'", seq.name(), types::enum_names_type(types::Uint64), seq.type_name()));
+    }
+  }
+
+  template <class F> void write(mem_t* rec, F&& update) const     { seqlock::write(counter(rec), std::forward<F>(update)); }
+  template <class F> auto read(mem_t const* rec, F&& read) const  { return seqlock::read(counter(rec), std::forward<F>(read)); }
+
+  // Single field access. String values are copied before the sequence is validated.
+  template <types::type T> inline auto get(mem_t const* rec, field const& f) const;
+  template <types::type T> inline void set(mem_t* rec, field const& f, types::value_t<T> const value) const;
+
+  // Current sequence number, even when no update is in progress.
+  uint64_t sequence(mem_t const* rec) const { return std::atomic_ref{counter(const_cast<mem_t*>(rec))}.load(std::memory_order_acquire); }
+
+private:
+  uint64_t& counter(mem_t* rec) const { return *reinterpret_cast<uint64_t*>(rec + offset_); }
+  uint64_t const& counter(mem_t const* rec) const { return *reinterpret_cast<uint64_t const*>(rec + offset_); }
+
+  field::offset_t offset_;
+};
+
+template <types::type T>
+auto record_seqlock::get(mem_t const* rec, field const& f) const
+{
+  return read(rec, [&] {
+    if constexpr (types::string_type(T)) {
+      // A torn length prefix can exceed the payload, clamp it so the copy stays within the field.
+      using char_type = types::value_t<T>::value_type;
+      auto const sv = f.read<T>(rec);
+      return std::basic_string<char_type>{sv.data(), std::min(sv.size(), f.payload() / sizeof(char_type))};
+    }
+    else {
+      return f.read<T>(rec);
+    }
+  });
+}
+
+template <types::type T>
+void record_seqlock::set(mem_t* rec, field const& f, types::value_t<T> const value) const
+{
+  write(rec, [&] { f.write<T>(rec, value); });
+}
+
+} // namespace rdf
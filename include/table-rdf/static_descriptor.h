@@ -0,0 +1,203 @@
+#pragma once
+#include "descriptor.h"
+
+#include <tuple>
+#include <utility>
+
+namespace rdf
+{
+
+// A field whose name, type and payload are known at compile time.
+// Read and write take a pointer to the start of the field (i.e. record base + offset), the offset itself is
+// owned by the static_descriptor the field belongs to.
+template <util::fixed_string Name, types::type T, size_t Payload = field::k_no_payload>
+struct static_field
+{
+  using value_type = types::value_t<T>;
+
+  static constexpr std::string_view name    = Name.view();
+  static constexpr types::type      etype   = T;
+  static constexpr size_t           payload = Payload;
+  static constexpr size_t           size    = types::traits<T>::size + Payload;   // As field::size().
+  static constexpr size_t           align   = types::traits<T>::align;
+
+  static_assert(!types::string_type(T) || Payload != field::k_no_payload, "string types require a maximum payload size to be specified");
+  static_assert(types::string_type(T) || Payload == field::k_no_payload, "non-string types should not have a payload");
+
+  static inline void             write(mem_t* ptr, value_type const value);
+  static inline value_type const read(mem_t const* ptr);
+
+  // Runtime equivalent of this field, used when converting to a descriptor.
+  static field make_field() { return field{std::string{name}, "", T, Payload}; }
+};
+
+// Compile-time counterpart of rdf::descriptor.
+// The layout is computed in constexpr using the same rules as the descriptor constructor, so every field access
+// compiles down to a load / store at a constant offset with no descriptor lookups or runtime validation.
+// Use to_descriptor() to obtain an equivalent runtime descriptor for interop with the rest of the library.
+template <bool Pack, class... Fields>
+class static_descriptor
+{
+public:
+  static constexpr size_t k_count = sizeof...(Fields);
+  static_assert(k_count > 0, "descriptor must have at least one field");
+
+  template <size_t I> using field_t = std::tuple_element_t<I, std::tuple<Fields...>>;
+  template <size_t I> using value_t = typename field_t<I>::value_type;
+
+private:
+  struct layout
+  {
+    std::array<field::offset_t, k_count> offsets_;
+    size_t mem_size_;
+    size_t mem_align_;
+  };
+
+  static constexpr size_t align_up(size_t v, size_t align) { return (v + align - 1) & ~(align - 1); }
+
+  // Mirrors descriptor::descriptor(), see there for the layout rules.
+  static constexpr layout compute_layout()
+  {
+    constexpr std::array<size_t, k_count> sizes  { Fields::size... };
+    constexpr std::array<size_t, k_count> aligns { Fields::align... };
+
+    std::array<size_t, k_count> indices{};
+    for (size_t i = 0; i < k_count; ++i) {
+      indices[i] = i;
+    }
+
+    if constexpr (Pack)
+    {
+      // Stable insertion sort by descending alignment (std::ranges::stable_sort is not constexpr).
+      for (size_t i = 1; i < k_count; ++i) {
+        for (size_t j = i; j > 0 && aligns[indices[j - 1]] < aligns[indices[j]]; --j) {
+          std::swap(indices[j - 1], indices[j]);
+        }
+      }
+    }
+
+    layout l{};
+    l.offsets_[indices[0]] = 0;
+    l.mem_align_ = aligns[indices[0]];
+    for (size_t i = 1; i < k_count; ++i)
+    {
+      auto const a = indices[i - 1];
+      auto const b = indices[i];
+      l.offsets_[b] = align_up(l.offsets_[a] + sizes[a], aligns[b]);
+      l.mem_align_ = std::max(l.mem_align_, aligns[b]);
+    }
+
+    auto const last = indices[k_count - 1];
+    l.mem_size_ = align_up(l.offsets_[last] + sizes[last], l.mem_align_);
+    return l;
+  }
+
+  static constexpr layout k_layout = compute_layout();
+
+  static constexpr std::array<std::string_view, k_count> k_names { Fields::name... };
+
+public:
+  static constexpr size_t mem_size() { return k_layout.mem_size_; }
+  static constexpr size_t mem_align() { return k_layout.mem_align_; }
+
+  template <size_t I>
+  static constexpr field::offset_t offset() { static_assert(I < k_count); return k_layout.offsets_[I]; }
+
+  // Index of the field with the given name, a compile error if there is no such field.
+  template <util::fixed_string Name>
+  static constexpr size_t index_of()
+  {
+    constexpr auto index = std::ranges::find(k_names, Name.view()) - k_names.begin();
+    static_assert(index < k_count, "no field with this name in static_descriptor");
+    return index;
+  }
+
+  template <size_t I>
+  static void write(mem_t* base, value_t<I> const value) { field_t<I>::write(base + offset<I>(), value); }
+
+  template <size_t I>
+  static value_t<I> const read(mem_t const* base) { return field_t<I>::read(base + offset<I>()); }
+
+  template <util::fixed_string Name>
+  static void write(mem_t* base, value_t<index_of<Name>()> const value) { write<index_of<Name>()>(base, value); }
+
+  template <util::fixed_string Name>
+  static value_t<index_of<Name>()> const read(mem_t const* base) { return read<index_of<Name>()>(base); }
+
+  // Build the equivalent runtime descriptor. Field descriptions are empty and formats are the field defaults.
+  static descriptor to_descriptor(std::string const& name)
+  {
+    return descriptor{name, std::vector<field>{ Fields::make_field()... }, Pack};
+  }
+
+  // True if the runtime descriptor d has the same field types and memory layout as this static descriptor.
+  static bool matches(descriptor const& d)
+  {
+    if (d.fields().size() != k_count || d.mem_size() != mem_size() || d.mem_align() != mem_align()) {
+      return false;
+    }
+    return [&]<size_t... I>(std::index_sequence<I...>) {
+      return ((d.fields(I).type() == field_t<I>::etype &&
+               d.fields(I).payload() == field_t<I>::payload &&
+               d.fields(I).offset() == offset<I>()) && ...);
+    }(std::make_index_sequence<k_count>{});
+  }
+};
+
+template <util::fixed_string Name, types::type T, size_t Payload>
+void static_field<Name, T, Payload>::write(mem_t* ptr, value_type const value)
+{
+  BOOST_ASSERT(bal::is_aligned(ptr, align));
+
+  if constexpr (concepts::string<value_type>) {
+    using char_type = value_type::value_type;
+    using prefix_t = traits<T>::prefix_t;
+    constexpr auto k_payload_offset = std::max(sizeof(prefix_t), sizeof(char_type));   // As field::write_str().
+
+    auto const length = value.length() * sizeof(char_type);
+    if (length > Payload) {
+      throw std::runtime_error("string too large for payload");
+    }
+    else if (length != (prefix_t)length) {
+      throw std::runtime_error(fmt::format("string of type '{}' has length {} that does not fit in {}-bits", enum_names_type(T), length, sizeof(prefix_t) * 8));
+    }
+
+    *reinterpret_cast<prefix_t*>(ptr) = (prefix_t)length;
+    std::memcpy(ptr + k_payload_offset, value.data(), length);
+  }
+  else if constexpr (concepts::numeric<value_type> || concepts::string_ref<value_type>) {
+    *reinterpret_cast<value_type*>(ptr) = value;
+  }
+  else if constexpr (concepts::timestamp<value_type>) {
+    *reinterpret_cast<raw_time_t*>(ptr) = value.time_since_epoch().count();
+  }
+  else {
+    static_assert(util::always_false_v<value_type>, "unsupported field value type");
+  }
+}
+
+template <util::fixed_string Name, types::type T, size_t Payload>
+typename static_field<Name, T, Payload>::value_type const static_field<Name, T, Payload>::read(mem_t const* ptr)
+{
+  BOOST_ASSERT(bal::is_aligned(ptr, align));
+
+  if constexpr (concepts::string<value_type>) {
+    using char_type = value_type::value_type;
+    using prefix_t = traits<T>::prefix_t;
+    constexpr auto k_payload_offset = std::max(sizeof(prefix_t), sizeof(char_type));
+
+    auto const length = *reinterpret_cast<prefix_t const*>(ptr) / sizeof(char_type);
+    return { reinterpret_cast<char_type const*>(ptr + k_payload_offset), length };
+  }
+  else if constexpr (concepts::numeric<value_type> || concepts::string_ref<value_type>) {
+    return *reinterpret_cast<value_type const*>(ptr);
+  }
+  else if constexpr (concepts::timestamp<value_type>) {
+    return timestamp_t{ timestamp_t::duration{ *reinterpret_cast<raw_time_t const*>(ptr) } };
+  }
+  else {
+    static_assert(util::always_false_v<value_type>, "unsupported field value type");
+  }
+}
+
+} // namespace rdf
@@ -0,0 +1,114 @@
+#pragma once
+#include "record_span.h"
+
+namespace rdf
+{
+
+// Per table heap of the strings of StringRef fields, so records hold a fixed 16 byte string_ref rather than
+// reserving the maximum payload of a String8 / String16 field, and there is no maximum length. Strings of up to
+// string_ref::k_inline bytes never reach the arena. The arena only grows, offsets stay valid for its lifetime, e.g.
+//   string_arena names;
+//   names.write(desc.fields("Name"), mem, "International Business Machines");
+//   string_t const name = names.read(desc.fields("Name"), mem);     // No copy.
+// Like std::vector, an append may move the heap and so invalidates views of out of line strings. Appends must not
+// run concurrently with each other or with reads.
+class string_arena
+{
+public:
+  string_arena() = default;
+
+  // A copy of the bytes() of another arena, e.g. stored alongside a table file.
+  explicit string_arena(std::span<mem_t const> bytes) : heap_{bytes.begin(), bytes.end()} {}
+
+  // Reference to s, appending it to the arena unless it fits inline.
+  inline string_ref append(string_t s);
+
+  // Appends the strings of other, returning the offset they now start at. References into other are moved here by
+  // rebase(), e.g. when strings were added to per thread arenas.
+  inline uint64_t append(string_arena const& other);
+  static inline string_ref rebase(string_ref ref, uint64_t base);
+
+  // The string of ref. Inline strings are viewed in ref itself, which must outlive the view.
+  inline string_t view(string_ref const& ref) const;
+
+  // True if ref is s. Lengths and prefixes are compared first, so most mismatches never read the arena.
+  inline bool equal(string_ref const& ref, string_t s) const;
+
+  // Field access, f must be a StringRef field. read() views the record memory or the arena.
+  void write(field const& f, mem_t* mem, string_t s) { f.write<types::StringRef>(mem, append(s)); }
+  string_t read(field const& f, mem_t const* mem) const { return view(*ref(f, mem)); }
+  bool equal(field const& f, mem_t const* mem, string_t s) const { return equal(*ref(f, mem), s); }
+
+  size_t size_bytes() const { return heap_.size(); }
+  std::span<mem_t const> bytes() const { return heap_; }
+
+  void reserve(size_t bytes) { heap_.reserve(bytes); }
+  void clear() { heap_.clear(); }
+
+private:
+  static string_ref const* ref(field const& f, mem_t const* mem) {
+    BOOST_ASSERT(f.type() == types::StringRef);
+    return f.offset_ptr<string_ref>(mem);
+  }
+
+  std::vector<mem_t> heap_;
+};
+
+string_ref string_arena::append(string_t s)
+{
+  if (s.size() > UINT32_MAX) {
+    throw std::runtime_error(fmt::format("string of length {} is too long for a string_ref", s.size()));
+  }
+
+  string_ref ref;
+  ref.length_ = (uint32_t)s.size();
+  if (ref.inlined()) {
+    std::memcpy(ref.data_, s.data(), s.size());
+  }
+  else {
+    uint64_t const offset = heap_.size();
+    std::memcpy(ref.data_, s.data(), string_ref::k_prefix);
+    std::memcpy(ref.data_ + string_ref::k_prefix, &offset, sizeof(offset));
+    auto const bytes = reinterpret_cast<mem_t const*>(s.data());
+    heap_.insert(heap_.end(), bytes, bytes + s.size());
+  }
+  return ref;
+}
+
+uint64_t string_arena::append(string_arena const& other)
+{
+  uint64_t const base = heap_.size();
+  heap_.insert(heap_.end(), other.heap_.begin(), other.heap_.end());
+  return base;
+}
+
+string_ref string_arena::rebase(string_ref ref, uint64_t base)
+{
+  if (!ref.inlined()) {
+    auto const offset = ref.offset() + base;
+    std::memcpy(ref.data_ + string_ref::k_prefix, &offset, sizeof(offset));
+  }
+  return ref;
+}
+
+string_t string_arena::view(string_ref const& ref) const
+{
+  if (ref.inlined()) {
+    return { ref.data_, ref.length_ };
+  }
+  BOOST_ASSERT(ref.offset() + ref.length_ <= heap_.size());
+  return { reinterpret_cast<char const*>(heap_.data() + ref.offset()), ref.length_ };
+}
+
+bool string_arena::equal(string_ref const& ref, string_t s) const
+{
+  if (ref.length_ != s.size()) {
+    return false;
+  }
+  if (ref.inlined()) {
+    return std::memcmp(ref.data_, s.data(), s.size()) == 0;
+  }
+  return std::memcmp(ref.data_, s.data(), string_ref::k_prefix) == 0 && view(ref) == s;
+}
+
+} // namespace rdf
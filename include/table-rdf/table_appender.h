@@ -0,0 +1,99 @@
+#pragma once
+#include "table_file.h"
+
+namespace rdf
+{
+
+// Single writer that appends records to a table file while other threads or processes read it.
+// Records are written past the committed count and become visible to readers when publish() stores the new count
+// with release semantics, so a reader of table_file::size() never sees a partially written record and takes no lock.
+// With notify, publish() also updates the file's modification time so that a table_follower blocked on a change
+// notification wakes up. It costs a system call per publish, so it is off unless a follower relies on inotify. The
+// file grows in extents of at least extent bytes to keep resizing and remapping off the per-record path.
+class table_appender
+{
+public:
+  static constexpr size_t k_default_extent = 64 * 1024 * 1024;
+
+  // Takes ownership of a file opened with table_file::mode::read_write.
+  inline explicit table_appender(table_file&& file, size_t extent = k_default_extent, bool notify = false);
+
+  table_file const& file() const { return file_; }
+
+  size_t committed() const { return committed_; }    // Records visible to readers.
+  size_t pending() const { return end_ - committed_; } // Records written by next() but not yet published.
+
+  // Space for count records following any pending ones. Pointers are invalidated by the next call that grows the file.
+  inline mem_t* next(size_t count = 1);
+
+  // Make all pending records visible to readers.
+  inline void publish();
+
+  // Copy count contiguous records and publish them.
+  inline void append(mem_t const* rows, size_t count);
+
+private:
+  inline void reserve(size_t count);
+
+  table_file file_;
+  size_t extent_;
+  bool notify_;
+  size_t committed_;
+  size_t end_;
+};
+
+table_appender::table_appender(table_file&& file, size_t extent, bool notify)
+  : file_{std::move(file)},
+    extent_{std::max(extent, file_.desc().mem_size())},
+    notify_{notify},
+    committed_{file_.committed()},
+    end_{committed_}
+{
+  if (!file_.writable()) {
+    throw std::runtime_error(fmt::format("table file '{}' must be opened read_write to append", file_.path().string()));
+  }
+}
+
+void table_appender::reserve(size_t count)
+{
+  namespace bal = boost::alignment;
+
+  auto const mem_size = file_.desc().mem_size();
+  if (end_ + count <= file_.capacity()) {
+    return;
+  }
+
+  // The count in the header is not changed here, readers only see the larger file.
+  auto const needed = (end_ + count) * mem_size;
+  auto const records_bytes = (needed + extent_ - 1) / extent_ * extent_;
+  std::filesystem::resize_file(file_.path(), file_.header().records_offset_ + records_bytes);
+  file_.remap();
+  BOOST_ASSERT(end_ + count <= file_.capacity());
+}
+
+mem_t* table_appender::next(size_t count)
+{
+  reserve(count);
+  auto const mem = file_.data() + end_ * file_.desc().mem_size();
+  end_ += count;
+  return mem;
+}
+
+void table_appender::publish()
+{
+  if (end_ != committed_) {
+    file_.count().store(end_, std::memory_order_release);
+    if (notify_) {
+      file_.touch();
+    }
+    committed_ = end_;
+  }
+}
+
+void table_appender::append(mem_t const* rows, size_t count)
+{
+  std::memcpy(next(count), rows, count * file_.desc().mem_size());
+  publish();
+}
+
+} // namespace rdf
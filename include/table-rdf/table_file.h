@@ -0,0 +1,300 @@
+#pragma once
+#include "descriptor.h"
+#include "record_span.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#if !defined(_WIN32)
+  #include <sys/stat.h>
+#endif
+
+#include <atomic>
+#include <bit>
+#include <filesystem>
+#include <fstream>
+
+namespace rdf
+{
+
+// Fixed size header at the start of a table file, followed by the serialized descriptor and then the record region.
+// Integers are native endian, k_magic doubles as an endianness check.
+struct table_header
+{
+  static constexpr uint64_t k_magic = 0x3146'4452'2d4c'4254;    // "TBL-RDF1" in little endian.
+  static constexpr uint32_t k_version = 1;
+
+  uint64_t magic_;
+  uint32_t version_;
+  uint32_t header_size_;        // sizeof(table_header).
+  uint64_t descriptor_size_;    // Bytes of serialized descriptor following the header.
+  uint64_t records_offset_;     // File offset of the first record.
+  uint64_t mem_size_;
+  uint64_t mem_align_;
+  uint64_t count_;              // Number of committed records, only accessed atomically (see table_appender).
+  uint64_t reserved_;
+};
+
+static_assert(sizeof(table_header) == 64);
+static_assert(std::is_trivially_copyable_v<table_header>);
+static_assert(offsetof(table_header, count_) % std::atomic_ref<uint64_t>::required_alignment == 0);
+static_assert(std::atomic_ref<uint64_t>::is_always_lock_free, "the committed count is shared between processes");
+
+// Binary descriptor encoding: name, layout (0 unpacked, 1 packed, 2 hot_cold) and for each field its name, description,
+// format, type, payload and offset, then for a hot_cold layout the field weights. Offsets are recomputed by the
+// descriptor constructor on read and checked against the stored ones, so a file written by a build with a different
+// layout is rejected rather than misread.
+inline std::string write_descriptor(descriptor const& d);
+inline descriptor  read_descriptor(std::span<mem_t const> bytes);
+
+// A table stored in a memory-mapped file:
+//   [table_header][serialized descriptor][padding to k_region_align][count records of desc().mem_size() bytes]
+// open() reads only the header and descriptor, so it is O(1) in the size of the file, and records() is a view
+// directly onto the mapping.
+class table_file
+{
+public:
+  static constexpr size_t k_region_align = 4096;    // Page size, a multiple of any descriptor's mem_align().
+
+  enum class mode { read_only, read_write };
+
+  // Create or truncate a file holding count zero-initialised records.
+  static inline table_file create(std::filesystem::path const& path, descriptor const& desc, size_t count);
+
+  static inline table_file open(std::filesystem::path const& path, mode m = mode::read_only);
+
+  descriptor const& desc() const { return desc_; }
+  std::filesystem::path const& path() const { return path_; }
+  table_header const& header() const { return *reinterpret_cast<table_header const*>(region_.get_address()); }
+
+  // Number of committed records. The count is loaded with acquire semantics, pairing with table_appender::publish(),
+  // so every record in [0, size()) is fully written. Records appended beyond the mapped region are not counted until
+  // remap() is called.
+  size_t size() const { return std::min<size_t>(committed(), capacity()); }
+
+  // Records that fit in the mapped region, including space pre-allocated by an appender.
+  size_t capacity() const { return (region_.get_size() - header().records_offset_) / desc_.mem_size(); }
+
+  bool writable() const { return mode_ == mode::read_write; }
+
+  // Map the whole file again if it has grown. Invalidates pointers into the file. Returns true if remapped.
+  inline bool remap();
+
+  mem_t const* data() const { return static_cast<mem_t const*>(region_.get_address()) + header().records_offset_; }
+  mem_t*       data()       { BOOST_ASSERT(mode_ == mode::read_write); return static_cast<mem_t*>(region_.get_address()) + header().records_offset_; }
+
+  template <concepts::record R = record>
+  record_span<R> records() const { return { data(), desc_.mem_size(), size() }; }
+
+private:
+  friend class table_appender;
+
+  inline table_file(std::filesystem::path const& path, mode m);
+
+  std::atomic_ref<uint64_t> count() const { return std::atomic_ref{const_cast<table_header&>(header()).count_}; }
+  uint64_t committed() const { return count().load(std::memory_order_acquire); }
+
+  // Update the modification time, stores through the mapping do not generate file change notifications.
+  inline void touch() const;
+
+  static auto access(mode m) { return m == mode::read_write ? boost::interprocess::read_write : boost::interprocess::read_only; }
+  static inline descriptor load(boost::interprocess::mapped_region const& region, std::filesystem::path const& path);
+
+  std::filesystem::path path_;
+  mode mode_;
+  boost::interprocess::file_mapping mapping_;
+  boost::interprocess::mapped_region region_;
+  descriptor desc_;
+};
+
+std::string write_descriptor(descriptor const& d)
+{
+  std::string out;
+  auto const put = [&out](uint64_t v) { out.append(reinterpret_cast<char const*>(&v), sizeof(v)); };
+  auto const put_str = [&](std::string_view s) { put(s.size()); out.append(s); };
+
+  put_str(d.name());
+  put((uint64_t)d.layout());
+  put(d.fields().size());
+  for (auto const& f : d.fields()) {
+    put_str(f.name());
+    put_str(f.description());
+    put_str({f.fmt().str.data(), f.fmt().str.size()});
+    put(f.type());
+    put(f.payload());
+    put(f.offset());
+  }
+  if (d.layout() == descriptor::layout_kind::hot_cold) {
+    for (auto const& f : d.fields()) {
+      put(std::bit_cast<uint64_t>(d.weight(f.index())));
+    }
+  }
+  return out;
+}
+
+descriptor read_descriptor(std::span<mem_t const> bytes)
+{
+  auto const get = [&bytes]() {
+    if (bytes.size() < sizeof(uint64_t)) {
+      throw std::runtime_error("truncated descriptor");
+    }
+    uint64_t v;
+    std::memcpy(&v, bytes.data(), sizeof(v));
+    bytes = bytes.subspan(sizeof(v));
+    return v;
+  };
+  auto const get_str = [&]() {
+    auto const length = get();
+    if (bytes.size() < length) {
+      throw std::runtime_error("truncated descriptor");
+    }
+    std::string s{reinterpret_cast<char const*>(bytes.data()), length};
+    bytes = bytes.subspan(length);
+    return s;
+  };
+
+  auto const name = get_str();
+  auto const layout = get();
+  if (layout > (uint64_t)descriptor::layout_kind::hot_cold) {
+    throw std::runtime_error(fmt::format("invalid descriptor layout {}", layout));
+  }
+  auto const count = get();
+
+  fields_builder builder;
+  std::vector<uint64_t> offsets;
+  for (uint64_t i = 0; i < count; ++i)
+  {
+    auto const field_name = get_str();
+    auto const description = get_str();
+    auto const format = util::intern(get_str());    // fmt::runtime() only holds a view.
+    auto const type = get();
+    if (type >= types::type_numof) {
+      throw std::runtime_error(fmt::format("invalid type {} for field '{}'", type, field_name));
+    }
+    auto const payload = get();
+    offsets.push_back(get());
+    builder.push({ field_name, description, (types::type)type, payload, fmt::runtime(format) });
+  }
+
+  auto const make = [&]() {
+    if (layout != (uint64_t)descriptor::layout_kind::hot_cold) {
+      return descriptor{name, builder, layout != 0};
+    }
+    descriptor::field_weights weights;
+    for (auto const& f : builder.get()) {
+      weights.push_back({f.name(), std::bit_cast<double>(get())});
+    }
+    return descriptor{name, builder, weights};
+  };
+
+  auto d = make();
+  for (auto const& f : d.fields()) {
+    if (f.offset() != offsets[f.index()]) {
+      throw std::runtime_error(fmt::format("field '{}' has offset {}, expected {}", f.name(), f.offset(), offsets[f.index()]));
+    }
+  }
+  return d;
+}
+
+table_file::table_file(std::filesystem::path const& path, mode m)
+  : path_{path},
+    mode_{m},
+    mapping_{path.string().c_str(), access(m)},
+    region_{mapping_, access(m)},
+    desc_{load(region_, path)}
+{
+}
+
+bool table_file::remap()
+{
+  if (std::filesystem::file_size(path_) == region_.get_size()) {
+    return false;
+  }
+  region_ = boost::interprocess::mapped_region{mapping_, access(mode_)};
+  return true;
+}
+
+void table_file::touch() const
+{
+#if !defined(_WIN32)
+  ::futimens(mapping_.get_mapping_handle().handle, nullptr);
+#endif
+}
+
+table_file table_file::create(std::filesystem::path const& path, descriptor const& desc, size_t count)
+{
+  namespace ipc = boost::interprocess;
+  namespace bal = boost::alignment;
+
+  auto const serialized = write_descriptor(desc);
+  auto const records_offset = bal::align_up(sizeof(table_header) + serialized.size(), k_region_align);
+
+  {
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    if (!file) {
+      throw std::runtime_error(fmt::format("failed to create table file '{}'", path.string()));
+    }
+  }
+  std::filesystem::resize_file(path, records_offset + count * desc.mem_size());   // Zero filled.
+
+  {
+    ipc::file_mapping mapping{path.string().c_str(), ipc::read_write};
+    ipc::mapped_region region{mapping, ipc::read_write, 0, records_offset};
+    auto const base = static_cast<char*>(region.get_address());
+
+    table_header const header {
+      .magic_           = table_header::k_magic,
+      .version_         = table_header::k_version,
+      .header_size_     = sizeof(table_header),
+      .descriptor_size_ = serialized.size(),
+      .records_offset_  = records_offset,
+      .mem_size_        = desc.mem_size(),
+      .mem_align_       = desc.mem_align(),
+      .count_           = count,
+      .reserved_        = 0
+    };
+    std::memcpy(base, &header, sizeof(header));
+    std::memcpy(base + sizeof(header), serialized.data(), serialized.size());
+  }
+
+  return table_file{path, mode::read_write};
+}
+
+table_file table_file::open(std::filesystem::path const& path, mode m)
+{
+  if (std::filesystem::file_size(path) < sizeof(table_header)) {
+    throw std::runtime_error(fmt::format("'{}' is too small to be a table file", path.string()));
+  }
+  return table_file{path, m};
+}
+
+descriptor table_file::load(boost::interprocess::mapped_region const& region, std::filesystem::path const& path)
+{
+  auto const base = static_cast<mem_t const*>(region.get_address());
+  auto const size = region.get_size();
+
+  table_header header;
+  std::memcpy(&header, base, sizeof(header));
+
+  if (header.magic_ != table_header::k_magic) {
+    throw std::runtime_error(fmt::format("'{}' is not a table file", path.string()));
+  }
+  if (header.version_ != table_header::k_version) {
+    throw std::runtime_error(fmt::format("unsupported version {} of table file '{}'", header.version_, path.string()));
+  }
+  if (header.header_size_ != sizeof(table_header) || header.header_size_ + header.descriptor_size_ > size) {
+    throw std::runtime_error(fmt::format("corrupt header in table file '{}'", path.string()));
+  }
+
+  auto d = read_descriptor({ base + header.header_size_, header.descriptor_size_ });
+
+  if (d.mem_size() != header.mem_size_ || d.mem_align() != header.mem_align_) {
+    throw std::runtime_error(fmt::format("record layout of table file '{}' does not match descriptor '{}'", path.string(), d.name()));
+  }
+  if (header.records_offset_ % k_region_align != 0 || header.records_offset_ + header.count_ * header.mem_size_ > size) {
+    throw std::runtime_error(fmt::format("table file '{}' is truncated", path.string()));
+  }
+  return d;
+}
+
+} // namespace rdf
@@ -0,0 +1,185 @@
+#pragma once
+#include "table_file.h"
+
+#if TRDF_HAS_INOTIFY
+  #include <poll.h>
+  #include <sys/eventfd.h>
+  #include <sys/inotify.h>
+  #include <unistd.h>
+#endif
+
+#include <functional>
+#include <stop_token>
+#include <thread>
+
+namespace rdf
+{
+
+// Follows a table file written by a table_appender and hands each newly committed range of records to subscribers
+// exactly once, in order. The mapping is extended when the file grows.
+// On Linux the follower blocks on inotify, waking when the appender publishes (which touches the file if the appender
+// was made with notify) or grows the file. Since a follower cannot know whether the appender notifies, the wait is
+// still bounded by poll_interval, after which the committed count is checked again. Elsewhere, or when inotify is
+// unavailable, it polls the committed count every poll_interval.
+class table_follower
+{
+public:
+  // Receives the file and the new records [begin, end), e.g. file.records().subspan(begin, end - begin).
+  using subscriber = std::function<void(table_file const& file, size_t begin, size_t end)>;
+
+  static constexpr std::chrono::microseconds k_default_poll_interval = 100ms;
+
+  // Deliver records from index first onwards. use_inotify = false forces polling.
+  inline explicit table_follower(std::filesystem::path const& path,
+                                 size_t first = 0,
+                                 std::chrono::microseconds poll_interval = k_default_poll_interval,
+                                 bool use_inotify = true);
+  inline ~table_follower();
+
+  table_follower(table_follower const&) = delete;
+  table_follower& operator=(table_follower const&) = delete;
+
+  void subscribe(subscriber s) { subscribers_.push_back(std::move(s)); }
+
+  table_file const& file() const { return file_; }
+  size_t position() const { return position_; }     // Records delivered so far, including any skipped by first.
+  bool notified() const { return inotify_fd_ >= 0; }
+
+  // Deliver any records committed since the last call without blocking. Returns the number of records delivered.
+  inline size_t poll();
+
+  // Block until new records are delivered or timeout expires. Returns the number of records delivered.
+  inline size_t wait(std::chrono::microseconds timeout);
+
+  // Deliver records until stop is requested, e.g. std::jthread t{[&](std::stop_token st) { follower.run(st); }}.
+  // With inotify a stop request wakes it at once through an eventfd.
+  inline void run(std::stop_token stop);
+
+private:
+  // Block until the file changes, wake_fd is signalled, or timeout or the poll interval expires.
+  inline void wait_for_change(std::chrono::microseconds timeout, int wake_fd = -1);
+
+  table_file file_;
+  size_t position_;
+  std::chrono::microseconds poll_interval_;
+  std::vector<subscriber> subscribers_;
+  int inotify_fd_ = -1;
+};
+
+table_follower::table_follower(std::filesystem::path const& path,
+                               size_t first,
+                               std::chrono::microseconds poll_interval,
+                               bool use_inotify)
+  : file_{table_file::open(path)},
+    position_{first},
+    poll_interval_{poll_interval}
+{
+#if TRDF_HAS_INOTIFY
+  if (use_inotify) {
+    // The watch is added before the first poll(), so no change after it can be missed.
+    inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ >= 0 && ::inotify_add_watch(inotify_fd_, path.c_str(), IN_MODIFY | IN_ATTRIB) < 0) {
+      ::close(inotify_fd_);
+      inotify_fd_ = -1;
+    }
+  }
+#endif
+}
+
+table_follower::~table_follower()
+{
+#if TRDF_HAS_INOTIFY
+  if (inotify_fd_ >= 0) {
+    ::close(inotify_fd_);
+  }
+#endif
+}
+
+size_t table_follower::poll()
+{
+  // A full mapping may mean the appender has grown the file.
+  if (file_.size() == file_.capacity()) {
+    file_.remap();
+  }
+
+  auto const end = file_.size();
+  if (end <= position_) {
+    return 0;
+  }
+
+  auto const begin = std::exchange(position_, end);
+  for (auto const& s : subscribers_) {
+    s(file_, begin, end);
+  }
+  return end - begin;
+}
+
+void table_follower::wait_for_change(std::chrono::microseconds timeout, int wake_fd)
+{
+#if TRDF_HAS_INOTIFY
+  if (inotify_fd_ >= 0)
+  {
+    pollfd pfds[2]{ { inotify_fd_, POLLIN, 0 }, { wake_fd, POLLIN, 0 } };
+    auto const ms = (int)std::min<int64_t>(std::chrono::ceil<std::chrono::milliseconds>(std::min(timeout, poll_interval_)).count(),
+                                           std::numeric_limits<int>::max());
+    if (::poll(pfds, wake_fd >= 0 ? 2 : 1, ms) > 0 && (pfds[0].revents & POLLIN)) {
+      // Drain the queued events, only the fact that something changed matters.
+      alignas(inotify_event) char buffer[4096];
+      while (::read(inotify_fd_, buffer, sizeof(buffer)) > 0) {}
+    }
+    return;
+  }
+#endif
+  std::this_thread::sleep_for(std::min(timeout, poll_interval_));
+}
+
+size_t table_follower::wait(std::chrono::microseconds timeout)
+{
+  auto const deadline = std::chrono::steady_clock::now() + timeout;
+  for (;;)
+  {
+    if (auto const n = poll()) {
+      return n;
+    }
+    auto const now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return 0;
+    }
+    wait_for_change(std::chrono::ceil<std::chrono::microseconds>(deadline - now));
+  }
+}
+
+void table_follower::run(std::stop_token stop)
+{
+#if TRDF_HAS_INOTIFY
+  if (inotify_fd_ >= 0)
+  {
+    struct wake_event
+    {
+      ~wake_event() { if (fd_ >= 0) ::close(fd_); }
+      int fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    } const wake;
+
+    if (wake.fd_ >= 0)
+    {
+      // Changes after a poll() are queued on the inotify descriptor, so none is missed before the next wait.
+      std::stop_callback const on_stop{stop, [fd = wake.fd_] {
+        uint64_t const one = 1;
+        [[maybe_unused]] auto const n = ::write(fd, &one, sizeof(one));
+      }};
+      while (!stop.stop_requested()) {
+        if (poll() == 0) {
+          wait_for_change(poll_interval_, wake.fd_);
+        }
+      }
+      return;
+    }
+  }
+#endif
+  // Waits are bounded by the poll interval so a stop request is seen promptly.
+  while (!stop.stop_requested()) {
+    wait(poll_interval_);
+  }
+}
+
+} // namespace rdf
@@ -0,0 +1,162 @@
+#pragma once
+#include "record_span.h"
+
+namespace rdf
+{
+
+// Time window lookup over records sorted (non-decreasing) by a Timestamp field, e.g. a table appended in time order.
+// Without an index each bound is found by interpolation search directly over the records, alternating with binary
+// steps whenever an interpolation probe does not shrink the range well, so skewed data costs at most about twice the
+// probes of a binary search.
+// build() adds an optional sparse index holding the first timestamp of every block of records. A bound is then found
+// with a binary search of that small contiguous array and one search within a single block.
+class time_index
+{
+public:
+  static constexpr size_t k_default_block_records = 4096;
+
+  inline explicit time_index(field const& ts);
+
+  // Build the sparse index over records, replacing any previous one.
+  inline void build(record_span<record> records, size_t block_records = k_default_block_records);
+
+  // Extend the sparse index over records appended since build() / update().
+  inline void update(record_span<record> records);
+
+  // First record with a timestamp >= t, or >  t for upper_bound().
+  inline size_t lower_bound(record_span<record> records, timestamp_t t) const;
+  inline size_t upper_bound(record_span<record> records, timestamp_t t) const;
+
+  // Records [begin, end) with timestamps in [from, to).
+  std::pair<size_t, size_t> bounds(record_span<record> records, timestamp_t from, timestamp_t to) const {
+    auto const begin = lower_bound(records, from);
+    return { begin, std::max(begin, lower_bound(records, to)) };
+  }
+  record_span<record> range(record_span<record> records, timestamp_t from, timestamp_t to) const {
+    auto const [begin, end] = bounds(records, from, to);
+    return records.subspan(begin, end - begin);
+  }
+
+  size_t block_records() const { return block_records_; }
+  size_t blocks() const { return firsts_.size(); }
+
+private:
+  raw_time_t time(record_span<record> const& records, size_t i) const { return *ts_.offset_ptr<raw_time_t const>(records[i].cmem()); }
+
+  // First index in [lo, hi) whose timestamp is not less than t (Upper = false) or greater than t (Upper = true).
+  template <bool Upper>
+  inline size_t search(record_span<record> const& records, size_t lo, size_t hi, raw_time_t t) const;
+
+  template <bool Upper>
+  inline size_t bound(record_span<record> const& records, raw_time_t t) const;
+
+  field ts_;
+  size_t block_records_ = 0;
+  std::vector<raw_time_t> firsts_;    // First timestamp of each block.
+};
+
+time_index::time_index(field const& ts)
+  : ts_{ts}
+{
+  if (ts.type() != types::Timestamp) {
+    throw std::runtime_error(fmt::format("field '{}' of type '{}' is not a timestamp", ts.name(), ts.type_name()));
+  }
+}
+
+void time_index::build(record_span<record> records, size_t block_records)
+{
+  BOOST_ASSERT(block_records > 0);
+  block_records_ = block_records;
+  firsts_.clear();
+  update(records);
+}
+
+void time_index::update(record_span<record> records)
+{
+  if (block_records_ == 0) {
+    block_records_ = k_default_block_records;
+  }
+  for (auto i = firsts_.size() * block_records_; i < records.size(); i += block_records_) {
+    BOOST_ASSERT(firsts_.empty() || firsts_.back() <= time(records, i));
+    firsts_.push_back(time(records, i));
+  }
+}
+
+template <bool Upper>
+size_t time_index::search(record_span<record> const& records, size_t lo, size_t hi, raw_time_t t) const
+{
+  auto const before = [&](size_t i) { return Upper ? time(records, i) <= t : time(records, i) < t; };
+
+  // Invariant: the answer is in [lo, hi].
+  bool interpolate = true;
+  while (hi - lo > 8)
+  {
+    auto const width = hi - lo;
+    auto mid = lo + width / 2;
+    if (interpolate)
+    {
+      if (!before(lo)) {
+        return lo;
+      }
+      if (before(hi - 1)) {
+        return hi;
+      }
+      // Timestamps at lo and hi - 1 straddle t, so they differ and the probe lands strictly inside.
+      auto const t_lo = time(records, lo);
+      auto const t_hi = time(records, hi - 1);
+      auto const frac = (long double)(t - t_lo) / (long double)(t_hi - t_lo);
+      mid = lo + (size_t)(frac * (long double)(hi - 1 - lo));
+      ++lo;
+      --hi;
+      mid = std::clamp(mid, lo, hi - 1);
+    }
+
+    if (before(mid)) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+
+    // Keep interpolating while each probe cuts the range to a quarter, otherwise alternate with bisection.
+    interpolate = !interpolate || (hi - lo) * 4 <= width;
+  }
+
+  while (lo < hi && before(lo)) {
+    ++lo;
+  }
+  return lo;
+}
+
+template <bool Upper>
+size_t time_index::bound(record_span<record> const& records, raw_time_t t) const
+{
+  if (firsts_.empty()) {
+    return search<Upper>(records, 0, records.size(), t);
+  }
+
+  // The bound lies in the block before the first block starting after t (at or after t for a lower bound), or at
+  // the start of that block. Records appended since the last update() are covered by the search of the last block.
+  auto const it = Upper ? std::upper_bound(firsts_.begin(), firsts_.end(), t)
+                        : std::lower_bound(firsts_.begin(), firsts_.end(), t);
+  auto const block = (size_t)(it - firsts_.begin());
+  if (block == 0) {
+    return 0;
+  }
+
+  auto const lo = std::min(records.size(), (block - 1) * block_records_);
+  auto const hi = block == firsts_.size() ? records.size() : std::min(records.size(), block * block_records_);
+  return search<Upper>(records, lo, hi, t);
+}
+
+size_t time_index::lower_bound(record_span<record> records, timestamp_t t) const
+{
+  return bound<false>(records, t.time_since_epoch().count());
+}
+
+size_t time_index::upper_bound(record_span<record> records, timestamp_t t) const
+{
+  return bound<true>(records, t.time_since_epoch().count());
+}
+
+} // namespace rdf
@@ -18,7 +18,7 @@ template<type T> struct traits_base
 template <type T> struct traits {};
 
 // Reminder.
-static_assert(type_numof == 22, "ensure type traits are updated when new types are added");
+static_assert(type_numof == 24, "ensure type traits are updated when new types are added");
 
 template<> struct traits<Key8>       : traits_base<Key8>       { using type = string_t;        using prefix_t = uint8_t;  };
 template<> struct traits<Key16>      : traits_base<Key16>      { using type = string_t;        using prefix_t = uint16_t; };
@@ -42,6 +42,8 @@ template<> struct traits<Float32>    : traits_base<Float32>    { using type = st
 template<> struct traits<Float64>    : traits_base<Float64>    { using type = std::float64_t;                             };
 template<> struct traits<Float128>   : traits_base<Float128>   { using type = std::float128_t;                            };
 template<> struct traits<Bool>       : traits_base<Bool>       { using type = bool;                                       };
+template<> struct traits<KeyDict>    : traits_base<KeyDict>    { using type = key_code_t;                                 };
+template<> struct traits<StringRef>  : traits_base<StringRef>  { using type = string_ref;                                 };
 
 // Alias template for the value type of a rdf::types::type.
 template <type T> using value_t = traits<T>::type;
@@ -76,7 +78,9 @@ namespace concepts {
 
   template<class V> concept numeric = boolean<V> || integral<V> || floating_point<V>;
 
-  template<class V> concept field_value = numeric<V> || string<V> || timestamp<V>;
+  template<class V> concept string_ref = std::is_same_v<V, rdf::string_ref>;
+
+  template<class V> concept field_value = numeric<V> || string<V> || timestamp<V> || string_ref<V>;
 }
 
 inline constexpr bool string8_type(type t) {
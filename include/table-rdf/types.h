@@ -32,6 +32,8 @@ enum type
   Float64,
   Float128,
   Bool,
+  KeyDict,    // Dictionary encoded key, a code into a key_dictionary. Appended so stored type ids stay valid.
+  StringRef,  // String in a string_arena, or inline when short.
   type_numof
 };
 
@@ -73,7 +75,9 @@ static constexpr std::array<type_props, type_numof> k_type_props {
   type_props{ Float32,    "f32",     sizeof(std::float32_t),       alignof(std::float32_t) },
   type_props{ Float64,    "f64",     sizeof(std::float64_t),       alignof(std::float64_t) },
   type_props{ Float128,   "f128",    sizeof(std::float128_t),      alignof(std::float128_t) },
-  type_props{ Bool,       "bool",    sizeof(bool),                 alignof(bool) }
+  type_props{ Bool,       "bool",    sizeof(bool),                 alignof(bool) },
+  type_props{ KeyDict,    "*kdict*", sizeof(key_code_t),           alignof(key_code_t) },
+  type_props{ StringRef,  "strref",  sizeof(string_ref),           alignof(string_ref) }
 };
 
 static inline char const* enum_names_type(type t) {
@@ -9,12 +9,53 @@
   #include <fmt/color.h>
 #endif
 
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#if TRDF_HAS_SSSE3
+  #include <immintrin.h>
+#endif
+
 namespace rdf {
 namespace util {
 
 template<class> inline constexpr bool always_false_v = false;
 template<class> inline constexpr bool always_true_v = true;
 
+// String literal usable as a non-type template parameter, e.g. template <util::fixed_string Name>.
+template<size_t N>
+struct fixed_string
+{
+  constexpr fixed_string(char const (&str)[N]) { std::copy_n(str, N, str_); }
+
+  constexpr std::string_view view() const { return { str_, N - 1 }; }
+
+  char str_[N];
+};
+
+// 64-bit FNV-1a hash, usable at compile time.
+constexpr uint64_t hash(std::string_view sv)
+{
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (auto c : sv) {
+    h = (h ^ (uint8_t)c) * 0x100000001b3ull;
+  }
+  return h;
+}
+
+// Stable storage for strings that must outlive their source, e.g. field format strings read from a file.
+// Returns a view of a single shared copy of sv that is valid for the lifetime of the program.
+inline std::string_view intern(std::string_view sv)
+{
+  static std::mutex mutex;
+  static std::unordered_set<std::string> strings;   // Node based, so views remain valid on rehash.
+  std::lock_guard lock{mutex};
+  return *strings.emplace(sv).first;
+}
+
 //
 // Timestamp parsing and printing.
 //
@@ -185,30 +226,409 @@ inline std::string time_to_str(timestamp_t ts, std::string_view format = k_time_
  #endif
 }
 
-// Helper class for timestamp_t <--> string conversions.
+// Helper class for timestamp_t <--> string conversions. Formats made of fixed width %Y %m %d %H %M %S fields (and
+// %T %F %R %% shorthands) and literal characters are compiled into a token list, so to_time() and to_str() neither
+// allocate nor go through chrono parse / vformat. %S writes the 9 digit nanosecond fraction and reads an optional
+// fraction of 1 to 9 digits. Other formats fall back to str_to_time() / time_to_str().
 class time_fmt
 {
 public:
-  time_fmt(std::string const& time_fmt)
-    : time_fmt_{time_fmt},
-      str_fmt_{fmt::format("{{:{}}}", time_fmt_)}    // std::chrono parse function uses a different syntax to the std::format function.
-  {}
+  inline time_fmt(std::string const& time_fmt);
 
-  timestamp_t to_time(std::string_view sv) const
-  {
-    return util::str_to_time(sv, time_fmt_);
-  }
+  inline timestamp_t to_time(std::string_view sv) const;
+  inline std::string to_str(timestamp_t ts) const;
 
-  std::string to_str(timestamp_t ts) const
-  {
-    return util::time_to_str(ts, str_fmt_);
-  }
+  // Writes size() chars of ts to out and returns the end, compiled formats only.
+  inline char* to_chars(char* out, timestamp_t ts) const;
+
+  bool compiled() const { return compiled_; }
+  size_t size() const { return size_; }
 
 private:
+  enum class part : uint8_t { literal, year, month, day, hour, minute, second };
+  struct token { part part_; char literal_; };
+  struct civil { int64_t year_ = 1970, month_ = 1, day_ = 1, hour_ = 0, minute_ = 0, second_ = 0, ns_ = 0; };
+
+  inline bool compile();
+  inline bool parse(std::string_view sv, civil& c) const;
+  inline bool make_time(civil const& c, timestamp_t& ts) const;
+
   std::string const time_fmt_;
   std::string const str_fmt_;
+  std::vector<token> tokens_;
+  bool compiled_ = false;
+  size_t size_ = 0;     // Formatted length.
+
+#if TRDF_HAS_SSSE3
+  // Inputs of exactly size() chars, 16 to 32 of them, are checked and converted as two overlapping 16 byte loads, the
+  // first and last 16 chars. Digits are shuffled into the fixed order YYYYMMDDHHMMSS and 0000000nnnnnnnnn, then
+  // combined pairwise by multiply-adds.
+  static constexpr size_t k_vector_size = 16;
+
+  inline void compile_vector();
+  inline bool parse_vector(std::string_view sv, civil& c) const;
+
+  bool vectored_ = false;
+  alignas(16) std::array<uint8_t, 2 * k_vector_size> expected_;     // Literal chars of each load.
+  alignas(16) std::array<uint8_t, 2 * k_vector_size> digits_;       // 0xff at digit positions.
+  alignas(16) std::array<uint8_t, 2 * k_vector_size> calendar_;     // Shuffles of each load.
+  alignas(16) std::array<uint8_t, 2 * k_vector_size> fraction_;
+#endif
 };
 
+namespace detail {
+
+// Days since 1970-01-01 of a proleptic Gregorian date and back, see https://howardhinnant.github.io/date_algorithms.html
+constexpr int64_t days_from_civil(int64_t y, int64_t m, int64_t d)
+{
+  y -= m <= 2;
+  int64_t const era = (y >= 0 ? y : y - 399) / 400;
+  int64_t const yoe = y - era * 400;
+  int64_t const doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  int64_t const doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+constexpr void civil_from_days(int64_t z, int64_t& y, int64_t& m, int64_t& d)
+{
+  z += 719468;
+  int64_t const era = (z >= 0 ? z : z - 146096) / 146097;
+  int64_t const doe = z - era * 146097;
+  int64_t const yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t const doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int64_t const mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = yoe + era * 400 + (m <= 2);
+}
+
+constexpr int64_t days_in_month(int64_t y, int64_t m)
+{
+  if (m == 2) {
+    return (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0)) ? 29 : 28;
+  }
+  return (m == 4 || m == 6 || m == 9 || m == 11) ? 30 : 31;
+}
+
+// "00" to "99".
+inline constexpr auto k_digit_pairs = []() {
+  std::array<char, 200> pairs{};
+  for (size_t i = 0; i < 100; ++i) {
+    pairs[i * 2] = char('0' + i / 10);
+    pairs[i * 2 + 1] = char('0' + i % 10);
+  }
+  return pairs;
+}();
+
+inline char* write_2_digits(char* out, int64_t v)
+{
+  std::memcpy(out, &k_digit_pairs[v * 2], 2);
+  return out + 2;
+}
+
+} // namespace detail
+
+time_fmt::time_fmt(std::string const& time_fmt)
+  : time_fmt_{time_fmt},
+    str_fmt_{fmt::format("{{:{}}}", time_fmt_)}    // std::chrono parse function uses a different syntax to the std::format function.
+{
+  compiled_ = compile();
+  if (!compiled_) {
+    tokens_.clear();
+    size_ = 0;
+  }
+#if TRDF_HAS_SSSE3
+  else {
+    compile_vector();
+  }
+#endif
+}
+
+bool time_fmt::compile()
+{
+  auto const add = [this](part p, char literal = 0) {
+    if (p != part::literal && std::ranges::any_of(tokens_, [p](auto const& t) { return t.part_ == p; })) {
+      return false;     // Repeated fields are left to chrono.
+    }
+    tokens_.push_back({p, literal});
+    size_ += p == part::literal ? 1 : p == part::year ? 4 : p == part::second ? 12 : 2;
+    return true;
+  };
+
+  for (size_t i = 0; i < time_fmt_.size(); ++i) {
+    if (time_fmt_[i] != '%') {
+      add(part::literal, time_fmt_[i]);
+      continue;
+    }
+    if (++i == time_fmt_.size()) {
+      return false;
+    }
+    bool ok = true;
+    switch (time_fmt_[i]) {
+      case 'Y': ok = add(part::year); break;
+      case 'm': ok = add(part::month); break;
+      case 'd': ok = add(part::day); break;
+      case 'H': ok = add(part::hour); break;
+      case 'M': ok = add(part::minute); break;
+      case 'S': ok = add(part::second); break;
+      case 'T': ok = add(part::hour) && add(part::literal, ':') && add(part::minute) && add(part::literal, ':') && add(part::second); break;
+      case 'F': ok = add(part::year) && add(part::literal, '-') && add(part::month) && add(part::literal, '-') && add(part::day); break;
+      case 'R': ok = add(part::hour) && add(part::literal, ':') && add(part::minute); break;
+      case '%': ok = add(part::literal, '%'); break;
+      default:  ok = false;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+  return !tokens_.empty();
+}
+
+timestamp_t time_fmt::to_time(std::string_view sv) const
+{
+  if (!compiled_) {
+    return util::str_to_time(sv, time_fmt_);
+  }
+
+  civil c;
+  timestamp_t ts;
+  bool ok = false;
+#if TRDF_HAS_SSSE3
+  ok = vectored_ && sv.size() == size_ && parse_vector(sv, c) && make_time(c, ts);
+#endif
+  if (!ok && !(parse(sv, c = civil{}) && make_time(c, ts))) {
+    throw std::runtime_error{fmt::format("failed to parse timestamp string '{}' with format '{}'", sv, time_fmt_)};
+  }
+  return ts;
+}
+
+bool time_fmt::parse(std::string_view sv, civil& c) const
+{
+  size_t pos = 0;
+  auto const digits = [&](size_t n, int64_t& v) {
+    if (pos + n > sv.size()) {
+      return false;
+    }
+    v = 0;
+    for (auto const end = pos + n; pos < end; ++pos) {
+      auto const d = (unsigned)(sv[pos] - '0');
+      if (d > 9) {
+        return false;
+      }
+      v = v * 10 + d;
+    }
+    return true;
+  };
+
+  for (auto const& t : tokens_) {
+    bool ok = true;
+    switch (t.part_) {
+      case part::literal: ok = pos < sv.size() && sv[pos++] == t.literal_; break;
+      case part::year:    ok = digits(4, c.year_); break;
+      case part::month:   ok = digits(2, c.month_); break;
+      case part::day:     ok = digits(2, c.day_); break;
+      case part::hour:    ok = digits(2, c.hour_); break;
+      case part::minute:  ok = digits(2, c.minute_); break;
+      case part::second:
+        ok = digits(2, c.second_);
+        if (ok && pos < sv.size() && sv[pos] == '.') {
+          auto const first = ++pos;
+          while (pos < sv.size() && pos - first < 9 && (unsigned)(sv[pos] - '0') <= 9) {
+            c.ns_ = c.ns_ * 10 + (sv[pos++] - '0');
+          }
+          ok = pos > first;
+          for (auto n = pos - first; n < 9; ++n) {
+            c.ns_ *= 10;
+          }
+        }
+        break;
+    }
+    if (!ok) {
+      return false;
+    }
+  }
+  return pos == sv.size();
+}
+
+bool time_fmt::make_time(civil const& c, timestamp_t& ts) const
+{
+  if (c.month_ < 1 || c.month_ > 12 || c.day_ < 1 || c.day_ > detail::days_in_month(c.year_, c.month_) ||
+      c.hour_ > 23 || c.minute_ > 59 || c.second_ > 59) {
+    return false;
+  }
+
+  // Nanoseconds since the epoch overflow beyond about 292 years either side of 1970.
+  auto const days = detail::days_from_civil(c.year_, c.month_, c.day_);
+  if (days < -106751 || days > 106750) {
+    return false;
+  }
+  auto const seconds = days * 86400 + c.hour_ * 3600 + c.minute_ * 60 + c.second_;
+  ts = timestamp_t{ timestamp_t::duration{ seconds * 1'000'000'000 + c.ns_ } };
+  return true;
+}
+
+std::string time_fmt::to_str(timestamp_t ts) const
+{
+  if (!compiled_) {
+    return util::time_to_str(ts, str_fmt_);
+  }
+  std::string s(size_, '\0');
+  to_chars(s.data(), ts);
+  return s;
+}
+
+char* time_fmt::to_chars(char* out, timestamp_t ts) const
+{
+  constexpr int64_t k_ns_per_day = 86400 * 1'000'000'000ll;
+
+  auto const ns = ts.time_since_epoch().count();
+  auto days = ns / k_ns_per_day;
+  auto in_day = ns % k_ns_per_day;
+  if (in_day < 0) {
+    --days;
+    in_day += k_ns_per_day;
+  }
+  int64_t y, m, d;
+  detail::civil_from_days(days, y, m, d);
+  auto const seconds = in_day / 1'000'000'000;
+  auto const fraction = in_day % 1'000'000'000;
+
+  for (auto const& t : tokens_) {
+    switch (t.part_) {
+      case part::literal: *out++ = t.literal_; break;
+      case part::year:    out = detail::write_2_digits(detail::write_2_digits(out, y / 100), y % 100); break;
+      case part::month:   out = detail::write_2_digits(out, m); break;
+      case part::day:     out = detail::write_2_digits(out, d); break;
+      case part::hour:    out = detail::write_2_digits(out, seconds / 3600); break;
+      case part::minute:  out = detail::write_2_digits(out, seconds / 60 % 60); break;
+      case part::second:
+        out = detail::write_2_digits(out, seconds % 60);
+        *out++ = '.';
+        out = detail::write_2_digits(out, fraction / 10'000'000);
+        out = detail::write_2_digits(out, fraction / 100'000 % 100);
+        out = detail::write_2_digits(out, fraction / 1'000 % 100);
+        out = detail::write_2_digits(out, fraction / 10 % 100);
+        *out++ = char('0' + fraction % 10);
+        break;
+    }
+  }
+  return out;
+}
+
+#if TRDF_HAS_SSSE3
+void time_fmt::compile_vector()
+{
+  if (size_ < k_vector_size || size_ > 2 * k_vector_size) {
+    return;
+  }
+  expected_.fill(0);
+  digits_.fill(0);
+  calendar_.fill(0x80);     // Zeroed by the shuffle.
+  fraction_.fill(0x80);
+
+  // Chars in both loads are checked twice, and shuffled from the first.
+  auto const high = size_ - k_vector_size;
+  auto const literal = [&](size_t pos, char c) {
+    if (pos < k_vector_size) {
+      expected_[pos] = (uint8_t)c;
+    }
+    if (pos >= high) {
+      expected_[k_vector_size + pos - high] = (uint8_t)c;
+    }
+  };
+  auto const digit = [&](auto& shuffle, size_t to, size_t pos) {
+    if (pos < k_vector_size) {
+      digits_[pos] = 0xff;
+      shuffle[to] = (uint8_t)pos;
+    }
+    if (pos >= high) {
+      digits_[k_vector_size + pos - high] = 0xff;
+      if (pos >= k_vector_size) {
+        shuffle[k_vector_size + to] = uint8_t(pos - high);
+      }
+    }
+  };
+  auto const field = [&](size_t& pos, size_t to, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      digit(calendar_, to + i, pos++);
+    }
+  };
+
+  size_t pos = 0;
+  for (auto const& t : tokens_) {
+    switch (t.part_) {
+      case part::literal: literal(pos++, t.literal_); break;
+      case part::year:    field(pos, 0, 4); break;
+      case part::month:   field(pos, 4, 2); break;
+      case part::day:     field(pos, 6, 2); break;
+      case part::hour:    field(pos, 8, 2); break;
+      case part::minute:  field(pos, 10, 2); break;
+      case part::second:
+        field(pos, 12, 2);
+        literal(pos++, '.');
+        for (size_t i = 0; i < 9; ++i) {
+          digit(fraction_, 7 + i, pos++);
+        }
+        break;
+    }
+  }
+  vectored_ = true;
+}
+
+bool time_fmt::parse_vector(std::string_view sv, civil& c) const
+{
+  auto const load = [](auto const* p) { return _mm_load_si128(reinterpret_cast<__m128i const*>(p)); };
+  __m128i const chars[2] = { _mm_loadu_si128(reinterpret_cast<__m128i const*>(sv.data())),
+                             _mm_loadu_si128(reinterpret_cast<__m128i const*>(sv.data() + sv.size() - k_vector_size)) };
+  auto const zero = _mm_set1_epi8('0');
+  auto const nine = _mm_set1_epi8(9);
+
+  // Digit values of each load, and whether digits and literals are where the format puts them.
+  __m128i values[2];
+  for (size_t h = 0; h < 2; ++h) {
+    auto const v = chars[h];
+    auto const d = _mm_sub_epi8(v, zero);
+    auto const is_digit = _mm_cmpeq_epi8(_mm_min_epu8(d, nine), d);
+    auto const is_literal = _mm_cmpeq_epi8(v, load(expected_.data() + h * k_vector_size));
+    auto const mask = load(digits_.data() + h * k_vector_size);
+    if (_mm_movemask_epi8(_mm_or_si128(_mm_and_si128(mask, is_digit), _mm_andnot_si128(mask, is_literal))) != 0xffff) {
+      return false;
+    }
+    values[h] = d;
+  }
+  auto const gather = [&](auto const& shuffle) {
+    return _mm_or_si128(_mm_shuffle_epi8(values[0], load(shuffle.data())),
+                        _mm_shuffle_epi8(values[1], load(shuffle.data() + k_vector_size)));
+  };
+
+  auto const tens = _mm_set1_epi16(0x010a);     // Each byte pair as 10 * a + b.
+  alignas(16) std::array<uint16_t, 8> pairs;
+  _mm_store_si128(reinterpret_cast<__m128i*>(pairs.data()), _mm_maddubs_epi16(gather(calendar_), tens));
+
+  // Missing fields keep their defaults.
+  for (auto const& t : tokens_) {
+    switch (t.part_) {
+      case part::literal: break;
+      case part::year:    c.year_ = pairs[0] * 100 + pairs[1]; break;
+      case part::month:   c.month_ = pairs[2]; break;
+      case part::day:     c.day_ = pairs[3]; break;
+      case part::hour:    c.hour_ = pairs[4]; break;
+      case part::minute:  c.minute_ = pairs[5]; break;
+      case part::second:
+      {
+        c.second_ = pairs[6];
+        auto const v2 = _mm_maddubs_epi16(gather(fraction_), tens);
+        auto const v4 = _mm_madd_epi16(v2, _mm_set1_epi32(0x0001'0064));
+        auto const v8 = _mm_madd_epi16(_mm_packs_epi32(v4, v4), _mm_set1_epi32(0x0001'2710));
+        c.ns_ = (int64_t)_mm_cvtsi128_si32(v8) * 100'000'000 + _mm_cvtsi128_si32(_mm_srli_si128(v8, 4));
+        break;
+      }
+    }
+  }
+  return true;
+}
+#endif
+
 inline timestamp_t make_timestamp(raw_time_t raw_time)
 {
   return timestamp_t{ timestamp_t::duration{ raw_time } };
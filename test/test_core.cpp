@@ -6,6 +6,9 @@
 #if !TRDF_HAS_CHRONO_PARSE
   #include <date/date.h>
 #endif
+#include <map>
+#include <random>
+#include <set>
 #include <ranges>
 
 namespace rdf {
@@ -121,6 +124,96 @@ TEST_CASE( "field packing", "[core]" )
   REQUIRE(alignof(check_align_packed) == d_packed.mem_align());
 }
 
+// Same fields as the "field packing" test.
+template <bool Pack>
+using packing_static_descriptor = rdf::static_descriptor<Pack,
+                                                         static_field<"1",  String8, 186>,
+                                                         static_field<"2",  Int8>,
+                                                         static_field<"3",  Key8, 186>,
+                                                         static_field<"4",  Uint8>,
+                                                         static_field<"5",  Timestamp>,
+                                                         static_field<"6",  Bool>,
+                                                         static_field<"7",  Int32>,
+                                                         static_field<"8",  Int16>,
+                                                         static_field<"9",  Float32>,
+                                                         static_field<"10", Bool>,
+                                                         static_field<"11", Float64>,
+                                                         static_field<"12", Bool>,
+                                                         static_field<"13", Float128>,
+                                                         static_field<"14", Bool>,
+                                                         static_field<"15", Int32>>;
+
+TEST_CASE( "static descriptor", "[core]" )
+{
+  using namespace types;
+
+  const auto payload_size = 186;
+
+  rdf::fields_builder builder;
+  builder.push({ "1",  "", String8, payload_size})
+         .push({ "2",  "", Int8 })
+         .push({ "3",  "", Key8, payload_size})
+         .push({ "4",  "", Uint8 })
+         .push({ "5",  "", Timestamp })
+         .push({ "6",  "", Bool })
+         .push({ "7",  "", Int32 })
+         .push({ "8",  "", Int16 })
+         .push({ "9",  "", Float32 })
+         .push({ "10", "", Bool })
+         .push({ "11", "", Float64 })
+         .push({ "12", "", Bool })
+         .push({ "13", "", Float128 })
+         .push({ "14", "", Bool })
+         .push({ "15", "", Int32 });
+
+  using sd = packing_static_descriptor<false>;
+  using sd_packed = packing_static_descriptor<true>;
+
+  rdf::descriptor d {"Descriptor", builder, false};
+  rdf::descriptor d_packed {"Packed Descriptor", builder, true};
+
+  SECTION( "layout" )
+  {
+    // Layout is available at compile time.
+    static_assert(sd::mem_size() >= sd_packed::mem_size());
+    static_assert(sd_packed::offset<sd_packed::index_of<"13">()>() == 0);
+
+    REQUIRE(sd::matches(d));
+    REQUIRE(sd_packed::matches(d_packed));
+    REQUIRE_FALSE(sd::matches(d_packed));
+
+    auto const converted = sd_packed::to_descriptor("Converted Descriptor");
+    SPDLOG_DEBUG(converted.describe(true));
+    REQUIRE(sd_packed::matches(converted));
+    REQUIRE(converted.mem_size() == d_packed.mem_size());
+  }
+
+  SECTION( "read / write interop" )
+  {
+    mem_t* const mem = (mem_t*)std::aligned_alloc(sd_packed::mem_align(), sd_packed::mem_size());
+    timestamp_t const time = timestamp_t::clock::now();
+
+    // Static write, dynamic read.
+    sd_packed::write<"1">(mem, "static");
+    sd_packed::write<"5">(mem, time);
+    sd_packed::write<12>(mem, 1000.f128);
+    REQUIRE(d_packed.fields("1").read<String8>(mem) == "static");
+    REQUIRE(d_packed.fields("5").read<Timestamp>(mem) == time);
+    REQUIRE(d_packed.fields("13").read<Float128>(mem) == 1000.f128);
+
+    // Dynamic write, static read.
+    d_packed.fields("3").write<Key8>(mem, "dynamic");
+    d_packed.fields("15").write<Int32>(mem, -15);
+    REQUIRE(sd_packed::read<2>(mem) == "dynamic");
+    REQUIRE(sd_packed::read<"15">(mem) == -15);
+
+    using namespace Catch::Matchers;
+    REQUIRE_THROWS_WITH(sd_packed::write<"1">(mem, std::string(payload_size + 1, 'x')), Contains("too large"));
+
+    free(mem);
+  }
+}
+
 TEST_CASE( "basic usage", "[core]" )
 {
   using field = rdf::field;
@@ -256,6 +349,2609 @@ TEST_CASE( "basic usage", "[core]" )
   }
 }
 
+TEST_CASE( "field names", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  for (int i = 0; i < 500; ++i) {
+    builder.push({ fmt::format("Field {}", i), "", Int32 });
+  }
+  descriptor d {"Many Fields", builder};
+
+  SECTION( "lookup" )
+  {
+    for (field::index_t i = 0; i < d.fields().size(); ++i)
+    {
+      auto const name = fmt::format("Field {}", i);
+      REQUIRE(d.contains(name));
+      REQUIRE(d.fields(name).index() == i);
+      REQUIRE(d.handle(name).index() == i);
+      REQUIRE(&d.fields(d.handle(name)) == &d.fields(i));
+    }
+
+    REQUIRE_FALSE(d.contains("Field 500"));
+    REQUIRE_THROWS_AS(d.fields("Field 500"), std::out_of_range);
+    REQUIRE_THROWS_AS(d.handle(""), std::out_of_range);
+  }
+
+  SECTION( "compile-time tokens" )
+  {
+    static constexpr field_name k_token{"Field 42"};
+    static_assert(k_token.hash() == util::hash("Field 42"));
+    REQUIRE(d.fields(k_token).index() == 42);
+  }
+
+  SECTION( "copies" )
+  {
+    // The name table holds indices, so lookups on a copy resolve to the copy's fields.
+    auto const copy = d;
+    REQUIRE(copy == d);
+    REQUIRE(&copy.fields("Field 7") == &copy.fields(7ul));
+  }
+
+  SECTION( "wide" )
+  {
+    // The table is linear in the field count, so very wide descriptors build and resolve every name.
+    rdf::fields_builder wide;
+    for (int i = 0; i < 20'000; ++i) {
+      wide.push({ fmt::format("Column {}", i), "", Int8 });
+    }
+    descriptor w {"Wide", wide};
+    for (field::index_t i = 0; i < w.fields().size(); i += 97) {
+      REQUIRE(w.fields(fmt::format("Column {}", i)).index() == i);
+    }
+    REQUIRE_FALSE(w.contains("Column 20000"));
+  }
+
+  SECTION( "duplicates" )
+  {
+    using namespace Catch::Matchers;
+    builder.push({ "Field 3", "", Int8 });
+    REQUIRE_THROWS_WITH(descriptor("Duplicates", builder), Contains("duplicate field name 'Field 3'"));
+  }
+}
+
+TEST_CASE( "copy plan", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Key8 Field",      "", Key8, 31 })
+         .push({ "Key16 Field",     "", Key16, 254 })
+         .push({ "Timestamp Field", "", Timestamp })
+         .push({ "Int8 Field",      "", Int8 })
+         .push({ "Int32 Field",     "", Int32 })
+         .push({ "Uint16 Field",    "", Uint16 })
+         .push({ "Float32 Field",   "", Float32 })
+         .push({ "Float64 Field",   "", Float64 })
+         .push({ "Bool Field",      "", Bool });
+
+  descriptor src {"Source", builder};
+
+  constexpr auto k_count = 100;
+  timestamp_t const time = timestamp_t::clock::now();
+
+  mem_t* const src_mem = (mem_t*)std::aligned_alloc(src.mem_align(), src.mem_size() * k_count);
+  std::memset(src_mem, 0, src.mem_size() * k_count);
+  for (int i = 0; i < k_count; ++i)
+  {
+    auto const mem = src_mem + i * src.mem_size();
+    src.fields("Key8 Field")     .write<Key8>     (mem, fmt::format("_B[_{}d:{}d]", i, i + 1));
+    src.fields("Key16 Field")    .write<Key16>    (mem, fmt::format("AAPL_{}:*", i % 10));
+    src.fields("Timestamp Field").write<Timestamp>(mem, time + timestamp_t::duration{i});
+    src.fields("Int8 Field")     .write<Int8>     (mem, -i);
+    src.fields("Int32 Field")    .write<Int32>    (mem, -i << 2);
+    src.fields("Uint16 Field")   .write<Uint16>   (mem, i << 1);
+    src.fields("Float32 Field")  .write<Float32>  (mem, i * 10.f32);
+    src.fields("Float64 Field")  .write<Float64>  (mem, i * 100.f64);
+    src.fields("Bool Field")     .write<Bool>     (mem, i % 2);
+  }
+
+  SECTION( "identical layout" )
+  {
+    copy_plan plan{src, src};
+    SPDLOG_DEBUG(plan.describe());
+    REQUIRE(plan.trivial());
+    REQUIRE(plan.runs().size() == 1);
+
+    std::vector<mem_t> dest(src.mem_size() * k_count);
+    plan.copy(dest.data(), src_mem, k_count);
+    REQUIRE(std::memcmp(dest.data(), src_mem, dest.size()) == 0);
+  }
+
+  SECTION( "packed to unpacked" )
+  {
+    descriptor dest {"Unpacked", builder, false};
+    copy_plan plan{src, dest};
+    SPDLOG_DEBUG(plan.describe());
+    REQUIRE_FALSE(plan.trivial());
+    REQUIRE(plan.special_count() == 0);
+
+    mem_t* const dest_mem = (mem_t*)std::aligned_alloc(dest.mem_align(), dest.mem_size() * k_count);
+    plan.copy(dest_mem, src_mem, k_count);
+    for (int i = 0; i < k_count; ++i)
+    {
+      auto const record = rdf::record{dest_mem + i * dest.mem_size()};
+      REQUIRE(record.get<Key8>     (dest.fields("Key8 Field"))      == fmt::format("_B[_{}d:{}d]", i, i + 1));
+      REQUIRE(record.get<Key16>    (dest.fields("Key16 Field"))     == fmt::format("AAPL_{}:*", i % 10));
+      REQUIRE(record.get<Timestamp>(dest.fields("Timestamp Field")) == time + timestamp_t::duration{i});
+      REQUIRE(record.get<Int8>     (dest.fields("Int8 Field"))      == -i);
+      REQUIRE(record.get<Int32>    (dest.fields("Int32 Field"))     == -i << 2);
+      REQUIRE(record.get<Uint16>   (dest.fields("Uint16 Field"))    == i << 1);
+      REQUIRE(record.get<Float32>  (dest.fields("Float32 Field"))   == i * 10.f32);
+      REQUIRE(record.get<Float64>  (dest.fields("Float64 Field"))   == i * 100.f64);
+      REQUIRE(record.get<Bool>     (dest.fields("Bool Field"))      == i % 2);
+    }
+    free(dest_mem);
+  }
+
+  SECTION( "appended field" )
+  {
+    descriptor unpacked {"Unpacked", builder, false};
+    auto dest_builder = builder;
+    dest_builder.push({ "Extra Field", "", Uint64 });
+    descriptor dest {"Appended", dest_builder, false};
+
+    // All common fields are coalesced into a single run.
+    copy_plan plan{unpacked, dest};
+    SPDLOG_DEBUG(plan.describe());
+    REQUIRE_FALSE(plan.trivial());
+    REQUIRE(plan.runs().size() == 1);
+  }
+
+  SECTION( "subset with conversions" )
+  {
+    rdf::fields_builder dest_builder;
+    dest_builder.push({ "Key16 Field",   "", Key8, 16 })    // Narrower prefix and payload.
+                .push({ "Int32 Field",   "", Int64 })
+                .push({ "Float32 Field", "", Float64 })
+                .push({ "Int8 Field",    "", Int8 })
+                .push({ "Extra Field",   "", Uint64 });     // Not in source, left untouched.
+    descriptor dest {"Subset", dest_builder};
+
+    copy_plan plan{src, dest};
+    SPDLOG_DEBUG(plan.describe());
+    REQUIRE(plan.special_count() == 3);
+
+    mem_t* const dest_mem = (mem_t*)std::aligned_alloc(dest.mem_align(), dest.mem_size() * k_count);
+    for (int i = 0; i < k_count; ++i) {
+      dest.fields("Extra Field").write<Uint64>(dest_mem + i * dest.mem_size(), 42);
+    }
+
+    plan.copy(dest_mem, src_mem, k_count);
+    for (int i = 0; i < k_count; ++i)
+    {
+      auto const record = rdf::record{dest_mem + i * dest.mem_size()};
+      REQUIRE(record.get<Key8>   (dest.fields("Key16 Field"))   == fmt::format("AAPL_{}:*", i % 10));
+      REQUIRE(record.get<Int64>  (dest.fields("Int32 Field"))   == -i << 2);
+      REQUIRE(record.get<Float64>(dest.fields("Float32 Field")) == i * 10.f64);
+      REQUIRE(record.get<Int8>   (dest.fields("Int8 Field"))    == -i);
+      REQUIRE(record.get<Uint64> (dest.fields("Extra Field"))   == 42);
+    }
+
+    using namespace Catch::Matchers;
+    src.fields("Key16 Field").write<Key16>(src_mem, std::string(17, 'x'));
+    REQUIRE_THROWS_WITH(plan.copy(dest_mem, src_mem), Contains("too large"));
+
+    rdf::fields_builder bad_builder;
+    bad_builder.push({ "Key8 Field", "", Int32 });
+    REQUIRE_THROWS_WITH(copy_plan(src, descriptor{"Bad", bad_builder}), Contains("cannot copy"));
+
+    free(dest_mem);
+  }
+
+  free(src_mem);
+}
+
+TEST_CASE( "projection", "[core]" )
+{
+  using namespace types;
+
+  constexpr auto k_count = 10000;
+
+  SECTION( "small records" )
+  {
+    rdf::fields_builder builder;
+    builder.push({ "a", "", Int8 })
+           .push({ "b", "", Int32 })
+           .push({ "c", "", Int16 })
+           .push({ "d", "", Bool });
+
+    descriptor src {"Unpacked", builder, false};
+    descriptor dest {"Packed", builder, true};
+    REQUIRE(src.mem_size() > dest.mem_size());
+
+    projection const proj{src, dest};
+    SPDLOG_DEBUG("projection shuffled: {}", proj.shuffled());
+
+    std::vector<mem_t> src_mem(src.mem_size() * k_count);
+    for (int i = 0; i < k_count; ++i)
+    {
+      auto const mem = src_mem.data() + i * src.mem_size();
+      src.fields("a").write<Int8> (mem, (int8_t)i);
+      src.fields("b").write<Int32>(mem, -i);
+      src.fields("c").write<Int16>(mem, (int16_t)(i * 3));
+      src.fields("d").write<Bool> (mem, i % 3 == 0);
+    }
+
+    std::vector<mem_t> dest_mem(dest.mem_size() * k_count);
+    proj(dest_mem.data(), src_mem.data(), k_count);
+
+    for (int i = 0; i < k_count; ++i)
+    {
+      auto const record = rdf::record{dest_mem.data() + i * dest.mem_size()};
+      REQUIRE(record.get<Int8> (dest.fields("a")) == (int8_t)i);
+      REQUIRE(record.get<Int32>(dest.fields("b")) == -i);
+      REQUIRE(record.get<Int16>(dest.fields("c")) == (int16_t)(i * 3));
+      REQUIRE(record.get<Bool> (dest.fields("d")) == (i % 3 == 0));
+    }
+  }
+
+  SECTION( "subset with conversion" )
+  {
+    rdf::fields_builder builder;
+    builder.push({ "Key16 Field",     "", Key16, 254 })
+           .push({ "Timestamp Field", "", Timestamp })
+           .push({ "Int32 Field",     "", Int32 })
+           .push({ "Float64 Field",   "", Float64 });
+
+    rdf::fields_builder dest_builder;
+    dest_builder.push({ "Float64 Field", "", Float32 })
+                .push({ "Key16 Field",   "", Key16, 254 });
+
+    descriptor src {"Source", builder};
+    descriptor dest {"Subset", dest_builder, false};
+
+    projection const proj{src, dest};
+    REQUIRE_FALSE(proj.shuffled());
+
+    mem_t* const src_mem = (mem_t*)std::aligned_alloc(src.mem_align(), src.mem_size() * k_count);
+    for (int i = 0; i < k_count; ++i)
+    {
+      auto const mem = src_mem + i * src.mem_size();
+      src.fields("Key16 Field")    .write<Key16>    (mem, fmt::format("AAPL_{}:*", i % 10));
+      src.fields("Timestamp Field").write<Timestamp>(mem, util::make_timestamp(i));
+      src.fields("Int32 Field")    .write<Int32>    (mem, i);
+      src.fields("Float64 Field")  .write<Float64>  (mem, i * 0.5);
+    }
+
+    mem_t* const dest_mem = (mem_t*)std::aligned_alloc(dest.mem_align(), dest.mem_size() * k_count);
+    proj(dest_mem, src_mem, k_count);
+
+    for (int i = 0; i < k_count; ++i)
+    {
+      auto const record = rdf::record{dest_mem + i * dest.mem_size()};
+      REQUIRE(record.get<Key16>  (dest.fields("Key16 Field"))   == fmt::format("AAPL_{}:*", i % 10));
+      REQUIRE(record.get<Float32>(dest.fields("Float64 Field")) == i * 0.5f);
+    }
+
+    free(dest_mem);
+    free(src_mem);
+  }
+}
+
+TEST_CASE( "column table", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Key8 Field",      "", Key8, 31 })
+         .push({ "String16 Field",  "", String16, 254 })
+         .push({ "Timestamp Field", "", Timestamp })
+         .push({ "Char Field",      "", Char })
+         .push({ "Int16 Field",     "", Int16 })
+         .push({ "Int64 Field",     "", Int64 })
+         .push({ "Float32 Field",   "", Float32 })
+         .push({ "Float128 Field",  "", Float128 })
+         .push({ "Bool Field",      "", Bool });
+
+  descriptor d {"Columnar", builder};
+
+  constexpr auto k_count = 1000;
+  auto const bytes = d.mem_size() * k_count;
+  mem_t* const rows = (mem_t*)std::aligned_alloc(d.mem_align(), bytes);
+  std::memset(rows, 0, bytes);
+
+  for (int i = 0; i < k_count; ++i)
+  {
+    auto const mem = rows + i * d.mem_size();
+    d.fields("Key8 Field")     .write<Key8>     (mem, fmt::format("_B[_{}d:{}d]", i, i + 1));
+    d.fields("String16 Field") .write<String16> (mem, fmt::format("SPY_{}:*", i % 10));
+    d.fields("Timestamp Field").write<Timestamp>(mem, util::make_timestamp(i * 1000));
+    d.fields("Char Field")     .write<Char>     (mem, 33 + i % (127 - 33));
+    d.fields("Int16 Field")    .write<Int16>    (mem, -i);
+    d.fields("Int64 Field")    .write<Int64>    (mem, i << 3);
+    d.fields("Float32 Field")  .write<Float32>  (mem, i * 10.f32);
+    d.fields("Float128 Field") .write<Float128> (mem, i * 1000.f128);
+    d.fields("Bool Field")     .write<Bool>     (mem, i % 2);
+  }
+
+  column_table table{d, k_count};
+  table.from_rows(rows, k_count);
+  REQUIRE(table.size() == k_count);
+
+  SECTION( "row to column" )
+  {
+    REQUIRE(boost::alignment::is_aligned(table.data(d.fields("Key8 Field")), column_table::k_column_align));
+    REQUIRE(boost::alignment::is_aligned(table.payload(d.fields("Key8 Field")), column_table::k_column_align));
+    REQUIRE(boost::alignment::is_aligned(table.data(d.fields("Int64 Field")), column_table::k_column_align));
+
+    for (int i = 0; i < k_count; ++i)
+    {
+      auto const record = rdf::record{rows + i * d.mem_size()};
+      REQUIRE(table.get<Key8>     (d.fields("Key8 Field"),      i) == record.get<Key8>     (d.fields("Key8 Field")));
+      REQUIRE(table.get<String16> (d.fields("String16 Field"),  i) == record.get<String16> (d.fields("String16 Field")));
+      REQUIRE(table.get<Timestamp>(d.fields("Timestamp Field"), i) == record.get<Timestamp>(d.fields("Timestamp Field")));
+      REQUIRE(table.get<Char>     (d.fields("Char Field"),      i) == record.get<Char>     (d.fields("Char Field")));
+      REQUIRE(table.get<Int16>    (d.fields("Int16 Field"),     i) == record.get<Int16>    (d.fields("Int16 Field")));
+      REQUIRE(table.get<Int64>    (d.fields("Int64 Field"),     i) == record.get<Int64>    (d.fields("Int64 Field")));
+      REQUIRE(table.get<Float32>  (d.fields("Float32 Field"),   i) == record.get<Float32>  (d.fields("Float32 Field")));
+      REQUIRE(table.get<Float128> (d.fields("Float128 Field"),  i) == record.get<Float128> (d.fields("Float128 Field")));
+      REQUIRE(table.get<Bool>     (d.fields("Bool Field"),      i) == record.get<Bool>     (d.fields("Bool Field")));
+    }
+
+    // Single column scan.
+    auto const column = table.column<Int64>(d.fields("Int64 Field"));
+    REQUIRE(column.size() == k_count);
+    REQUIRE(std::accumulate(column.begin(), column.end(), int64_t{0}) == (int64_t{k_count} * (k_count - 1) / 2) << 3);
+  }
+
+  SECTION( "column to row" )
+  {
+    std::vector<mem_t> out(bytes);
+    table.to_rows(out.data(), k_count);
+    REQUIRE(std::memcmp(out.data(), rows, bytes) == 0);
+
+    // Partial range and updates.
+    table.set<Int64>(d.fields("Int64 Field"), 10, -1);
+    table.set<Key8>(d.fields("Key8 Field"), 10, "updated");
+    table.to_rows(out.data(), 5, 8);
+    auto const record = rdf::record{out.data() + 2 * d.mem_size()};
+    REQUIRE(record.get<Int64>(d.fields("Int64 Field")) == -1);
+    REQUIRE(record.get<Key8>(d.fields("Key8 Field")) == "updated");
+    REQUIRE(record.get<Int16>(d.fields("Int16 Field")) == -10);
+  }
+
+  free(rows);
+}
+
+TEST_CASE( "record span", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Int64 Field", "", Int64 })
+         .push({ "Int8 Field",  "", Int8 });
+
+  descriptor d {"Span", builder};
+  REQUIRE(d.mem_size() == 16);
+
+  constexpr auto k_count = 1000;
+  mem_t* const mem = (mem_t*)std::aligned_alloc(64, d.mem_size() * k_count);
+  for (int64_t i = 0; i < k_count; ++i) {
+    d.fields("Int64 Field").write<Int64>(mem + i * d.mem_size(), i);
+  }
+
+  auto const& f = d.fields("Int64 Field");
+  auto const records = rdf::views::records<record>(mspan{mem, d.mem_size() * k_count}, d);
+  REQUIRE(records.size() == k_count);
+
+  SECTION( "iteration" )
+  {
+    int64_t i = 0;
+    for (auto r : records) {
+      REQUIRE(r.get<Int64>(f) == i++);
+    }
+    REQUIRE(i == k_count);
+
+    auto it = records.begin();
+    it += 10;
+    REQUIRE((*it).get<Int64>(f) == 10);
+    REQUIRE(it[5].get<Int64>(f) == 15);
+    REQUIRE(records.end() - it == k_count - 10);
+    REQUIRE(std::ranges::distance(records) == k_count);
+    REQUIRE(records.back().get<Int64>(f) == k_count - 1);
+  }
+
+  SECTION( "slicing" )
+  {
+    auto const s = records.subspan(100, 50);
+    REQUIRE(s.size() == 50);
+    REQUIRE(s.front().get<Int64>(f) == 100);
+    REQUIRE(s.last(1)[0].get<Int64>(f) == 149);
+    REQUIRE(records.first(3).size() == 3);
+    REQUIRE(records.subspan(990).size() == 10);
+    REQUIRE(records.subspan(k_count).empty());
+  }
+
+  SECTION( "tbb split" )
+  {
+    REQUIRE(records.grain() == 4);   // 4 records of 16 bytes per cache line.
+    auto const chunked = records.with_grain(10);
+    REQUIRE(chunked.grain() == 12);
+
+    std::atomic<int64_t> sum = 0;
+    std::atomic<size_t> count = 0;
+    std::atomic<bool> aligned = true;    // Catch2 assertions are not thread safe.
+    tbb::parallel_for(chunked, [&](rdf::record_span<record> const& range)
+    {
+      aligned = aligned && boost::alignment::is_aligned(range.data(), 64);
+      for (auto r : range) {
+        sum += r.get<Int64>(f);
+      }
+      count += range.size();
+    });
+    REQUIRE(aligned);
+    REQUIRE(count == k_count);
+    REQUIRE(sum == int64_t{k_count} * (k_count - 1) / 2);
+  }
+
+  free(mem);
+}
+
+TEST_CASE( "table file", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Key8 Field",      "Key8 field description", Key8, 31, fmt::runtime("{:>32}") })
+         .push({ "Timestamp Field", "",                       Timestamp })
+         .push({ "Int64 Field",     "",                       Int64 })
+         .push({ "Float32 Field",   "",                       Float32 });
+
+  descriptor d {"Table File", builder, false};
+
+  constexpr auto k_count = 1000;
+  char const* file_name = "./table-file-test.bin";
+
+  {
+    auto file = table_file::create(file_name, d, k_count);
+    REQUIRE(file.size() == k_count);
+    REQUIRE(boost::alignment::is_aligned(file.data(), table_file::k_region_align));
+
+    for (int64_t i = 0; i < k_count; ++i)
+    {
+      auto const mem = file.data() + i * d.mem_size();
+      d.fields("Key8 Field")     .write<Key8>     (mem, fmt::format("_B[_{}d:{}d]", i, i + 1));
+      d.fields("Timestamp Field").write<Timestamp>(mem, util::make_timestamp(i * 1000));
+      d.fields("Int64 Field")    .write<Int64>    (mem, i << 3);
+      d.fields("Float32 Field")  .write<Float32>  (mem, i * 10.f32);
+    }
+  }
+
+  SECTION( "open" )
+  {
+    auto const file = table_file::open(file_name);
+    REQUIRE(file.desc() == d);
+    REQUIRE(!file.desc().packed());
+    REQUIRE(file.desc().fields("Key8 Field").fmt().str == std::string_view{"{:>32}"});
+    REQUIRE(file.size() == k_count);
+
+    int64_t i = 0;
+    for (auto r : file.records()) {
+      REQUIRE(r.get<Key8>     (d.fields("Key8 Field"))      == fmt::format("_B[_{}d:{}d]", i, i + 1));
+      REQUIRE(r.get<Timestamp>(d.fields("Timestamp Field")) == util::make_timestamp(i * 1000));
+      REQUIRE(r.get<Int64>    (d.fields("Int64 Field"))     == i << 3);
+      REQUIRE(r.get<Float32>  (d.fields("Float32 Field"))   == i * 10.f32);
+      ++i;
+    }
+    REQUIRE(i == k_count);
+  }
+
+  SECTION( "descriptor round trip" )
+  {
+    auto const bytes = write_descriptor(d);
+    auto const span = std::as_bytes(std::span{bytes});
+    REQUIRE(read_descriptor(span) == d);
+    REQUIRE_THROWS_WITH(read_descriptor(span.first(span.size() - 1)), "truncated descriptor");
+  }
+
+  SECTION( "invalid files" )
+  {
+    using namespace Catch::Matchers;
+
+    {
+      std::ofstream file{file_name, std::ios::binary | std::ios::trunc};
+      file << "not a table";
+    }
+    REQUIRE_THROWS_WITH(table_file::open(file_name), Contains("too small to be a table file"));
+
+    {
+      std::ofstream file{file_name, std::ios::binary | std::ios::trunc};
+      file << std::string(sizeof(table_header), 'x');
+    }
+    REQUIRE_THROWS_WITH(table_file::open(file_name), Contains("is not a table file"));
+  }
+
+  std::filesystem::remove(file_name);
+}
+
+TEST_CASE( "table appender", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Int64 Field",  "", Int64 })
+         .push({ "Uint64 Field", "", Uint64 });
+
+  descriptor d {"Appender", builder};
+  char const* file_name = "./table-appender-test.bin";
+  auto const& f0 = d.fields("Int64 Field");
+  auto const& f1 = d.fields("Uint64 Field");
+
+  SECTION( "append and reopen" )
+  {
+    {
+      table_appender appender{table_file::create(file_name, d, 0), 4096, true};
+      REQUIRE(appender.committed() == 0);
+
+      for (int64_t i = 0; i < 1000; ++i) {
+        auto const mem = appender.next();
+        f0.write<Int64>(mem, i);
+        f1.write<Uint64>(mem, i * 2);
+        if (i % 10 == 9) {
+          appender.publish();
+        }
+      }
+      REQUIRE(appender.committed() == 1000);
+      REQUIRE(appender.pending() == 0);
+      REQUIRE(appender.file().capacity() >= 1000);
+      REQUIRE(std::filesystem::file_size(file_name) % 4096 == 0);
+
+      // Unpublished records are not visible.
+      appender.next(5);
+      REQUIRE(table_file::open(file_name).size() == 1000);
+    }
+
+    auto const file = table_file::open(file_name);
+    REQUIRE(file.size() == 1000);
+    REQUIRE(file.records().back().get<Int64>(f0) == 999);
+
+    // Continue appending to an existing file.
+    table_appender appender{table_file::open(file_name, table_file::mode::read_write)};
+    REQUIRE(appender.committed() == 1000);
+    std::vector<mem_t> row(d.mem_size());
+    f0.write<Int64>(row.data(), -1);
+    appender.append(row.data(), 1);
+    REQUIRE(table_file::open(file_name).records()[1000].get<Int64>(f0) == -1);
+
+    REQUIRE_THROWS(table_appender{table_file::open(file_name)});
+  }
+
+  SECTION( "concurrent reader" )
+  {
+    constexpr int64_t k_count = 100'000;
+    table_appender appender{table_file::create(file_name, d, 0), 64 * 1024};
+    auto reader = table_file::open(file_name);
+
+    std::thread writer{[&] {
+      for (int64_t i = 0; i < k_count; ++i) {
+        auto const mem = appender.next();
+        f0.write<Int64>(mem, i);
+        f1.write<Uint64>(mem, i * 2);
+        if (i % 7 == 0) {
+          appender.publish();
+        }
+      }
+      appender.publish();
+    }};
+
+    // Every committed record must be complete.
+    size_t seen = 0;
+    bool complete = true;
+    while (seen < k_count)
+    {
+      if (reader.size() == reader.capacity()) {
+        reader.remap();
+      }
+      auto const records = reader.records().subspan(seen);
+      for (auto r : records) {
+        complete = complete && r.get<Int64>(f0) == (int64_t)seen && r.get<Uint64>(f1) == seen * 2;
+        ++seen;
+      }
+    }
+    writer.join();
+
+    REQUIRE(complete);
+    REQUIRE(seen == k_count);
+  }
+
+  std::filesystem::remove(file_name);
+}
+
+TEST_CASE( "table follower", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Int64 Field", "", Int64 });
+
+  descriptor d {"Follower", builder};
+  char const* file_name = "./table-follower-test.bin";
+  auto const& f = d.fields("Int64 Field");
+
+  constexpr int64_t k_count = 10'000;
+  table_appender appender{table_file::create(file_name, d, 0), 4096, true};
+
+  for (auto use_inotify : {true, false})
+  {
+    DYNAMIC_SECTION( "follow " << (use_inotify ? "inotify" : "polling") )
+    {
+      table_follower follower{file_name, 0, 1ms, use_inotify};
+      REQUIRE(follower.notified() == (use_inotify && TRDF_HAS_INOTIFY));
+
+      std::vector<std::pair<size_t, size_t>> ranges;
+      bool values = true;
+      follower.subscribe([&](table_file const& file, size_t begin, size_t end) {
+        ranges.emplace_back(begin, end);
+        for (auto r : file.records().subspan(begin, end - begin)) {
+          values = values && r.get<Int64>(f) == (int64_t)begin++;
+        }
+      });
+
+      std::thread writer{[&] {
+        for (int64_t i = 0; i < k_count; ++i) {
+          f.write<Int64>(appender.next(), i);
+          if (i % 100 == 99) {
+            appender.publish();
+          }
+        }
+      }};
+
+      while (follower.position() < (size_t)k_count) {
+        follower.wait(1s);
+      }
+      writer.join();
+
+      // Ranges are contiguous, non-overlapping and cover every record.
+      REQUIRE(values);
+      REQUIRE(ranges.front().first == 0);
+      REQUIRE(ranges.back().second == k_count);
+      for (size_t i = 1; i < ranges.size(); ++i) {
+        REQUIRE(ranges[i].first == ranges[i - 1].second);
+      }
+      REQUIRE(follower.poll() == 0);
+      REQUIRE(follower.wait(1ms) == 0);
+    }
+  }
+
+  SECTION( "run" )
+  {
+    // With inotify and a notifying appender the hour long poll interval is never waited on: records are delivered on
+    // publish and a stop request wakes run() at once.
+    table_follower follower{file_name, appender.committed(), 1h};
+    std::atomic<size_t> delivered = follower.position();
+    follower.subscribe([&](table_file const&, size_t, size_t end) { delivered.store(end); });
+
+    auto const start = std::chrono::steady_clock::now();
+    if (follower.notified()) {
+      std::jthread thread{[&](std::stop_token stop) { follower.run(stop); }};
+      f.write<Int64>(appender.next(), -1);
+      appender.publish();
+      while (delivered.load() != appender.committed()) {
+        std::this_thread::yield();
+      }
+    }
+    REQUIRE(std::chrono::steady_clock::now() - start < 10s);
+  }
+
+  SECTION( "default appender" )
+  {
+    // A default appender does not touch the file on publish, so an inotify follower only sees new records by checking
+    // the committed count every poll interval.
+    char const* quiet_name = "./table-follower-quiet-test.bin";
+    {
+      table_appender quiet{table_file::create(quiet_name, d, 0)};
+      f.write<Int64>(quiet.next(), 0);     // Grows the file.
+      quiet.publish();
+
+      table_follower follower{quiet_name, 0, 1ms};
+      std::atomic<size_t> delivered = 0;
+      follower.subscribe([&](table_file const&, size_t, size_t end) { delivered.store(end); });
+      REQUIRE(follower.poll() == 1);
+
+      f.write<Int64>(quiet.next(), 1);
+      quiet.publish();
+      auto const start = std::chrono::steady_clock::now();
+      REQUIRE(follower.wait(1h) == 1);
+
+      {
+        std::jthread thread{[&](std::stop_token stop) { follower.run(stop); }};
+        f.write<Int64>(quiet.next(), 2);
+        quiet.publish();
+        while (delivered.load() != 3 && std::chrono::steady_clock::now() - start < 10s) {
+          std::this_thread::yield();
+        }
+      }
+      REQUIRE(delivered.load() == 3);
+      REQUIRE(std::chrono::steady_clock::now() - start < 10s);
+    }
+    std::filesystem::remove(quiet_name);
+  }
+
+  std::filesystem::remove(file_name);
+}
+
+TEST_CASE( "seqlock", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Sequence",      "", Uint64 })
+         .push({ "Int64 Field",   "", Int64 })
+         .push({ "Float64 Field", "", Float64 })
+         .push({ "String8 Field", "", String8, 31 });
+
+  descriptor d {"Seqlock", builder};
+  auto const& a = d.fields("Int64 Field");
+  auto const& b = d.fields("Float64 Field");
+  auto const& str = d.fields("String8 Field");
+  record_seqlock const lock{d.fields("Sequence")};
+
+  constexpr size_t k_records = 4;
+  std::vector<mem_t> mem(d.mem_size() * k_records);
+  auto const rec = [&](size_t i) { return mem.data() + i * d.mem_size(); };
+
+  REQUIRE_THROWS_WITH(record_seqlock{a}, "sequence field 'Int64 Field' must be of type 'u64', not 'i64'");
+
+  SECTION( "single thread" )
+  {
+    REQUIRE(lock.sequence(rec(0)) == 0);
+    lock.set<Int64>(rec(0), a, 42);
+    REQUIRE(lock.sequence(rec(0)) == 2);
+    REQUIRE(lock.get<Int64>(rec(0), a) == 42);
+    lock.set<String8>(rec(0), str, "hello");
+    REQUIRE(record{rec(0)}.get<String8>(str, lock) == "hello");
+  }
+
+  SECTION( "stress" )
+  {
+    // One writer updates every field of each record in place, readers must always see a consistent record.
+    constexpr int64_t k_updates = 200'000;
+    constexpr int k_readers = 4;
+
+    std::atomic<bool> done = false;
+    std::atomic<size_t> torn = 0;
+    std::atomic<size_t> reads = 0;
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < k_readers; ++t) {
+      readers.emplace_back([&, t] {
+        size_t n = 0;
+        for (size_t i = t; !done.load(std::memory_order_relaxed); ++i, ++n) {
+          auto const r = rec(i % k_records);
+          auto const [va, vb, vs] = lock.read(r, [&] {
+            return std::tuple{ a.read<Int64>(r), b.read<Float64>(r), std::string{str.read<String8>(r)} };
+          });
+          if (vb != va * 0.5 || vs != (va ? fmt::format("update {}", va) : "")) {
+            ++torn;
+          }
+        }
+        reads += n;
+      });
+    }
+
+    for (int64_t i = 1; i <= k_updates; ++i) {
+      auto const r = rec(i % k_records);
+      lock.write(r, [&] {
+        a.write<Int64>(r, i);
+        b.write<Float64>(r, i * 0.5);
+        str.write<String8>(r, fmt::format("update {}", i));
+      });
+    }
+    done = true;
+    for (auto& t : readers) {
+      t.join();
+    }
+
+    REQUIRE(torn == 0);
+    REQUIRE(reads > 0);
+    for (size_t i = 0; i < k_records; ++i) {
+      REQUIRE(lock.sequence(rec(i)) == 2 * (k_updates / k_records));
+    }
+  }
+}
+
+TEST_CASE( "record ring", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Int64 Field",   "", Int64 })
+         .push({ "String8 Field", "", String8, 15 });
+
+  descriptor d {"Ring", builder};
+  auto const& f = d.fields("Int64 Field");
+  auto const& str = d.fields("String8 Field");
+
+  SECTION( "spsc" )
+  {
+    spsc_ring ring{d, 6};
+    REQUIRE(ring.capacity() == 8);
+    REQUIRE(!ring.try_pop([](record) {}));
+
+    for (int64_t i = 0; i < 8; ++i) {
+      REQUIRE(ring.try_push([&](mem_t* mem) { f.write<Int64>(mem, i); str.write<String8>(mem, fmt::format("{}", i)); }));
+    }
+    REQUIRE(ring.size() == 8);
+    REQUIRE(!ring.try_push([](mem_t*) {}));
+
+    for (int64_t i = 0; i < 8; ++i) {
+      REQUIRE(ring.try_pop([&](record r) {
+        REQUIRE(r.get<Int64>(f) == i);
+        REQUIRE(r.get<String8>(str) == fmt::format("{}", i));
+      }));
+    }
+    REQUIRE(!ring.try_pop([](record) {}));
+  }
+
+  SECTION( "spsc threads" )
+  {
+    constexpr int64_t k_count = 100'000;
+    spsc_ring ring{d, 64};
+
+    std::thread producer{[&] {
+      for (int64_t i = 0; i < k_count; ++i) {
+        ring.push([&](mem_t* mem) { f.write<Int64>(mem, i); });
+      }
+    }};
+
+    bool ordered = true;
+    for (int64_t i = 0; i < k_count; ++i) {
+      ring.pop([&](record r) { ordered = ordered && r.get<Int64>(f) == i; });
+    }
+    producer.join();
+    REQUIRE(ordered);
+  }
+
+  SECTION( "mpmc threads" )
+  {
+    constexpr int64_t k_count = 50'000;
+    constexpr int k_threads = 3;
+    mpmc_ring ring{d, 64};
+
+    std::atomic<int64_t> sum = 0;
+    std::atomic<int64_t> popped = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_threads; ++t)
+    {
+      threads.emplace_back([&] {
+        for (int64_t i = 1; i <= k_count; ++i) {
+          ring.push([&](mem_t* mem) { f.write<Int64>(mem, i); });
+        }
+      });
+      threads.emplace_back([&] {
+        for (int64_t i = 0; i < k_count; ++i) {
+          ring.pop([&](record r) { sum += r.get<Int64>(f); });
+        }
+        popped += k_count;
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+
+    REQUIRE(popped == k_threads * k_count);
+    REQUIRE(sum == k_threads * k_count * (k_count + 1) / 2);
+    REQUIRE(!ring.try_pop([](record) {}));
+  }
+
+  SECTION( "mpmc small records" )
+  {
+    // A mem_size() that is not a multiple of 8 still leaves each slot's sequence number 8 byte aligned.
+    rdf::fields_builder small_builder;
+    small_builder.push({ "Int16 Field", "", Int16 })
+                 .push({ "Int8 Field",  "", Int8 });
+    descriptor const small {"Small", small_builder};
+    REQUIRE(small.mem_size() % alignof(uint64_t) != 0);
+    auto const& i16 = small.fields("Int16 Field");
+
+    mpmc_ring ring{small, 8};
+    for (int round = 0; round < 3; ++round) {
+      for (int16_t i = 0; i < 8; ++i) {
+        REQUIRE(ring.try_push([&](mem_t* mem) {
+          REQUIRE(boost::alignment::is_aligned(mem, alignof(uint64_t)));
+          i16.write<Int16>(mem, i);
+        }));
+      }
+      for (int16_t i = 0; i < 8; ++i) {
+        REQUIRE(ring.try_pop([&](record r) { REQUIRE(r.get<Int16>(i16) == i); }));
+      }
+    }
+  }
+}
+
+TEST_CASE( "block reader", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Int64 Field",   "", Int64 })
+         .push({ "String8 Field", "", String8, 15 });
+
+  descriptor d {"Block Reader", builder};
+  auto const& f = d.fields("Int64 Field");
+  REQUIRE(d.mem_size() == 24);
+
+  constexpr int64_t k_count = 10'000;
+  char const* file_name = "./block-reader-test.bin";
+  {
+    auto file = table_file::create(file_name, d, k_count);
+    for (int64_t i = 0; i < k_count; ++i) {
+      f.write<Int64>(file.data() + i * d.mem_size(), i);
+    }
+  }
+
+  for (auto use_io_uring : {true, false})
+  {
+    for (auto direct : {false, true})
+    {
+      DYNAMIC_SECTION( (use_io_uring ? "io_uring" : "pread") << (direct ? " direct" : "") )
+      {
+        block_reader reader{file_name, { .block_bytes = 4096, .depth = 3, .direct = direct, .use_io_uring = use_io_uring }};
+        REQUIRE(reader.size() == k_count);
+        REQUIRE(reader.block_records() == 512);   // lcm(24, 4096) bytes.
+        REQUIRE(reader.uses_io_uring() <= use_io_uring);
+
+        // Whole file and a range starting at an unaligned offset.
+        for (auto [first, count] : { std::pair<size_t, size_t>{0, k_count}, {1001, 5000}, {9999, 100} })
+        {
+          size_t next = first;
+          bool values = true;
+          reader.read([&](record_span<record> records, size_t begin) {
+            values = values && begin == next;
+            for (auto r : records) {
+              values = values && r.get<Int64>(f) == (int64_t)next++;
+            }
+          }, first, count);
+          REQUIRE(values);
+          REQUIRE(next == std::min<size_t>(first + count, k_count));
+        }
+
+        // Buffers remain usable after a consumer throws.
+        REQUIRE_THROWS_WITH(reader.read([](auto, auto) { throw std::runtime_error("consumer"); }), "consumer");
+        size_t total = 0;
+        reader.read([&](record_span<record> records, size_t) { total += records.size(); });
+        REQUIRE(total == k_count);
+      }
+    }
+  }
+
+  std::filesystem::remove(file_name);
+}
+
+TEST_CASE( "key index", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Key16 Field", "", Key16, 30 })
+         .push({ "Int64 Field", "", Int64 });
+
+  descriptor d {"Key Index", builder};
+  auto const& key = d.fields("Key16 Field");
+
+  // 1000 symbols each updated 20 times.
+  constexpr size_t k_symbols = 1000;
+  constexpr size_t k_count = k_symbols * 20;
+  std::vector<mem_t> mem(d.mem_size() * k_count);
+  auto const symbol = [](size_t i) { return fmt::format("AAPL_{}:*", i % k_symbols); };
+  for (size_t i = 0; i < k_count; ++i) {
+    key.write<Key16>(mem.data() + i * d.mem_size(), symbol(i));
+  }
+  record_span<record> const records{mem.data(), d.mem_size(), k_count};
+
+  SECTION( "build" )
+  {
+    key_index index{key};
+    index.build(records);
+    REQUIRE(index.size() == k_symbols);
+    REQUIRE(index.indexed() == k_count);
+    REQUIRE(index.slot_count() <= 4 * k_symbols);     // Sized by the distinct keys, not the records.
+
+    // Latest record for each symbol.
+    for (size_t s = 0; s < k_symbols; ++s) {
+      REQUIRE(index.find(symbol(s), records) == k_count - k_symbols + s);
+    }
+    REQUIRE(index.find("MSFT", records) == key_index::k_npos);
+    REQUIRE(index.find("", records) == key_index::k_npos);
+  }
+
+  SECTION( "incremental update" )
+  {
+    key_index index{key};
+    index.build(records.first(100));
+    REQUIRE(index.size() == 100);
+    REQUIRE(index.find(symbol(999), records) == key_index::k_npos);
+
+    index.update(records.first(5000));
+    REQUIRE(index.size() == k_symbols);
+    REQUIRE(index.find(symbol(5), records) == 4005);
+
+    index.update(records);
+    REQUIRE(index.indexed() == k_count);
+    for (size_t s = 0; s < k_symbols; ++s) {
+      REQUIRE(index.find(symbol(s), records) == k_count - k_symbols + s);
+    }
+  }
+
+  REQUIRE_THROWS_WITH(key_index{d.fields("Int64 Field")}, "cannot index field 'Int64 Field' of type 'i64'");
+}
+
+TEST_CASE( "time index", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Timestamp Field", "", Timestamp })
+         .push({ "Int32 Field",     "", Int32 });
+
+  descriptor d {"Time Index", builder};
+  auto const& ts = d.fields("Timestamp Field");
+
+  // Non-decreasing timestamps with runs of duplicates, gaps and a burst.
+  constexpr size_t k_count = 50'000;
+  std::vector<mem_t> mem(d.mem_size() * k_count);
+  std::vector<raw_time_t> times;
+  raw_time_t t = 1'000'000;
+  std::mt19937_64 rng{42};
+  for (size_t i = 0; i < k_count; ++i) {
+    t += i % 10'000 < 100 ? 0 : (i % 7 == 0 ? (raw_time_t)(rng() % 1'000'000) : 1);
+    times.push_back(t);
+    ts.write<Timestamp>(mem.data() + i * d.mem_size(), util::make_timestamp(t));
+  }
+  record_span<record> const records{mem.data(), d.mem_size(), k_count};
+
+  auto const check = [&](time_index const& index) {
+    for (int q = 0; q < 2000; ++q) {
+      auto const probe = q % 2 ? times[rng() % k_count] : times.front() - 10 + (raw_time_t)(rng() % (times.back() - times.front() + 20));
+      auto const expected_lower = (size_t)(std::ranges::lower_bound(times, probe) - times.begin());
+      auto const expected_upper = (size_t)(std::ranges::upper_bound(times, probe) - times.begin());
+      REQUIRE(index.lower_bound(records, util::make_timestamp(probe)) == expected_lower);
+      REQUIRE(index.upper_bound(records, util::make_timestamp(probe)) == expected_upper);
+    }
+  };
+
+  SECTION( "interpolation" )
+  {
+    time_index index{ts};
+    check(index);
+  }
+
+  SECTION( "sparse index" )
+  {
+    time_index index{ts};
+    index.build(records.first(20'000), 1000);
+    REQUIRE(index.blocks() == 20);
+    index.update(records.first(30'500));
+    REQUIRE(index.blocks() == 31);
+    check(index);    // Includes records past the last update().
+  }
+
+  SECTION( "window" )
+  {
+    time_index index{ts};
+    index.build(records);
+    auto const from = util::make_timestamp(times[1234]);
+    auto const to = util::make_timestamp(times[4321]);
+    auto const window = index.range(records, from, to);
+    REQUIRE(window.size() > 0);
+    for (auto r : window) {
+      REQUIRE(r.get<Timestamp>(ts) >= from);
+      REQUIRE(r.get<Timestamp>(ts) < to);
+    }
+    auto const [begin, end] = index.bounds(records, to, from);
+    REQUIRE(begin == end);
+    REQUIRE(index.bounds(records, util::make_timestamp(0), util::make_timestamp(1)) == std::pair<size_t, size_t>{0, 0});
+  }
+
+  REQUIRE_THROWS(time_index{d.fields("Int32 Field")});
+}
+
+TEST_CASE( "predicate scan", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Int32 Field",     "", Int32 })
+         .push({ "Uint32 Field",    "", Uint32 })
+         .push({ "Int64 Field",     "", Int64 })
+         .push({ "Uint64 Field",    "", Uint64 })
+         .push({ "Float32 Field",   "", Float32 })
+         .push({ "Float64 Field",   "", Float64 })
+         .push({ "Timestamp Field", "", Timestamp })
+         .push({ "Int16 Field",     "", Int16 })
+         .push({ "String8 Field",   "", String8, 5 });
+
+  descriptor d {"Predicate Scan", builder};
+
+  // Not a multiple of 64 so the last selection word is partial. Values are drawn from a small range, around zero and
+  // across the sign bit of the unsigned types, so every predicate selects some records but not all.
+  constexpr size_t k_count = 10'000 + 37;
+  std::vector<mem_t> mem(d.mem_size() * k_count);
+  record_span<record> const records{mem.data(), d.mem_size(), k_count};
+  std::mt19937_64 rng{7};
+  for (size_t i = 0; i < k_count; ++i) {
+    auto const mem_i = mem.data() + i * d.mem_size();
+    auto const v = (int)(rng() % 41) - 20;
+    d.fields("Int32 Field").write<Int32>(mem_i, v);
+    d.fields("Uint32 Field").write<Uint32>(mem_i, (uint32_t)v + 0x80000000u);
+    d.fields("Int64 Field").write<Int64>(mem_i, (int64_t)v << 40);
+    d.fields("Uint64 Field").write<Uint64>(mem_i, (uint64_t)v);
+    d.fields("Float32 Field").write<Float32>(mem_i, i % 101 == 0 ? std::numeric_limits<std::float32_t>::quiet_NaN() : (std::float32_t)v / 4);
+    d.fields("Float64 Field").write<Float64>(mem_i, (std::float64_t)v * 1.5);
+    d.fields("Timestamp Field").write<Timestamp>(mem_i, util::make_timestamp(1'000'000 + v));
+    d.fields("Int16 Field").write<Int16>(mem_i, (int16_t)v);
+  }
+
+  auto const expect = [&](selection const& s, auto&& pred) {
+    REQUIRE(s.size() == k_count);
+    for (size_t i = 0; i < k_count; ++i) {
+      REQUIRE(s.test(i) == pred(records[i]));
+    }
+  };
+
+  auto const check = [&]<type T>(char const* name, value_t<T> a, value_t<T> b) {
+    auto const& f = d.fields(name);
+    auto const get = [&](record r) { return r.get<T>(f); };
+
+    expect(select<T>(records, f, compare_op::eq, a), [&](record r) { return get(r) == a; });
+    expect(select<T>(records, f, compare_op::ne, a), [&](record r) { return get(r) != a; });
+    expect(select<T>(records, f, compare_op::lt, a), [&](record r) { return get(r) <  a; });
+    expect(select<T>(records, f, compare_op::le, a), [&](record r) { return get(r) <= a; });
+    expect(select<T>(records, f, compare_op::gt, a), [&](record r) { return get(r) >  a; });
+    expect(select<T>(records, f, compare_op::ge, a), [&](record r) { return get(r) >= a; });
+    expect(select_between<T>(records, f, a, b), [&](record r) { return a <= get(r) && get(r) <= b; });
+    expect(select_in<T>(records, f, { a, b }), [&](record r) { return get(r) == a || get(r) == b; });
+
+    // Large sets are binary searched.
+    std::vector<value_t<T>> set;
+    for (size_t i = 0; i < 40; i += 2) {
+      set.push_back(get(records[i]));
+    }
+    expect(select_in<T>(records, f, std::span<value_t<T> const>{set}),
+           [&](record r) { return std::ranges::find(set, get(r)) != set.end(); });
+  };
+
+  SECTION( "vectorized types" )
+  {
+    check.operator()<Int32>("Int32 Field", -3, 5);
+    check.operator()<Uint32>("Uint32 Field", 0x80000000u - 3, 0x80000000u + 5);
+    check.operator()<Int64>("Int64 Field", int64_t{-3} << 40, int64_t{5} << 40);
+    check.operator()<Uint64>("Uint64 Field", uint64_t(-3), uint64_t(5));    // Across the sign bit.
+    check.operator()<Float32>("Float32 Field", (std::float32_t)-0.75, (std::float32_t)1.25);
+    check.operator()<Float64>("Float64 Field", (std::float64_t)-4.5, (std::float64_t)7.5);
+    check.operator()<Timestamp>("Timestamp Field", util::make_timestamp(1'000'000 - 3), util::make_timestamp(1'000'000 + 5));
+  }
+
+  SECTION( "scalar types" )
+  {
+    check.operator()<Int16>("Int16 Field", -3, 5);
+  }
+
+  SECTION( "empty and partial ranges" )
+  {
+    auto const& f = d.fields("Int32 Field");
+    REQUIRE(select<Int32>(records.first(0), f, compare_op::ge, -100).empty());
+    auto const s = select<Int32>(records.subspan(3, 70), f, compare_op::ge, -100);
+    REQUIRE(s.size() == 70);
+    REQUIRE(s.count() == 70);
+  }
+
+  SECTION( "combining selections" )
+  {
+    auto const& i32 = d.fields("Int32 Field");
+    auto const& f64 = d.fields("Float64 Field");
+    auto const lt = select<Int32>(records, i32, compare_op::lt, 0);
+    auto const ge = select<Int32>(records, i32, compare_op::ge, 0);
+    REQUIRE((lt & ge).count() == 0);
+    REQUIRE((lt | ge).count() == k_count);
+    REQUIRE(~lt == ge);
+
+    // Same records through two different fields.
+    auto const s = select<Int32>(records, i32, compare_op::gt, 2) & select<Float64>(records, f64, compare_op::lt, 12.0);
+    REQUIRE(s == select_between<Int32>(records, i32, 3, 7));
+
+    std::vector<size_t> selected;
+    s.for_each([&](size_t i) { selected.push_back(i); });
+    REQUIRE(selected.size() == s.count());
+    REQUIRE(std::ranges::is_sorted(selected));
+    for (auto i : selected) {
+      auto const v = records[i].get<Int32>(i32);
+      REQUIRE((v > 2 && v < 8));
+    }
+  }
+
+  REQUIRE_THROWS_WITH(select<Int64>(records, d.fields("Int32 Field"), compare_op::eq, 0),
+                      "cannot scan field 'Int32 Field' of type 'i32' as 'i64'");
+}
+
+TEST_CASE( "aggregate", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Int8 Field",      "", Int8 })
+         .push({ "Int32 Field",     "", Int32 })
+         .push({ "Uint32 Field",    "", Uint32 })
+         .push({ "Int64 Field",     "", Int64 })
+         .push({ "Uint64 Field",    "", Uint64 })
+         .push({ "Float16 Field",   "", Float16 })
+         .push({ "Float32 Field",   "", Float32 })
+         .push({ "Float64 Field",   "", Float64 })
+         .push({ "Float128 Field",  "", Float128 })
+         .push({ "Timestamp Field", "", Timestamp });
+
+  descriptor d {"Aggregate", builder};
+
+  constexpr size_t k_count = 100'000 + 21;
+  std::vector<mem_t> mem(d.mem_size() * k_count);
+  record_span<record> const records{mem.data(), d.mem_size(), k_count};
+  std::mt19937_64 rng{11};
+  for (size_t i = 0; i < k_count; ++i) {
+    auto const mem_i = mem.data() + i * d.mem_size();
+    auto const v = (int64_t)(rng() % 2001) - 1000;
+    d.fields("Int8 Field").write<Int8>(mem_i, (int8_t)(v % 128));
+    d.fields("Int32 Field").write<Int32>(mem_i, (int32_t)v * 1'000'000);
+    d.fields("Uint32 Field").write<Uint32>(mem_i, (uint32_t)(v + 1000) * 4'000'000);
+    d.fields("Int64 Field").write<Int64>(mem_i, (i < k_count / 2 ? 1 : -1) * (int64_t{1} << 62) + v);
+    d.fields("Uint64 Field").write<Uint64>(mem_i, (uint64_t)(v + 1000) << 32);
+    d.fields("Float16 Field").write<Float16>(mem_i, (std::float16_t)(v / 8));
+    d.fields("Float32 Field").write<Float32>(mem_i, (std::float32_t)v / 4);
+    d.fields("Float64 Field").write<Float64>(mem_i, (std::float64_t)v / 3);
+    d.fields("Float128 Field").write<Float128>(mem_i, (std::float128_t)v / 7);
+    d.fields("Timestamp Field").write<Timestamp>(mem_i, util::make_timestamp(1'700'000'000'000'000'000 + v));
+  }
+
+  // Reference results with a plain loop, exact for the integer fields.
+  auto const check = [&]<type T>(char const* name, selection const* where = nullptr) {
+    auto const& f = d.fields(name);
+    auto const a = where ? aggregate<T>(records, f, *where) : aggregate<T>(records, f);
+
+    size_t count = 0;
+    std::optional<value_t<T>> lo, hi;
+    long double sum = 0;
+    for (size_t i = 0; i < k_count; ++i) {
+      if (where && !where->test(i)) {
+        continue;
+      }
+      auto const v = records[i].get<T>(f);
+      ++count;
+      lo = lo ? std::min(*lo, v) : v;
+      hi = hi ? std::max(*hi, v) : v;
+      if constexpr (T == Timestamp) {
+        sum += v.time_since_epoch().count() - 1'700'000'000'000'000'000;
+      }
+      else {
+        sum += (long double)v;
+      }
+    }
+
+    REQUIRE(a.count() == count);
+    REQUIRE(a.min() == *lo);
+    REQUIRE(a.max() == *hi);
+    if constexpr (T == Timestamp) {
+      auto const mean = (a.mean() - util::make_timestamp(1'700'000'000'000'000'000)).count();
+      REQUIRE(std::abs(mean - sum / count) <= 1);
+    }
+    else if constexpr (aggregates<T>::k_floating) {
+      REQUIRE(std::abs((long double)a.sum() - sum) <= 1e-6L * std::abs(sum) + 1e-6L);
+      REQUIRE(std::abs((long double)a.mean() - sum / count) <= 1e-6L);
+    }
+    else if constexpr (std::is_signed_v<value_t<T>>) {
+      REQUIRE(a.sum() == (int64_t)sum);
+    }
+    else {
+      REQUIRE(a.sum() == (uint64_t)sum);
+    }
+  };
+
+  SECTION( "all records" )
+  {
+    check.operator()<Int8>("Int8 Field");
+    check.operator()<Int32>("Int32 Field");
+    check.operator()<Uint32>("Uint32 Field");
+    check.operator()<Uint64>("Uint64 Field");
+    check.operator()<Float16>("Float16 Field");
+    check.operator()<Float32>("Float32 Field");
+    check.operator()<Float64>("Float64 Field");
+    check.operator()<Float128>("Float128 Field");
+    check.operator()<Timestamp>("Timestamp Field");
+
+    // Partial sums overflow 64 bits, the total does not (a wrapping sum of the values is exact).
+    auto const a = aggregate<Int64>(records, d.fields("Int64 Field"));
+    uint64_t expected = 0;
+    for (auto r : records) {
+      expected += (uint64_t)r.get<Int64>(d.fields("Int64 Field"));
+    }
+    REQUIRE(a.sum() == (int64_t)expected);
+    REQUIRE(a.min() < -(int64_t{1} << 61));
+  }
+
+  SECTION( "selection" )
+  {
+    auto const where = select<Int32>(records, d.fields("Int32 Field"), compare_op::gt, 250'000'000);
+    REQUIRE(where.count() > 0);
+    check.operator()<Int32>("Int32 Field", &where);
+    check.operator()<Uint64>("Uint64 Field", &where);
+    check.operator()<Float64>("Float64 Field", &where);
+    check.operator()<Float128>("Float128 Field", &where);
+    check.operator()<Timestamp>("Timestamp Field", &where);
+
+    auto const none = aggregate<Float64>(records, d.fields("Float64 Field"), selection{k_count});
+    REQUIRE(none.empty());
+    REQUIRE(std::isnan(none.mean()));
+  }
+
+  SECTION( "compensated sum" )
+  {
+    // A large value cancelled at the end, the 1.0s in between are lost by a plain double sum.
+    auto const& f = d.fields("Float64 Field");
+    for (size_t i = 0; i < k_count; ++i) {
+      f.write<Float64>(mem.data() + i * d.mem_size(), i == 0 ? 1e17 : i == k_count - 1 ? -1e17 : 1.0);
+    }
+    double plain = 0;
+    for (auto r : records) {
+      plain += r.get<Float64>(f);
+    }
+    REQUIRE(plain != k_count - 2);
+    REQUIRE(aggregate<Float64>(records, f).sum() == k_count - 2);
+  }
+
+  SECTION( "merge and single values" )
+  {
+    auto const& f = d.fields("Int32 Field");
+    auto a = aggregate<Int32>(records.first(5000), f);
+    a.merge(aggregate<Int32>(records.subspan(5000, 100), f));
+    for (size_t i = 5100; i < k_count; ++i) {
+      a.add(records[i].get<Int32>(f));
+    }
+    auto const all = aggregate<Int32>(records, f);
+    REQUIRE(a.count() == all.count());
+    REQUIRE(a.sum() == all.sum());
+    REQUIRE(a.min() == all.min());
+    REQUIRE(a.max() == all.max());
+  }
+
+  SECTION( "overflow" )
+  {
+    auto const& f = d.fields("Uint64 Field");
+    for (size_t i = 0; i < 64; ++i) {
+      f.write<Uint64>(mem.data() + i * d.mem_size(), uint64_t{1} << 63);
+    }
+    REQUIRE_THROWS_WITH(aggregate<Uint64>(records.first(64), f).sum(), "sum of 64 values of type 'u64' overflows");
+    REQUIRE(aggregate<Uint64>(records.first(64), f).mean() == (double)(uint64_t{1} << 63));
+  }
+
+  REQUIRE_THROWS_WITH(aggregate<Int64>(records, d.fields("Int32 Field")),
+                      "cannot aggregate field 'Int32 Field' of type 'i32' as 'i64'");
+}
+
+TEST_CASE( "group by", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Symbol",    "", Key16, 30 })
+         .push({ "Venue",     "", Int32 })
+         .push({ "Size",      "", Int64 })
+         .push({ "Price",     "", Float64 })
+         .push({ "Timestamp", "", Timestamp });
+  descriptor trades {"Trades", builder};
+
+  // 300 symbols on venues -5..4.
+  constexpr size_t k_count = 50'000;
+  std::vector<mem_t> mem(trades.mem_size() * k_count);
+  record_span<record> const records{mem.data(), trades.mem_size(), k_count};
+  std::mt19937_64 rng{5};
+  for (size_t i = 0; i < k_count; ++i) {
+    auto const mem_i = mem.data() + i * trades.mem_size();
+    trades.fields("Symbol").write<Key16>(mem_i, fmt::format("SYM_{}", rng() % 300));
+    trades.fields("Venue").write<Int32>(mem_i, (int32_t)(rng() % 10) - 5);
+    trades.fields("Size").write<Int64>(mem_i, (int64_t)(rng() % 1000));
+    trades.fields("Price").write<Float64>(mem_i, (std::float64_t)(rng() % 10'000) / 100);
+    trades.fields("Timestamp").write<Timestamp>(mem_i, util::make_timestamp((raw_time_t)i * 1000));
+  }
+
+  rdf::fields_builder result_builder;
+  result_builder.push({ "Symbol", "", String16, 40 })
+                .push({ "Volume", "", Uint64 })
+                .push({ "Trades", "", Int32 })
+                .push({ "Mean",   "", Float64 })
+                .push({ "Low",    "", Float32 })
+                .push({ "High",   "", Float64 })
+                .push({ "Last",   "", Timestamp });
+  descriptor rollup {"Rollup", result_builder};
+
+  struct expected_group
+  {
+    uint64_t volume = 0;
+    int32_t trades = 0;
+    double sum = 0;
+    double low = 1e9;
+    double high = -1e9;
+    timestamp_t last{};
+  };
+
+  auto const aggregates = [&] {
+    return std::vector<group_aggregate>{
+      group_aggregate::sum(trades.fields("Size"), rollup.fields("Volume")),
+      group_aggregate::count(rollup.fields("Trades")),
+      group_aggregate::mean(trades.fields("Price"), rollup.fields("Mean")),
+      group_aggregate::min(trades.fields("Price"), rollup.fields("Low")),
+      group_aggregate::max(trades.fields("Price"), rollup.fields("High")),
+      group_aggregate::max(trades.fields("Timestamp"), rollup.fields("Last"))
+    };
+  };
+
+  auto const check = [&](record_buffer const& out, std::map<std::string, expected_group> const& expected) {
+    REQUIRE(out.size() == expected.size());
+    std::set<std::string> seen;
+    for (auto r : out.records()) {
+      auto const key = std::string{r.get<String16>(rollup.fields("Symbol"))};
+      REQUIRE(seen.insert(key).second);
+      REQUIRE(expected.contains(key));
+      auto const& e = expected.at(key);
+      REQUIRE(r.get<Uint64>(rollup.fields("Volume")) == e.volume);
+      REQUIRE(r.get<Int32>(rollup.fields("Trades")) == e.trades);
+      REQUIRE(std::abs(r.get<Float64>(rollup.fields("Mean")) - e.sum / e.trades) < 1e-9);
+      REQUIRE(r.get<Float32>(rollup.fields("Low")) == (std::float32_t)e.low);
+      REQUIRE(r.get<Float64>(rollup.fields("High")) == e.high);
+      REQUIRE(r.get<Timestamp>(rollup.fields("Last")) == e.last);
+    }
+  };
+
+  auto const add = [&](expected_group& e, record r) {
+    e.volume += r.get<Int64>(trades.fields("Size"));
+    e.trades += 1;
+    e.sum += r.get<Float64>(trades.fields("Price"));
+    e.low = std::min<double>(e.low, r.get<Float64>(trades.fields("Price")));
+    e.high = std::max<double>(e.high, r.get<Float64>(trades.fields("Price")));
+    e.last = std::max(e.last, r.get<Timestamp>(trades.fields("Timestamp")));
+  };
+
+  SECTION( "string key" )
+  {
+    group_by volume{trades.fields("Symbol"), rollup, rollup.fields("Symbol"), aggregates()};
+    std::map<std::string, expected_group> expected;
+    for (auto r : records) {
+      add(expected[std::string{r.get<Key16>(trades.fields("Symbol"))}], r);
+    }
+    check(volume(records), expected);
+  }
+
+  SECTION( "string key with selection" )
+  {
+    group_by volume{trades.fields("Symbol"), rollup, rollup.fields("Symbol"), aggregates()};
+    auto const where = select<Int64>(records, trades.fields("Size"), compare_op::ge, 900);
+    std::map<std::string, expected_group> expected;
+    where.for_each([&](size_t i) {
+      add(expected[std::string{records[i].get<Key16>(trades.fields("Symbol"))}], records[i]);
+    });
+    check(volume(records, where), expected);
+
+    REQUIRE(volume(records, selection{k_count}).empty());
+    REQUIRE(volume(records.first(0)).empty());
+  }
+
+  SECTION( "integer key" )
+  {
+    rdf::fields_builder venue_builder;
+    venue_builder.push({ "Venue",  "", Int64 })
+                 .push({ "Trades", "", Float64 })
+                 .push({ "Volume", "", Int64 });
+    descriptor by_venue {"By Venue", venue_builder};
+
+    group_by venues{trades.fields("Venue"), by_venue, by_venue.fields("Venue"),
+                    { group_aggregate::count(by_venue.fields("Trades")),
+                      group_aggregate::sum(trades.fields("Size"), by_venue.fields("Volume")) }};
+    auto const out = venues(records);
+
+    std::map<int64_t, std::pair<size_t, int64_t>> expected;
+    for (auto r : records) {
+      auto& e = expected[r.get<Int32>(trades.fields("Venue"))];
+      e.first += 1;
+      e.second += r.get<Int64>(trades.fields("Size"));
+    }
+    REQUIRE(out.size() == 10);
+    for (auto r : out.records()) {
+      auto const& e = expected.at(r.get<Int64>(by_venue.fields("Venue")));
+      REQUIRE(r.get<Float64>(by_venue.fields("Trades")) == e.first);
+      REQUIRE(r.get<Int64>(by_venue.fields("Volume")) == e.second);
+    }
+  }
+
+  SECTION( "errors" )
+  {
+    REQUIRE_THROWS_WITH(group_aggregate::sum(trades.fields("Symbol"), rollup.fields("Volume")),
+                        "cannot aggregate field 'Symbol' of type '*key16*'");
+    REQUIRE_THROWS_WITH(group_aggregate::sum(trades.fields("Timestamp"), rollup.fields("Last")),
+                        "cannot sum field 'Timestamp' of type 'tstamp'");
+    REQUIRE_THROWS_WITH(group_aggregate::max(trades.fields("Timestamp"), rollup.fields("High")),
+                        "cannot write max of field 'Timestamp' of type 'tstamp' to field 'High' of type 'f64'");
+    REQUIRE_THROWS_WITH(group_aggregate::count(rollup.fields("Symbol")),
+                        "cannot write count to field 'Symbol' of type 'str16'");
+    REQUIRE_THROWS_WITH((group_by{trades.fields("Price"), rollup, rollup.fields("Volume"), {}}),
+                        "cannot group field 'Price' of type 'f64' into field 'Volume' of type 'u64'");
+    REQUIRE_THROWS_WITH((group_by{trades.fields("Symbol"), rollup, rollup.fields("Volume"), {}}),
+                        "cannot group field 'Symbol' of type '*key16*' into field 'Volume' of type 'u64'");
+  }
+}
+
+TEST_CASE( "key dictionary", "[core]" )
+{
+  using namespace types;
+
+  SECTION( "encode and decode" )
+  {
+    key_dictionary dict;
+    REQUIRE(dict.empty());
+    REQUIRE(dict.encode("AAPL") == 0);
+    REQUIRE(dict.encode("MSFT") == 1);
+    REQUIRE(dict.encode("AAPL") == 0);
+    REQUIRE(dict.size() == 2);
+    REQUIRE(dict.decode(1) == "MSFT");
+    REQUIRE(dict.find("MSFT") == 1);
+    REQUIRE(dict.find("IBM") == key_dictionary::k_null_code);
+    REQUIRE(dict.size() == 2);
+
+    std::vector<std::string> const keys{ "b", "a", "" };
+    key_dictionary const from_keys{keys};
+    REQUIRE(from_keys.size() == 3);
+    REQUIRE(from_keys.find("a") == 1);
+    REQUIRE(from_keys.decode(2) == "");
+
+    std::vector<std::string> const duplicates{ "a", "b", "a" };
+    REQUIRE_THROWS_WITH(key_dictionary{duplicates}, "duplicate dictionary key 'a'");
+  }
+
+  SECTION( "concurrent encode" )
+  {
+    key_dictionary dict;
+    constexpr size_t k_keys = 1000;
+    std::vector<key_code_t> codes(20 * k_keys);
+    tbb::parallel_for(size_t{0}, codes.size(), [&](size_t i) {
+      codes[i] = dict.encode(fmt::format("SYM_{}", i % k_keys));
+    });
+
+    REQUIRE(dict.size() == k_keys);
+    std::set<key_code_t> distinct;
+    for (size_t i = 0; i < codes.size(); ++i) {
+      REQUIRE(codes[i] == codes[i % k_keys]);
+      REQUIRE(dict.decode(codes[i]) == fmt::format("SYM_{}", i % k_keys));
+      distinct.insert(codes[i]);
+    }
+    REQUIRE(distinct.size() == k_keys);
+  }
+
+  SECTION( "serialization" )
+  {
+    key_dictionary dict;
+    for (auto key : { "SPY", "QQQ", "", "IWM" }) {
+      dict.encode(key);
+    }
+    auto const bytes = write_dictionary(dict);
+    auto const span = std::span<mem_t const>{reinterpret_cast<mem_t const*>(bytes.data()), bytes.size()};
+    auto const read = read_dictionary(span);
+    REQUIRE(read.size() == dict.size());
+    for (key_code_t code = 0; code < dict.size(); ++code) {
+      REQUIRE(read.decode(code) == dict.decode(code));
+    }
+    REQUIRE_THROWS_WITH(read_dictionary(span.first(span.size() - 1)), "truncated dictionary");
+  }
+
+  SECTION( "records" )
+  {
+    rdf::fields_builder builder;
+    builder.push({ "Symbol", "", KeyDict })
+           .push({ "Size",   "", Int64 });
+    descriptor trades {"Trades", builder};
+    REQUIRE(trades.mem_size() == 16);
+    REQUIRE(trades.fields("Symbol").type_name() == std::string{"*kdict*"});
+
+    key_dictionary dict;
+    constexpr size_t k_count = 10'000;
+    std::vector<mem_t> mem(trades.mem_size() * k_count);
+    record_span<record> const records{mem.data(), trades.mem_size(), k_count};
+    std::map<std::string, std::pair<int32_t, int64_t>> expected;
+    std::mt19937_64 rng{18};
+    for (size_t i = 0; i < k_count; ++i) {
+      auto const symbol = fmt::format("SYM_{}", rng() % 50);
+      auto const size = (int64_t)(rng() % 1000);
+      dict.write(trades.fields("Symbol"), records[i].mem(), symbol);
+      trades.fields("Size").write<Int64>(records[i].mem(), size);
+      expected[symbol].first += 1;
+      expected[symbol].second += size;
+    }
+    REQUIRE(dict.size() == expected.size());
+    REQUIRE(dict.read(trades.fields("Symbol"), records[0].cmem()) == dict.decode(records[0].get<KeyDict>(trades.fields("Symbol"))));
+
+    // Equality on the code.
+    auto const sym_7 = select<KeyDict>(records, trades.fields("Symbol"), compare_op::eq, dict.find("SYM_7"));
+    REQUIRE(sym_7.count() == (size_t)expected.at("SYM_7").first);
+    sym_7.for_each([&](size_t i) { REQUIRE(dict.read(trades.fields("Symbol"), records[i].cmem()) == "SYM_7"); });
+
+    // Grouped by code.
+    rdf::fields_builder result_builder;
+    result_builder.push({ "Symbol", "", KeyDict })
+                  .push({ "Trades", "", Int32 })
+                  .push({ "Volume", "", Int64 });
+    descriptor rollup {"Rollup", result_builder};
+    group_by volume{trades.fields("Symbol"), rollup, rollup.fields("Symbol"),
+                    { group_aggregate::count(rollup.fields("Trades")),
+                      group_aggregate::sum(trades.fields("Size"), rollup.fields("Volume")) }};
+    auto const out = volume(records);
+    REQUIRE(out.size() == expected.size());
+    for (auto r : out.records()) {
+      auto const& e = expected.at(std::string{dict.read(rollup.fields("Symbol"), r.cmem())});
+      REQUIRE(r.get<Int32>(rollup.fields("Trades")) == e.first);
+      REQUIRE(r.get<Int64>(rollup.fields("Volume")) == e.second);
+    }
+
+    REQUIRE_THROWS_WITH((group_by{trades.fields("Symbol"), rollup, rollup.fields("Volume"), {}}),
+                        "cannot group field 'Symbol' of type '*kdict*' into field 'Volume' of type 'i64'");
+    REQUIRE_THROWS_WITH((group_by{trades.fields("Size"), rollup, rollup.fields("Symbol"), {}}),
+                        "cannot group field 'Size' of type 'i64' into field 'Symbol' of type '*kdict*'");
+
+    // Codes are never converted to numbers.
+    REQUIRE(conversions::numeric(KeyDict, Uint32) == nullptr);
+    REQUIRE(conversions::numeric(Int64, KeyDict) == nullptr);
+  }
+}
+
+TEST_CASE( "string arena", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Id",   "", Uint32 })
+         .push({ "Name", "", StringRef });
+  descriptor desc {"Names", builder};
+  REQUIRE(desc.mem_size() == 20);
+  REQUIRE(desc.fields("Name").type_name() == std::string{"strref"});
+
+  SECTION( "inline and out of line" )
+  {
+    string_arena arena;
+    auto const short_ref = arena.append("AAPL");
+    REQUIRE(short_ref.inlined());
+    REQUIRE(arena.size_bytes() == 0);
+    REQUIRE(arena.view(short_ref) == "AAPL");
+
+    auto const twelve = arena.append("123456789012");
+    REQUIRE(twelve.inlined());
+    REQUIRE(arena.size_bytes() == 0);
+
+    auto const long_ref = arena.append("International Business Machines");
+    REQUIRE(!long_ref.inlined());
+    REQUIRE(long_ref.offset() == 0);
+    REQUIRE(arena.size_bytes() == 31);
+    REQUIRE(arena.view(long_ref) == "International Business Machines");
+
+    auto const second = arena.append(std::string(300, 'x'));
+    REQUIRE(second.offset() == 31);
+    REQUIRE(arena.view(second) == std::string(300, 'x'));
+    REQUIRE(arena.view(arena.append("")) == "");
+
+    REQUIRE(arena.equal(long_ref, "International Business Machines"));
+    REQUIRE(!arena.equal(long_ref, "International Business Machinez"));
+    REQUIRE(!arena.equal(long_ref, "Intel"));
+    REQUIRE(arena.equal(short_ref, "AAPL"));
+    REQUIRE(!arena.equal(short_ref, "AAPM"));
+    REQUIRE(arena.append("AAPL") == short_ref);
+
+    // Restored from its bytes.
+    string_arena const copy{arena.bytes()};
+    REQUIRE(copy.view(long_ref) == "International Business Machines");
+    REQUIRE(copy.view(second) == std::string(300, 'x'));
+  }
+
+  SECTION( "records" )
+  {
+    string_arena arena;
+    constexpr size_t k_count = 1000;
+    std::vector<mem_t> mem(desc.mem_size() * k_count);
+    record_span<record> const records{mem.data(), desc.mem_size(), k_count};
+    auto const name = [](size_t i) { return std::string(i % 40, (char)('a' + i % 26)); };
+    for (size_t i = 0; i < k_count; ++i) {
+      desc.fields("Id").write<Uint32>(records[i].mem(), (uint32_t)i);
+      arena.write(desc.fields("Name"), records[i].mem(), name(i));
+    }
+
+    for (size_t i = 0; i < k_count; ++i) {
+      auto const mem_i = records[i].cmem();
+      auto const s = arena.read(desc.fields("Name"), mem_i);
+      REQUIRE(s == name(i));
+      REQUIRE(arena.equal(desc.fields("Name"), mem_i, name(i)));
+      if (s.size() <= string_ref::k_inline) {
+        // Zero-copy, inline strings are viewed in the record.
+        REQUIRE((mem_t const*)s.data() >= mem_i);
+        REQUIRE((mem_t const*)s.data() < mem_i + desc.mem_size());
+      }
+      else {
+        REQUIRE((mem_t const*)s.data() >= arena.bytes().data());
+      }
+    }
+    REQUIRE(records[5].to_string(desc).find("fffff") != std::string::npos);
+    REQUIRE(records[39].to_string(desc).find("<39B @") != std::string::npos);
+
+    // Copied between descriptors as a plain 16 byte value, the arena is shared.
+    rdf::fields_builder names_builder;
+    names_builder.push({ "Name", "", StringRef });
+    descriptor names {"Names Only", names_builder};
+    copy_plan plan{desc, names};
+    std::vector<mem_t> out(names.mem_size());
+    plan.copy(out.data(), records[39].cmem());
+    REQUIRE(arena.read(names.fields("Name"), out.data()) == name(39));
+
+    rdf::fields_builder fixed_builder;
+    fixed_builder.push({ "Name", "", String16, 64 });
+    REQUIRE_THROWS_WITH((copy_plan{desc, descriptor{"Fixed", fixed_builder}}),
+                        "cannot copy field 'Name' of type 'strref' to type 'str16'");
+  }
+}
+
+TEST_CASE( "encoded table", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Symbol",    "", Key16, 30 })
+         .push({ "Venue",     "", String8, 10 })
+         .push({ "Comment",   "", String16, 40 })
+         .push({ "Timestamp", "", Timestamp })
+         .push({ "Side",      "", Char })
+         .push({ "Level",     "", Int8 })
+         .push({ "Delta",     "", Int64 })
+         .push({ "Id",        "", Uint64 })
+         .push({ "Lot",       "", Uint16 })
+         .push({ "Halted",    "", Bool })
+         .push({ "Code",      "", KeyDict })
+         .push({ "Price",     "", Float64 })
+         .push({ "Name",      "", StringRef });
+  descriptor const desc {"Encoded", builder};
+
+  constexpr size_t k_count = 2500;
+  record_buffer rows{desc, k_count};
+  std::mt19937_64 rng{20};
+  string_arena arena;
+  for (size_t i = 0; i < k_count; ++i) {
+    auto const mem = rows[i];
+    desc.fields("Symbol").write<Key16>(mem, fmt::format("SYM_{}", rng() % 40));
+    desc.fields("Venue").write<String8>(mem, i % 3 ? "XNAS" : "ARCX");
+    desc.fields("Comment").write<String16>(mem, fmt::format("comment {}", rng()));
+    desc.fields("Timestamp").write<Timestamp>(mem, util::make_timestamp(1'700'000'000'000'000'000 + (raw_time_t)i * 1'000'000 + (i % 7 == 0)));
+    desc.fields("Side").write<Char>(mem, rng() % 2 ? 'B' : 'S');
+    desc.fields("Level").write<Int8>(mem, (int8_t)(rng() % 256 - 128));
+    desc.fields("Delta").write<Int64>(mem, -(int64_t)(rng() >> 2));
+    desc.fields("Id").write<Uint64>(mem, UINT64_MAX - i * 3);
+    desc.fields("Lot").write<Uint16>(mem, i < 1000 ? 100 : 500);
+    desc.fields("Halted").write<Bool>(mem, i >= 2000);
+    desc.fields("Code").write<KeyDict>(mem, (key_code_t)(rng() % 5));
+    desc.fields("Price").write<Float64>(mem, i % 11 ? (std::float64_t)(rng() % 10'000) / 100 : std::numeric_limits<double>::quiet_NaN());
+    arena.write(desc.fields("Name"), mem, i % 4 ? fmt::format("name {}", i) : fmt::format("a longer name number {}", i % 40));
+  }
+  auto const records = rows.records();
+
+  // Rows from first equal to the n decoded rows, apart from StringRef offsets which depend on the arena.
+  auto const same = [&](mem_t const* out, string_arena const& out_arena, size_t first, size_t n) {
+    auto const& name = desc.fields("Name");
+    for (size_t i = 0; i < n; ++i) {
+      auto const r = out + i * desc.mem_size();
+      if (arena.read(name, rows[first + i]) != out_arena.read(name, r)) {
+        return false;
+      }
+      for (auto const& f : desc.fields()) {
+        if (f.type() != StringRef && std::memcmp(rows[first + i] + f.offset(), r + f.offset(), f.size()) != 0) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  SECTION( "block round trip" )
+  {
+    for (size_t n : { 0, 1, 2, 3, 63, 64, 65, 1000, 2500 })
+    {
+      auto const first = (k_count - n) / 2;
+      auto const bytes = encode_block(desc, records.subspan(first, n), &arena);
+      auto const span = std::as_bytes(std::span{bytes});
+      REQUIRE(block_size(span) == n);
+
+      record_buffer out{desc, std::max<size_t>(n, 1)};
+      string_arena out_arena;
+      REQUIRE(decode_block(desc, span, out.data(), n, &out_arena) == n);
+      REQUIRE(same(out.data(), out_arena, first, n));
+      if (n > 0) {
+        REQUIRE_THROWS_WITH(decode_block(desc, span, out.data(), n - 1, &out_arena), "corrupt encoded block");
+        REQUIRE_THROWS_WITH(decode_block(desc, span.first(span.size() - 1), out.data(), n, &out_arena), "corrupt encoded block");
+      }
+    }
+
+    // Out of line strings are not archived as offsets into an arena that is not stored.
+    REQUIRE_THROWS_WITH(encode_block(desc, records), "field 'Name': string of length 22 needs a string_arena");
+    auto const bytes = encode_block(desc, records, &arena);
+    record_buffer out{desc, k_count};
+    REQUIRE_THROWS_WITH(decode_block(desc, std::as_bytes(std::span{bytes}), out.data(), k_count),
+                        "field 'Name': string of length 22 needs a string_arena");
+    auto const inline_bytes = encode_block(desc, records.subspan(1, 3));
+    REQUIRE(decode_block(desc, std::as_bytes(std::span{inline_bytes}), out.data(), 3) == 3);
+    REQUIRE(same(out.data(), string_arena{}, 1, 3));
+  }
+
+  SECTION( "codecs" )
+  {
+    auto const raw = k_count * desc.mem_size();
+    auto const bytes = encode_block(desc, records, &arena);
+    REQUIRE(bytes.size() * 2 < raw);
+
+    // Regular ticks are a first value, a first difference and zero width differences of differences.
+    rdf::fields_builder ticks_builder;
+    ticks_builder.push({ "Timestamp", "", Timestamp });
+    descriptor const ticks {"Ticks", ticks_builder};
+    record_buffer tick_rows{ticks, k_count};
+    for (size_t i = 0; i < k_count; ++i) {
+      ticks.fields("Timestamp").write<Timestamp>(tick_rows[i], util::make_timestamp(1'700'000'000'000'000'000 + (raw_time_t)i * 1000));
+    }
+    REQUIRE(encode_block(ticks, tick_rows.records()).size() < 64);
+
+    // Integer packing at every width.
+    rdf::fields_builder ints_builder;
+    ints_builder.push({ "Value", "", Uint64 });
+    descriptor const ints {"Ints", ints_builder};
+    record_buffer int_rows{ints, 200};
+    record_buffer out{ints, 200};
+    for (unsigned w = 0; w <= 64; ++w) {
+      for (size_t i = 0; i < 200; ++i) {
+        ints.fields("Value").write<Uint64>(int_rows[i], w == 0 ? 7 : (rng() >> (64 - w)) | (uint64_t{1} << (w - 1)));
+      }
+      auto const bytes = encode_block(ints, int_rows.records());
+      REQUIRE(decode_block(ints, std::as_bytes(std::span{bytes}), out.data(), 200) == 200);
+      REQUIRE(std::memcmp(out.data(), int_rows.data(), int_rows.size_bytes()) == 0);
+    }
+  }
+
+  char const* file_name = "./encoded-table-test.bin";
+
+  SECTION( "file" )
+  {
+    encoded_table::write(file_name, desc, records, 1000, &arena);
+    auto const table = encoded_table::open(file_name);
+    REQUIRE(table.desc() == desc);
+    REQUIRE(table.size() == k_count);
+    REQUIRE(table.block_count() == 3);
+    REQUIRE(table.block_size(2) == 500);
+    REQUIRE(table.block_first(2) == 2000);
+    REQUIRE(table.size_bytes() * 2 < k_count * desc.mem_size());
+
+    // Strings are appended to a non empty arena, so the refs of every block are moved.
+    string_arena out_arena;
+    out_arena.append(std::string(100, 'x'));
+    auto const all = table.decode(&out_arena);
+    REQUIRE(all.size() == k_count);
+    REQUIRE(same(all.data(), out_arena, 0, k_count));
+    REQUIRE(out_arena.read(desc.fields("Name"), all[1234]) == "name 1234");
+    REQUIRE(out_arena.read(desc.fields("Name"), all[2000]) == "a longer name number 0");
+
+    std::atomic<size_t> scanned = 0;
+    std::atomic<bool> match = true;
+    table.scan([&](size_t first, record_span<record> block, string_arena const& strings) {
+      scanned += block.size();
+      match = match && same(block.data(), strings, first, block.size());
+    });
+    REQUIRE(scanned == k_count);
+    REQUIRE(match);
+    REQUIRE_THROWS_WITH(table.scan([](size_t, record_span<record>) {}), Catch::Matchers::Contains("needs a string_arena"));
+
+    encoded_table::write(file_name, desc, records.first(0));
+    REQUIRE(encoded_table::open(file_name).size() == 0);
+    REQUIRE(encoded_table::open(file_name).decode().empty());
+  }
+
+  SECTION( "invalid files" )
+  {
+    using namespace Catch::Matchers;
+
+    {
+      std::ofstream file{file_name, std::ios::binary | std::ios::trunc};
+      file << "not a table";
+    }
+    REQUIRE_THROWS_WITH(encoded_table::open(file_name), Contains("too small to be an encoded table file"));
+
+    {
+      std::ofstream file{file_name, std::ios::binary | std::ios::trunc};
+      file << std::string(sizeof(encoded_header), 'x');
+    }
+    REQUIRE_THROWS_WITH(encoded_table::open(file_name), Contains("is not an encoded table file"));
+
+    encoded_table::write(file_name, desc, records, 1000, &arena);
+    std::filesystem::resize_file(file_name, std::filesystem::file_size(file_name) - 1);
+    REQUIRE_THROWS_WITH(encoded_table::open(file_name), Contains("is truncated"));
+  }
+
+  std::filesystem::remove(file_name);
+}
+
+TEST_CASE( "record formatter", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Symbol",    "", Key16, 30 })
+         .push({ "Comment",   "", String16, 40 })
+         .push({ "Timestamp", "", Timestamp })
+         .push({ "Side",      "", Char })
+         .push({ "Level",     "", Int8 })
+         .push({ "Id",        "", Uint64 })
+         .push({ "Halted",    "", Bool })
+         .push({ "Code",      "", KeyDict })
+         .push({ "Price",     "", Float64 })
+         .push({ "Ratio",     "", Float32 })
+         .push({ "Name",      "", StringRef });
+  descriptor const desc {"Formatted", builder};
+
+  key_dictionary dict;
+  string_arena arena;
+  record_buffer rows{desc, 3};
+  auto const fill = [&](size_t i, string_t symbol, string_t comment, raw_time_t ns, char side, int8_t level,
+                        uint64_t id, bool halted, string_t code, double price, float ratio, string_t name) {
+    auto const mem = rows[i];
+    desc.fields("Symbol").write<Key16>(mem, symbol);
+    desc.fields("Comment").write<String16>(mem, comment);
+    desc.fields("Timestamp").write<Timestamp>(mem, util::make_timestamp(ns));
+    desc.fields("Side").write<Char>(mem, side);
+    desc.fields("Level").write<Int8>(mem, level);
+    desc.fields("Id").write<Uint64>(mem, id);
+    desc.fields("Halted").write<Bool>(mem, halted);
+    dict.write(desc.fields("Code"), mem, code);
+    desc.fields("Price").write<Float64>(mem, price);
+    desc.fields("Ratio").write<Float32>(mem, ratio);
+    arena.write(desc.fields("Name"), mem, name);
+  };
+  fill(0, "IBM", "plain", 1505481094356648000, 'B', -128, UINT64_MAX, false, "XNYS", 145.25, 0.5f, "International Business Machines");
+  fill(1, "T", "with, a \"quote\"", 0, ',', 127, 0, true, "XNAS", -0.1, 1e-10f, "AT&T");
+  fill(2, "X", "two\nlines", -1, 'S', 0, 42, false, "XNYS", 1e300, -3.f, "");
+  auto const records = rows.records();
+
+  SECTION( "csv" )
+  {
+    record_formatter const csv{desc, { .dictionary = &dict, .arena = &arena }};
+    std::string text;
+    csv.header(text);
+    csv.format(records, text);
+    REQUIRE(text == "Symbol,Comment,Timestamp,Side,Level,Id,Halted,Code,Price,Ratio,Name\n"
+                    "IBM,plain,20170915 13:11:34.356648000,B,-128,18446744073709551615,false,XNYS,145.25,0.5,International Business Machines\n"
+                    "T,\"with, a \"\"quote\"\"\",19700101 00:00:00.000000000,\",\",127,0,true,XNAS,-0.1,1e-10,AT&T\n"
+                    "X,\"two\nlines\",19691231 23:59:59.999999999,S,0,42,false,XNYS,1e+300,-3,\n");
+
+    // Appends, so a buffer can be reused.
+    auto const size = text.size();
+    csv.format(records[0], text);
+    REQUIRE(text.substr(size) == "IBM,plain,20170915 13:11:34.356648000,B,-128,18446744073709551615,false,XNYS,145.25,0.5,International Business Machines\n");
+  }
+
+  SECTION( "tsv" )
+  {
+    record_formatter const tsv{desc, { .delimiter = '\t', .time_format = "%F %T" }};
+    std::string text;
+    tsv.format(records.first(2), text);
+    REQUIRE(text == "IBM\tplain\t2017-09-15 13:11:34.356648000\tB\t-128\t18446744073709551615\tfalse\t0\t145.25\t0.5\t<31B @0>\n"
+                    "T\t\"with, a \"\"quote\"\"\"\t1970-01-01 00:00:00.000000000\t,\t127\t0\ttrue\t1\t-0.1\t1e-10\tAT&T\n");
+
+    REQUIRE_THROWS_WITH((record_formatter{desc, { .delimiter = '"' }}), "invalid delimiter '\"'");
+  }
+
+  SECTION( "float128" )
+  {
+    rdf::fields_builder wide_builder;
+    wide_builder.push({ "Wide", "", Float128 });
+    descriptor const wide {"Wide", wide_builder};
+    record_buffer one{wide, 1};
+    auto const third = (std::float128_t)1 / 3;
+    wide.fields("Wide").write<Float128>(one[0], third);
+
+    // Written at full precision, beyond the 17 significant digits of a double.
+    std::string text;
+    record_formatter{wide, { .header = false }}.format(one.records(), text);
+    REQUIRE(text.size() > 30);
+    std::float128_t read;
+    REQUIRE(std::from_chars(text.data(), text.data() + text.size() - 1, read).ec == std::errc{});
+    REQUIRE(read == third);
+  }
+
+  SECTION( "export" )
+  {
+    constexpr size_t k_count = 10'000;
+    record_buffer many{desc, k_count};
+    for (size_t i = 0; i < k_count; ++i) {
+      std::memcpy(many[i], rows[i % 3], desc.mem_size());
+    }
+
+    record_formatter const csv{desc, { .dictionary = &dict, .arena = &arena }};
+    std::string expected;
+    csv.header(expected);
+    csv.format(many.records(), expected);
+
+    for (size_t chunk : { 1, 7, 4096, 20'000 }) {
+      std::ostringstream os;
+      REQUIRE(export_text(os, csv, many.records(), chunk) == expected.size());
+      REQUIRE(os.str() == expected);
+    }
+
+    char const* file_name = "./record-formatter-test.csv";
+    REQUIRE(export_text(file_name, desc, many.records(), { .dictionary = &dict, .arena = &arena }) == expected.size());
+    std::ifstream file{file_name, std::ios::binary};
+    REQUIRE(std::string{std::istreambuf_iterator<char>{file}, {}} == expected);
+    file.close();
+    std::filesystem::remove(file_name);
+  }
+}
+
+TEST_CASE( "record parser", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Symbol",    "", Key16, 30 })
+         .push({ "Comment",   "", String16, 40 })
+         .push({ "Timestamp", "", Timestamp })
+         .push({ "Side",      "", Char })
+         .push({ "Level",     "", Int8 })
+         .push({ "Id",        "", Uint64 })
+         .push({ "Halted",    "", Bool })
+         .push({ "Code",      "", KeyDict })
+         .push({ "Price",     "", Float64 })
+         .push({ "Ratio",     "", Float32 })
+         .push({ "Name",      "", StringRef });
+  descriptor const desc {"Parsed", builder};
+
+  constexpr size_t k_count = 3000;
+  key_dictionary dict;
+  string_arena arena;
+  record_buffer rows{desc, k_count};
+  std::mt19937_64 rng{23};
+  for (size_t i = 0; i < k_count; ++i) {
+    auto const mem = rows[i];
+    desc.fields("Symbol").write<Key16>(mem, fmt::format("SYM_{}", rng() % 40));
+    desc.fields("Comment").write<String16>(mem, i % 5 ? fmt::format("comment {}", rng() % 1000) : "with, \"quotes\"\nand lines");
+    desc.fields("Timestamp").write<Timestamp>(mem, util::make_timestamp(1'700'000'000'000'000'000 + (raw_time_t)(rng() >> 8)));
+    desc.fields("Side").write<Char>(mem, i % 7 ? 'B' : ',');
+    desc.fields("Level").write<Int8>(mem, (int8_t)(rng() % 256 - 128));
+    desc.fields("Id").write<Uint64>(mem, rng());
+    desc.fields("Halted").write<Bool>(mem, i % 3 == 0);
+    dict.write(desc.fields("Code"), mem, fmt::format("CODE_{}", rng() % 7));
+    desc.fields("Price").write<Float64>(mem, (double)(rng() % 100'000) / 100);
+    desc.fields("Ratio").write<Float32>(mem, (float)(rng() % 1000) / 7);
+    arena.write(desc.fields("Name"), mem, i % 2 ? fmt::format("a longer name number {}", i) : "short");
+  }
+
+  record_formatter const csv{desc, { .dictionary = &dict, .arena = &arena }};
+  std::string text;
+  csv.header(text);
+  csv.format(rows.records(), text);
+
+  // Equal apart from StringRef offsets, which depend on the arena.
+  auto const same = [&](record_buffer const& out, string_arena const& out_arena) {
+    if (out.size() != rows.size()) {
+      return false;
+    }
+    auto const& name = desc.fields("Name");
+    for (size_t i = 0; i < rows.size(); ++i) {
+      if (arena.read(name, rows[i]) != out_arena.read(name, out[i])) {
+        return false;
+      }
+      for (auto const& f : desc.fields()) {
+        if (f.type() != StringRef && std::memcmp(rows[i] + f.offset(), out[i] + f.offset(), f.size()) != 0) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  SECTION( "round trip" )
+  {
+    // Small chunks split rows, quoted fields and escaped quotes.
+    for (size_t chunk_bytes : { 1, 13, 100, 4096, 1 << 24 }) {
+      string_arena out_arena;
+      record_parser const parser{desc, { .dictionary = &dict, .arena = &out_arena, .chunk_bytes = chunk_bytes }};
+      auto const result = parser.parse(text);
+      REQUIRE(result.errors.empty());
+      REQUIRE(same(result.records, out_arena));
+    }
+  }
+
+  SECTION( "columns" )
+  {
+    // Matched by name: reordered, unknown columns skipped, missing fields zero. Blank lines, "\r\n" and a BOM.
+    record_parser const parser{desc};
+    auto const result = parser.parse("\xEF\xBB\xBFId,Unknown,Symbol,Name\r\n"
+                                     "42,x,IBM,short\r\n"
+                                     "\r\n"
+                                     "\n"
+                                     "7,,\"T\",\n");
+    REQUIRE(result.errors.empty());
+    REQUIRE(result.records.size() == 2);
+    auto const r = result.records.records();
+    REQUIRE(r[0].get<Uint64>(desc.fields("Id")) == 42);
+    REQUIRE(r[0].get<Key16>(desc.fields("Symbol")) == "IBM");
+    REQUIRE(string_arena{}.view(r[0].get<StringRef>(desc.fields("Name"))) == "short");
+    REQUIRE(r[0].get<Int8>(desc.fields("Level")) == 0);
+    REQUIRE(r[1].get<Uint64>(desc.fields("Id")) == 7);
+    REQUIRE(r[1].get<Key16>(desc.fields("Symbol")) == "T");
+    REQUIRE(r[1].get<StringRef>(desc.fields("Name")).length_ == 0);
+
+    REQUIRE_THROWS_WITH(parser.parse("Id,Id\n"), "duplicate column 'Id'");
+
+    // Without a header, TSV.
+    record_parser const tsv{desc, { .delimiter = '\t', .header = false }};
+    auto const plain = tsv.parse("IBM\tnote\t20170915 13:11:34.5\tS\t-3\t9\ttrue\t4\t1.5\t0.25\tname\n");
+    REQUIRE(plain.errors.empty());
+    REQUIRE(plain.records.size() == 1);
+    auto const p = plain.records.records()[0];
+    REQUIRE(p.get<Timestamp>(desc.fields("Timestamp")) == util::make_timestamp(1505481094500000000));
+    REQUIRE(p.get<Char>(desc.fields("Side")) == 'S');
+    REQUIRE(p.get<Int8>(desc.fields("Level")) == -3);
+    REQUIRE(p.get<Bool>(desc.fields("Halted")));
+    REQUIRE(p.get<KeyDict>(desc.fields("Code")) == 4);
+    REQUIRE(p.get<Float64>(desc.fields("Price")) == 1.5);
+    REQUIRE(p.get<Float32>(desc.fields("Ratio")) == 0.25f);
+  }
+
+  SECTION( "errors" )
+  {
+    // Bad rows are reported and skipped, the rest are kept.
+    std::string const bad = "Symbol,Level,Timestamp,Name\n"
+                            "A,1,20170915 13:11:34,x\n"
+                            "B,300,20170915 13:11:34,x\n"
+                            "C,2,2017-09-15,x\n"
+                            "D,3,20170915 13:11:34\n"
+                            "E,4,20170915 13:11:34,\"quoted\"oops\n"
+                            "F,5,20170915 13:11:34,a name too long to be inline\n"
+                            "G,6,20170915 13:11:34,\"fine\"\n";
+    for (size_t chunk_bytes : { 1, 16, 1 << 20 }) {
+      auto const result = record_parser{desc, { .chunk_bytes = chunk_bytes }}.parse(bad);
+      REQUIRE(result.records.size() == 2);
+      REQUIRE(result.records.records()[0].get<Key16>(desc.fields("Symbol")) == "A");
+      REQUIRE(result.records.records()[1].get<Key16>(desc.fields("Symbol")) == "G");
+
+      REQUIRE(result.errors.size() == 5);
+      REQUIRE(result.errors[0].row == 1);
+      REQUIRE(result.errors[0].offset == bad.find("B,"));
+      REQUIRE(result.errors[0].message == "field 'Level': invalid i8 value '300'");
+      REQUIRE(result.errors[1].row == 2);
+      REQUIRE(result.errors[1].message == "field 'Timestamp': failed to parse timestamp string '2017-09-15' with format '%Y%m%d %T'");
+      REQUIRE(result.errors[2].message == "row has 3 fields, expected 4");
+      REQUIRE(result.errors[3].message == "field 'Name': unexpected character after a quoted field");
+      REQUIRE(result.errors[4].row == 5);
+      REQUIRE(result.errors[4].message == "field 'Name': string of length 28 needs a string_arena");
+    }
+  }
+
+  SECTION( "bare cr" )
+  {
+    // A '\r' not followed by '\n' is field data, so it never ends a row, quoted or not.
+    std::string const cr = "Symbol,Comment,Level\r\n"
+                           "A,x\ry,1\n"
+                           "B,\"p\rq\",2\r\n"
+                           "C,z,3\r4,5\n"
+                           "D,\"w\"\rv,6\n"
+                           "E,\r,7\r";
+    for (size_t chunk_bytes : { 1, 3, 16, 1 << 20 }) {
+      auto const result = record_parser{desc, { .chunk_bytes = chunk_bytes }}.parse(cr);
+      REQUIRE(result.records.size() == 3);
+      auto const r = result.records.records();
+      REQUIRE(r[0].get<String16>(desc.fields("Comment")) == "x\ry");
+      REQUIRE(r[1].get<String16>(desc.fields("Comment")) == "p\rq");
+      REQUIRE(r[2].get<Key16>(desc.fields("Symbol")) == "E");
+      REQUIRE(r[2].get<String16>(desc.fields("Comment")) == "\r");
+      REQUIRE(r[2].get<Int8>(desc.fields("Level")) == 7);
+
+      REQUIRE(result.errors.size() == 2);
+      REQUIRE(result.errors[0].offset == cr.find("C,"));
+      REQUIRE(result.errors[0].message == "field 'Level': invalid i8 value '3\r4'");
+      REQUIRE(result.errors[1].offset == cr.find("D,"));
+      REQUIRE(result.errors[1].message == "field 'Comment': unexpected character after a quoted field");
+    }
+  }
+
+  SECTION( "stray quote" )
+  {
+    // A quote inside an unquoted field is data, though it flips the count of quotes the chunks are split by.
+    std::string const stray = "Symbol,Comment,Level\n"
+                              "A,5\"x,1\n"
+                              "B,y,2\n"
+                              "C,\"z\nw\",3\n"
+                              "D,12\",4\n";
+    for (size_t chunk_bytes : { 1, 3, 8, 16, 1 << 20 }) {
+      auto const result = record_parser{desc, { .chunk_bytes = chunk_bytes }}.parse(stray);
+      REQUIRE(result.errors.empty());
+      REQUIRE(result.records.size() == 4);
+      auto const r = result.records.records();
+      REQUIRE(r[0].get<String16>(desc.fields("Comment")) == "5\"x");
+      REQUIRE(r[1].get<Key16>(desc.fields("Symbol")) == "B");
+      REQUIRE(r[2].get<String16>(desc.fields("Comment")) == "z\nw");
+      REQUIRE(r[3].get<String16>(desc.fields("Comment")) == "12\"");
+      REQUIRE(r[3].get<Int8>(desc.fields("Level")) == 4);
+    }
+  }
+
+  SECTION( "float128" )
+  {
+    // An export / import round trip keeps the full precision.
+    rdf::fields_builder wide_builder;
+    wide_builder.push({ "Wide", "", Float128 });
+    descriptor const wide {"Wide", wide_builder};
+    record_buffer values{wide, 3};
+    auto const& f = wide.fields("Wide");
+    f.write<Float128>(values[0], (std::float128_t)1 / 3);
+    f.write<Float128>(values[1], -(std::float128_t)2 / 7 * 1e300);
+    f.write<Float128>(values[2], (std::float128_t)1e-300 / 9);
+
+    std::string wide_text;
+    record_formatter{wide}.format(values.records(), wide_text);
+    auto const result = record_parser{wide, { .header = false }}.parse(wide_text);
+    REQUIRE(result.errors.empty());
+    REQUIRE(std::memcmp(result.records.data(), values.data(), values.size_bytes()) == 0);
+  }
+
+  SECTION( "import" )
+  {
+    char const* file_name = "./record-parser-test.csv";
+    export_text(file_name, desc, rows.records(), { .dictionary = &dict, .arena = &arena });
+
+    string_arena out_arena;
+    auto const result = import_text(file_name, desc, { .dictionary = &dict, .arena = &out_arena, .chunk_bytes = 64 * 1024 });
+    REQUIRE(result.errors.empty());
+    REQUIRE(same(result.records, out_arena));
+    std::filesystem::remove(file_name);
+
+    REQUIRE_THROWS_WITH(import_text(file_name, desc), "text file './record-parser-test.csv' does not exist");
+  }
+}
+
+TEST_CASE( "arrow export", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Symbol",    "", Key16, 30 })
+         .push({ "Timestamp", "", Timestamp })
+         .push({ "Side",      "", Char })
+         .push({ "Qty",       "", Int32 })
+         .push({ "Id",        "", Uint64 })
+         .push({ "Halted",    "", Bool })
+         .push({ "Code",      "", KeyDict })
+         .push({ "Price",     "", Float64 })
+         .push({ "Wide",      "", Float128 })
+         .push({ "Name",      "", StringRef });
+  descriptor const desc {"Quotes", builder};
+
+  constexpr size_t k_count = 1000;
+  key_dictionary dict;
+  string_arena arena;
+  record_buffer rows{desc, k_count};
+  for (size_t i = 0; i < k_count; ++i) {
+    auto const mem = rows[i];
+    desc.fields("Symbol").write<Key16>(mem, fmt::format("SYM{}", i % 37));
+    desc.fields("Timestamp").write<Timestamp>(mem, util::make_timestamp(i * 1000 - 500));
+    desc.fields("Side").write<Char>(mem, i % 2 ? 'B' : 'S');
+    desc.fields("Qty").write<Int32>(mem, (int32_t)i * -7);
+    desc.fields("Id").write<Uint64>(mem, UINT64_MAX - i);
+    desc.fields("Halted").write<Bool>(mem, i % 3 == 0);
+    dict.write(desc.fields("Code"), mem, i % 5 ? "XNYS" : "XNAS");
+    desc.fields("Price").write<Float64>(mem, i * 0.25);
+    desc.fields("Wide").write<Float128>(mem, (std::float128_t)(i * 1.5));
+    arena.write(desc.fields("Name"), mem, i % 4 ? fmt::format("name {}", i) : fmt::format("a much longer name {}", i));
+  }
+  auto const records = rows.records();
+  arrow_export_options const opts{ .dictionary = &dict, .arena = &arena };
+
+  auto const child = [&](ArrowArray const& a, string_t name) -> ArrowArray const& { return *a.children[desc.fields(name).index()]; };
+  auto const values = []<typename V>(ArrowArray const& a, V) { return static_cast<V const*>(a.buffers[1]); };
+  auto const string = [](ArrowArray const& a, size_t i) {
+    auto const offsets = static_cast<int32_t const*>(a.buffers[1]);
+    return string_t{static_cast<char const*>(a.buffers[2]) + offsets[i], size_t(offsets[i + 1] - offsets[i])};
+  };
+
+  // Checks rows [first, first + a.length) of the records.
+  auto const check = [&](ArrowArray const& a, size_t first) {
+    REQUIRE(a.n_children == (int64_t)desc.fields().size());
+    REQUIRE(a.n_buffers == 1);
+    REQUIRE(a.buffers[0] == nullptr);
+    for (int64_t c = 0; c < a.n_children; ++c) {
+      REQUIRE(a.children[c]->length == a.length);
+      REQUIRE(a.children[c]->null_count == 0);
+      REQUIRE(a.children[c]->buffers[0] == nullptr);
+    }
+    auto const& code = child(a, "Code");
+    REQUIRE(code.dictionary != nullptr);
+    REQUIRE(code.dictionary->length == 2);
+
+    for (int64_t j = 0; j < a.length; ++j) {
+      auto const r = records[first + j];
+      REQUIRE(string(child(a, "Symbol"), j) == r.get<Key16>(desc.fields("Symbol")));
+      REQUIRE(values(child(a, "Timestamp"), int64_t{})[j] == r.get<Timestamp>(desc.fields("Timestamp")).time_since_epoch().count());
+      REQUIRE(values(child(a, "Side"), char{})[j] == r.get<Char>(desc.fields("Side")));
+      REQUIRE(values(child(a, "Qty"), int32_t{})[j] == r.get<Int32>(desc.fields("Qty")));
+      REQUIRE(values(child(a, "Id"), uint64_t{})[j] == r.get<Uint64>(desc.fields("Id")));
+      auto const bits = values(child(a, "Halted"), uint8_t{});
+      REQUIRE(bool(bits[j / 8] >> (j % 8) & 1) == r.get<Bool>(desc.fields("Halted")));
+      REQUIRE(string(*code.dictionary, values(code, uint32_t{})[j]) == dict.read(desc.fields("Code"), r.cmem()));
+      REQUIRE(values(child(a, "Price"), double{})[j] == r.get<Float64>(desc.fields("Price")));
+      REQUIRE(values(child(a, "Wide"), double{})[j] == (double)r.get<Float128>(desc.fields("Wide")));
+      REQUIRE(string(child(a, "Name"), j) == arena.read(desc.fields("Name"), r.cmem()));
+    }
+  };
+
+  SECTION( "schema" )
+  {
+    ArrowSchema schema;
+    export_arrow_schema(desc, &schema, opts);
+    REQUIRE(schema.format == std::string{"+s"});
+    REQUIRE(schema.name == std::string{"Quotes"});
+    REQUIRE(schema.n_children == 10);
+
+    std::vector<std::string> formats;
+    for (int64_t c = 0; c < schema.n_children; ++c) {
+      REQUIRE(schema.children[c]->name == desc.fields()[c].name());
+      REQUIRE(schema.children[c]->flags == 0);
+      formats.push_back(schema.children[c]->format);
+    }
+    REQUIRE(formats == std::vector<std::string>{ "u", "tsn:UTC", "w:1", "i", "L", "b", "I", "g", "g", "u" });
+    REQUIRE(schema.children[desc.fields("Code").index()]->dictionary->format == std::string{"u"});
+    REQUIRE(schema.children[0]->dictionary == nullptr);
+
+    schema.release(&schema);
+    REQUIRE(schema.release == nullptr);
+
+    // Without a dictionary KeyDict fields are plain codes.
+    export_arrow_schema(desc, &schema);
+    REQUIRE(schema.children[desc.fields("Code").index()]->dictionary == nullptr);
+    schema.release(&schema);
+  }
+
+  SECTION( "records" )
+  {
+    ArrowArray array;
+    export_arrow(desc, records, &array, opts);
+    REQUIRE(array.length == k_count);
+    check(array, 0);
+
+    // A child moved out by the consumer stays valid after its parent is released.
+    auto& qty = *array.children[desc.fields("Qty").index()];
+    ArrowArray moved = qty;
+    qty.release = nullptr;
+    array.release(&array);
+    REQUIRE(array.release == nullptr);
+
+    REQUIRE(values(moved, int32_t{})[k_count - 1] == (int32_t)(k_count - 1) * -7);
+    moved.release(&moved);
+    REQUIRE(moved.release == nullptr);
+  }
+
+  SECTION( "zero copy" )
+  {
+    column_table table{desc, k_count};
+    table.from_rows(records.data(), k_count);
+
+    ArrowArray array;
+    export_arrow(table, 100, 250, &array, opts);
+    REQUIRE(array.length == 250);
+    check(array, 100);
+
+    auto const& f = desc.fields("Qty");
+    REQUIRE(child(array, "Qty").buffers[1] == table.data(f) + 100 * sizeof(int32_t));
+    REQUIRE(child(array, "Timestamp").buffers[1] == table.data(desc.fields("Timestamp")) + 100 * sizeof(raw_time_t));
+    array.release(&array);
+
+    export_arrow(table, &array, opts);
+    REQUIRE(array.length == k_count);
+    check(array, 0);
+    array.release(&array);
+
+    REQUIRE_THROWS_WITH(export_arrow(table, 900, 101, &array, opts), "rows [900, 1001) are outside a table of 1000 rows");
+    REQUIRE_THROWS_WITH(export_arrow(table, &array, { .dictionary = &dict }), "field 'Name': string of length 20 needs a string_arena");
+  }
+}
+
+TEST_CASE( "hot cold layout", "[core]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Comment",   "", String16, 200 })
+         .push({ "Flag",      "", Bool })
+         .push({ "Symbol",    "", Key8, 15 })
+         .push({ "Venue",     "", String8, 40 })
+         .push({ "Bid",       "", Float64 })
+         .push({ "Timestamp", "", Timestamp })
+         .push({ "Seq",       "", Uint32 })
+         .push({ "Ask",       "", Float64 })
+         .push({ "Wide",      "", Float128 })
+         .push({ "Qty",       "", Int32 })
+         .push({ "Side",      "", Char })
+         .push({ "Id",        "", Uint64 })
+         .push({ "Level",     "", Int16 });
+
+  descriptor::field_weights const weights{ {"Timestamp", 10}, {"Bid", 8}, {"Ask", 8}, {"Qty", 6}, {"Symbol", 5},
+                                           {"Side", 4}, {"Seq", 1} };
+  descriptor const d {"Hot Cold", builder, weights};
+  descriptor const packed {"Packed", builder};
+  SPDLOG_DEBUG(d.describe(true));
+
+  REQUIRE(d.layout() == descriptor::layout_kind::hot_cold);
+  REQUIRE(d.packed());
+  REQUIRE(packed.layout() == descriptor::layout_kind::packed);
+  REQUIRE(d.weight(d.fields("Timestamp").index()) == 10);
+  REQUIRE(d.weight(d.fields("Comment").index()) == 0);
+  REQUIRE(packed.weight(0) == 0);
+
+  SECTION( "placement" )
+  {
+    // Aligned and not overlapping.
+    std::vector<field> by_offset = d.fields();
+    std::ranges::sort(by_offset, {}, &field::offset);
+    for (size_t i = 0; i < by_offset.size(); ++i) {
+      REQUIRE(by_offset[i].offset() % by_offset[i].align() == 0);
+      if (i > 0) {
+        REQUIRE(by_offset[i].offset() >= by_offset[i - 1].offset() + by_offset[i - 1].size());
+      }
+    }
+    REQUIRE(by_offset.back().offset() + by_offset.back().size() <= d.mem_size());
+
+    // The hot fixed size fields share the first cache line, the hot string follows them and the cold strings are last.
+    for (auto name : { "Timestamp", "Bid", "Ask", "Qty", "Side", "Seq" }) {
+      REQUIRE(d.fields(name).offset() + d.fields(name).size() <= descriptor::k_cache_line);
+    }
+    REQUIRE(d.fields("Symbol").offset() == 33);
+    REQUIRE(by_offset[by_offset.size() - 2].name() == "Venue");
+    REQUIRE(by_offset.back().name() == "Comment");
+
+    // Whole cache lines.
+    REQUIRE(d.mem_align() == descriptor::k_cache_line);
+    REQUIRE(d.mem_size() % descriptor::k_cache_line == 0);
+
+    // In the packed layout the same hot fields span cache lines.
+    auto const last_line = [](descriptor const& desc) {
+      size_t line = 0;
+      for (auto name : { "Timestamp", "Bid", "Ask", "Qty", "Side", "Seq" }) {
+        line = std::max<size_t>(line, (desc.fields(name).offset() + desc.fields(name).size() - 1) / descriptor::k_cache_line);
+      }
+      return line;
+    };
+    REQUIRE(last_line(d) == 0);
+    REQUIRE(last_line(packed) > 0);
+
+    auto const text = d.describe(true);
+    REQUIRE(text.find("-- cache line 0 (offset 0) --") != std::string::npos);
+    REQUIRE(text.find("-- cache line 1 (offset 64) --") != std::string::npos);
+    REQUIRE(text.find("weight: 10") != std::string::npos);
+  }
+
+  SECTION( "heaviest first" )
+  {
+    // More hot bytes than a cache line: the heaviest fields take the first line, lighter ones fill its gaps.
+    rdf::fields_builder wide;
+    for (int i = 0; i < 10; ++i) {
+      wide.push({ fmt::format("F{}", i), "", Float64 });
+    }
+    wide.push({ "Small", "", Int8 });
+
+    descriptor::field_weights heavy;
+    for (int i = 0; i < 10; ++i) {
+      heavy.push_back({ fmt::format("F{}", i), 10.0 - i });
+    }
+    heavy.push_back({ "Small", 0.5 });
+    descriptor const w {"Wide", wide, heavy};
+    for (int i = 0; i < 8; ++i) {
+      REQUIRE(w.fields(fmt::format("F{}", i)).offset() < descriptor::k_cache_line);
+    }
+    REQUIRE(w.fields("F8").offset() == descriptor::k_cache_line);
+    REQUIRE(w.fields("Small").offset() == descriptor::k_cache_line + 16);
+    REQUIRE(w.mem_size() == 2 * descriptor::k_cache_line);
+
+    // A record that fits in a cache line is packed, and padded to a power of two.
+    rdf::fields_builder small;
+    small.push({ "A", "", Int64 }).push({ "B", "", Int32 }).push({ "C", "", Int8 });
+    descriptor const s {"Small", small, descriptor::field_weights{ {"C", 1} }};
+    REQUIRE(s.fields("C").offset() == 12);
+    REQUIRE(s.mem_size() == 16);
+    REQUIRE(s.mem_align() == 16);
+  }
+
+  SECTION( "access" )
+  {
+    std::vector<mem_t> mem(d.mem_size());
+    d.fields("Timestamp").write<Timestamp>(mem.data(), util::make_timestamp(123));
+    d.fields("Symbol").write<Key8>(mem.data(), "IBM");
+    d.fields("Comment").write<String16>(mem.data(), "cold");
+    d.fields("Bid").write<Float64>(mem.data(), 1.5);
+    REQUIRE(d.fields("Timestamp").read<Timestamp>(mem.data()) == util::make_timestamp(123));
+    REQUIRE(d.fields("Symbol").read<Key8>(mem.data()) == "IBM");
+    REQUIRE(d.fields("Comment").read<String16>(mem.data()) == "cold");
+    REQUIRE(d.fields("Bid").read<Float64>(mem.data()) == 1.5);
+  }
+
+  SECTION( "serialization" )
+  {
+    auto const bytes = write_descriptor(d);
+    auto const read = read_descriptor({ reinterpret_cast<mem_t const*>(bytes.data()), bytes.size() });
+    REQUIRE(read == d);
+    REQUIRE(read.layout() == descriptor::layout_kind::hot_cold);
+    REQUIRE(read.weight(read.fields("Bid").index()) == 8);
+  }
+
+  SECTION( "errors" )
+  {
+    REQUIRE_THROWS_WITH((descriptor{"Bad", builder, descriptor::field_weights{ {"Missing", 1} }}), "no field named 'Missing' in descriptor 'Bad'");
+    REQUIRE_THROWS_WITH((descriptor{"Bad", builder, descriptor::field_weights{ {"Bid", -1} }}), "field 'Bid' has invalid weight -1");
+  }
+}
+
+TEST_CASE( "time format", "[core]" )
+{
+  util::time_fmt const tf{"%Y%m%d %T"};
+  auto const ts = util::make_timestamp(1505481094356648000);
+
+  SECTION( "compiled" )
+  {
+    REQUIRE(tf.compiled());
+    REQUIRE(tf.size() == 27);
+    REQUIRE(tf.to_str(ts) == "20170915 13:11:34.356648000");
+    REQUIRE(tf.to_time("20170915 13:11:34.356648000") == ts);
+
+    char buf[27];
+    REQUIRE(tf.to_chars(buf, ts) == buf + sizeof(buf));
+    REQUIRE(std::string_view{buf, sizeof(buf)} == "20170915 13:11:34.356648000");
+  }
+
+  SECTION( "fractions" )
+  {
+    REQUIRE(tf.to_time("20170915 13:11:34.356648") == ts);
+    REQUIRE(tf.to_time("20170915 13:11:34.3") == util::make_timestamp(1505481094300000000));
+    REQUIRE(tf.to_time("20170915 13:11:34") == util::make_timestamp(1505481094000000000));
+    REQUIRE(tf.to_str(util::make_timestamp(-1)) == "19691231 23:59:59.999999999");
+  }
+
+  SECTION( "layouts" )
+  {
+    util::time_fmt const iso{"%FT%T"};
+    REQUIRE(iso.compiled());
+    REQUIRE(iso.to_str(ts) == "2017-09-15T13:11:34.356648000");
+    REQUIRE(iso.to_time("2017-09-15T13:11:34.356648000") == ts);
+
+    util::time_fmt const date{"%d/%m/%Y"};
+    REQUIRE(date.to_str(ts) == "15/09/2017");
+    REQUIRE(date.to_time("15/09/2017") == util::make_timestamp(1505433600000000000));
+
+    REQUIRE(!util::time_fmt{"%Y%m%d %X"}.compiled());
+  }
+
+  SECTION( "invalid" )
+  {
+    for (auto s : { "20170931 13:11:34.356648000",      // No 31st of September.
+                    "20170915 24:11:34.356648000",
+                    "2017091a 13:11:34.356648000",
+                    "20170915-13:11:34.356648000",
+                    "20170915 13:11:34.3566480001",
+                    "20170915 13:11:34.",
+                    "20170915" })
+    {
+      REQUIRE_THROWS_WITH(tf.to_time(s), fmt::format("failed to parse timestamp string '{}' with format '%Y%m%d %T'", s));
+    }
+  }
+
+  SECTION( "round trip" )
+  {
+    for (int64_t ns = -9'000'000'000'000'000'000; ns < 9'000'000'000'000'000'000; ns += 999'999'999'999'989) {
+      REQUIRE(tf.to_time(tf.to_str(util::make_timestamp(ns))) == util::make_timestamp(ns));
+    }
+  }
+}
+
 TEST_CASE( "timestamp", "[core]" )
 {
   SECTION( "raw symetry" ) 
@@ -11,9 +11,42 @@
 #include <oneapi/tbb.h>
 #include <ranges>
 #include <fstream>
+#include <random>
 
 namespace rdf {
 
+// Test a descriptor with all supported types.
+inline descriptor make_all_fields_descriptor()
+{
+  using field = rdf::field;
+
+  rdf::fields_builder builder;
+  builder.push({ "Key8 Field",       "Key8 field description",       Key8, 31})
+         .push({ "Key16 Field",      "Key16 field description",      Key16, 254 })
+         .push({ "String8 Field",    "String8 field description",    String8, 31 })
+         .push({ "String16 Field",   "String16 field description",   String16, 254 })
+         .push({ "Timestamp Field",  "Timestamp field description",  Timestamp, field::k_no_payload, fmt::runtime("{:>40}") })
+         .push({ "Char Field",       "Char field description",       Char })
+         .push({ "Utf_Char8 Field",  "Utf_Char8 field description",  Utf_Char8 })
+         .push({ "Utf_Char16 Field", "Utf_Char16 field description", Utf_Char16 })
+         .push({ "Utf_Char32 Field", "Utf_Char32 field description", Utf_Char32 })
+         .push({ "Int8 Field",       "Int8 field description",       Int8 })
+         .push({ "Int16 Field",      "Int16 field description",      Int16 })
+         .push({ "Int32 Field",      "Int32 field description",      Int32 })
+         .push({ "Int64 Field",      "Int64 field description",      Int64 })
+         .push({ "Uint8 Field",      "Uint8 field description",      Uint8 })
+         .push({ "Uint16 Field",     "Uint16 field description",     Uint16 })
+         .push({ "Uint32 Field",     "Uint32 field description",     Uint32 })
+         .push({ "Uint64 Field",     "Uint64 field description",     Uint64 })
+         .push({ "Float16 Field",    "Float16 field description",    Float16 })
+         .push({ "Float32 Field",    "Float32 field description",    Float32 })
+         .push({ "Float64 Field",    "Float64 field description",    Float64 })
+         .push({ "Float128 Field",   "Float128 field description",   Float128 })
+         .push({ "Bool Field",       "Bool field description",       Bool });
+
+  return descriptor{"All Fields Test Descriptor", builder};
+}
+
 inline void generate_records(mem_t* dest, descriptor const& d, size_t count)
 {
   auto mem = dest;
@@ -73,40 +106,64 @@ inline void generate_records(mem_t* dest, descriptor const& d, size_t count)
   d.fields(21ul).write<Bool>     ( wm, d.fields(21ul).read<Bool>     (rm) );
 // }
 
+// Compile-time equivalent of the "All Fields Test Descriptor" used below.
+using all_fields_static_descriptor = static_descriptor<true,
+                                                       static_field<"Key8 Field",       Key8, 31>,
+                                                       static_field<"Key16 Field",      Key16, 254>,
+                                                       static_field<"String8 Field",    String8, 31>,
+                                                       static_field<"String16 Field",   String16, 254>,
+                                                       static_field<"Timestamp Field",  Timestamp>,
+                                                       static_field<"Char Field",       Char>,
+                                                       static_field<"Utf_Char8 Field",  Utf_Char8>,
+                                                       static_field<"Utf_Char16 Field", Utf_Char16>,
+                                                       static_field<"Utf_Char32 Field", Utf_Char32>,
+                                                       static_field<"Int8 Field",       Int8>,
+                                                       static_field<"Int16 Field",      Int16>,
+                                                       static_field<"Int32 Field",      Int32>,
+                                                       static_field<"Int64 Field",      Int64>,
+                                                       static_field<"Uint8 Field",      Uint8>,
+                                                       static_field<"Uint16 Field",     Uint16>,
+                                                       static_field<"Uint32 Field",     Uint32>,
+                                                       static_field<"Uint64 Field",     Uint64>,
+                                                       static_field<"Float16 Field",    Float16>,
+                                                       static_field<"Float32 Field",    Float32>,
+                                                       static_field<"Float64 Field",    Float64>,
+                                                       static_field<"Float128 Field",   Float128>,
+                                                       static_field<"Bool Field",       Bool>>;
+
+template <class S>
+inline void static_fields_read_write(mem_t* wm, mem_t const* rm)
+{
+  [=]<size_t... I>(std::index_sequence<I...>) {
+    (S::template write<I>(wm, S::template read<I>(rm)), ...);
+  }(std::make_index_sequence<S::k_count>{});
+}
+
+TEST_CASE( "field lookup", "[!benchmark]" )
+{
+  rdf::fields_builder builder;
+  for (int i = 0; i < 22; ++i) {
+    builder.push({ fmt::format("Field {}", i), "", Int64 });
+  }
+  descriptor d {"Lookup Descriptor", builder};
+
+  std::string const name = "Field 17";
+  static constexpr field_name k_token{"Field 17"};
+  auto const handle = d.handle(name);
+
+  BENCHMARK("by name (std::string)") { return d.fields(name).offset(); };
+  BENCHMARK("by name (string literal)") { return d.fields("Field 17").offset(); };
+  BENCHMARK("by name (constexpr token)") { return d.fields(k_token).offset(); };
+  BENCHMARK("by handle") { return d.fields(handle).offset(); };
+}
+
 TEST_CASE( "read/write", "[!benchmark]" )
 {
-  using field = rdf::field;
   using namespace types;
   namespace ipc = boost::interprocess;
   namespace bal = boost::alignment;
 
-  // Test a descriptor with all supported types.
-  rdf::fields_builder builder;
-  builder.push({ "Key8 Field",       "Key8 field description",       Key8, 31})
-         .push({ "Key16 Field",      "Key16 field description",      Key16, 254 })
-         .push({ "String8 Field",    "String8 field description",    String8, 31 })
-         .push({ "String16 Field",   "String16 field description",   String16, 254 })
-         .push({ "Timestamp Field",  "Timestamp field description",  Timestamp, field::k_no_payload, fmt::runtime("{:>40}") })
-         .push({ "Char Field",       "Char field description",       Char })
-         .push({ "Utf_Char8 Field",  "Utf_Char8 field description",  Utf_Char8 })
-         .push({ "Utf_Char16 Field", "Utf_Char16 field description", Utf_Char16 })
-         .push({ "Utf_Char32 Field", "Utf_Char32 field description", Utf_Char32 })
-         .push({ "Int8 Field",       "Int8 field description",       Int8 })
-         .push({ "Int16 Field",      "Int16 field description",      Int16 })
-         .push({ "Int32 Field",      "Int32 field description",      Int32 })
-         .push({ "Int64 Field",      "Int64 field description",      Int64 })
-         .push({ "Uint8 Field",      "Uint8 field description",      Uint8 })
-         .push({ "Uint16 Field",     "Uint16 field description",     Uint16 })
-         .push({ "Uint32 Field",     "Uint32 field description",     Uint32 })
-         .push({ "Uint64 Field",     "Uint64 field description",     Uint64 })
-         .push({ "Float16 Field",    "Float16 field description",    Float16 })
-         .push({ "Float32 Field",    "Float32 field description",    Float32 })
-         .push({ "Float64 Field",    "Float64 field description",    Float64 })
-         .push({ "Float128 Field",   "Float128 field description",   Float128 })
-         .push({ "Bool Field",       "Bool field description",       Bool });
-
-
-  descriptor desc {"All Fields Test Descriptor", builder};
+  auto const desc = make_all_fields_descriptor();
 
   // Size of the test data.
   constexpr auto k_desired_file_size = 1024 * 1024 * 1024; // 1 GB.
@@ -221,6 +278,50 @@ TEST_CASE( "read/write", "[!benchmark]" )
     REQUIRE(std::memcmp(src_file_addr, dest_file_addr, file_size) == 0);
   }
 
+  SECTION("rdf copy plan")
+  {
+    copy_plan const plan{desc, desc};
+    REQUIRE(plan.trivial());
+
+    BENCHMARK_ADVANCED("rdf copy plan")(Catch::Benchmark::Chronometer meter)
+    {
+      meter.measure(
+        [=, &plan]()
+        {
+          plan.copy((mem_t*)dest_file_addr, src_mem, record_count);
+        });
+    };
+
+    REQUIRE(std::memcmp(src_file_addr, dest_file_addr, file_size) == 0);
+  }
+
+  SECTION("rdf static descriptor (field read / write)")
+  {
+    using sd = all_fields_static_descriptor;
+    REQUIRE(sd::matches(desc));
+
+    // As "rdf (field read / write)" but with offsets and types resolved at compile time.
+    BENCHMARK_ADVANCED("rdf static descriptor (field read / write)")(Catch::Benchmark::Chronometer meter)
+    {
+      meter.measure(
+        [=]()
+        {
+          auto write_mem = (mem_t*)dest_file_addr;
+          mem_t* read_mem = src_mem;
+
+          for (int64_t i = 0; i < (int64_t)record_count; ++i)
+          {
+            static_fields_read_write<sd>(write_mem, read_mem);
+
+            read_mem += sd::mem_size();
+            write_mem += sd::mem_size();
+          }
+        });
+    };
+
+    REQUIRE(std::memcmp(src_file_addr, dest_file_addr, file_size) == 0);
+  }
+
   SECTION("rdf (record read / field write)")
   {
     // Read records from file and write to a second file.
@@ -270,4 +371,859 @@ TEST_CASE( "read/write", "[!benchmark]" )
   }
 }
 
+TEST_CASE( "columnar", "[!benchmark]" )
+{
+  using namespace types;
+
+  auto const desc = make_all_fields_descriptor();
+  auto const& f = desc.fields("Int64 Field");
+
+  constexpr size_t k_count = 256 * 1024;
+  mem_t* const rows = (mem_t*)std::aligned_alloc(desc.mem_align(), desc.mem_size() * k_count);
+  generate_records(rows, desc, k_count);
+
+  column_table table{desc, k_count};
+  table.from_rows(rows, k_count);
+
+  BENCHMARK("row scan (sum Int64 Field)")
+  {
+    int64_t sum = 0;
+    for (size_t i = 0; i < k_count; ++i) {
+      sum += f.read<Int64>(rows + i * desc.mem_size());
+    }
+    return sum;
+  };
+
+  BENCHMARK("column scan (sum Int64 Field)")
+  {
+    auto const column = table.column<Int64>(f);
+    return std::accumulate(column.begin(), column.end(), int64_t{0});
+  };
+
+  BENCHMARK("transpose row -> column")
+  {
+    table.from_rows(rows, k_count);
+  };
+
+  std::vector<mem_t> out(desc.mem_size() * k_count);
+  BENCHMARK("transpose column -> row")
+  {
+    table.to_rows(out.data(), k_count);
+  };
+
+  free(rows);
+}
+
+TEST_CASE( "record iteration", "[!benchmark]" )
+{
+  using namespace types;
+
+  auto const desc = make_all_fields_descriptor();
+  auto const& f = desc.fields("Int64 Field");
+
+  constexpr size_t k_count = 256 * 1024;
+  mem_t* const rows = (mem_t*)std::aligned_alloc(desc.mem_align(), desc.mem_size() * k_count);
+  generate_records(rows, desc, k_count);
+  mspan const mem{rows, desc.mem_size() * k_count};
+
+  BENCHMARK("pointer loop")
+  {
+    int64_t sum = 0;
+    for (auto p = rows, end = rows + desc.mem_size() * k_count; p != end; p += desc.mem_size()) {
+      sum += f.read<Int64>(p);
+    }
+    return sum;
+  };
+
+  BENCHMARK("std::views::stride | std::views::transform")
+  {
+    int64_t sum = 0;
+    for (auto r : mem | std::views::stride(desc.mem_size()) | std::views::transform(mem_to_record<record>)) {
+      sum += r.get<Int64>(f);
+    }
+    return sum;
+  };
+
+  BENCHMARK("record_span")
+  {
+    int64_t sum = 0;
+    for (auto r : views::records<record>(mem, desc)) {
+      sum += r.get<Int64>(f);
+    }
+    return sum;
+  };
+
+  BENCHMARK("record_span (tbb parallel_reduce)")
+  {
+    return tbb::parallel_reduce(views::records<record>(mem, desc).with_grain(4096), int64_t{0},
+      [&](record_span<record> const& range, int64_t sum)
+      {
+        for (auto r : range) {
+          sum += r.get<Int64>(f);
+        }
+        return sum;
+      },
+      std::plus<int64_t>{});
+  };
+
+  free(rows);
+}
+
+TEST_CASE( "follower latency", "[!benchmark]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Int64 Field", "", Int64 });
+  descriptor const desc {"Follower", builder};
+  char const* file_name = "./follower-test.bin";
+
+  for (auto use_inotify : {true, false})
+  {
+    table_appender appender{table_file::create(file_name, desc, 0), table_appender::k_default_extent, true};
+    table_follower follower{file_name, 0, 1ms, use_inotify};
+
+    std::atomic<size_t> delivered = 0;
+    follower.subscribe([&](table_file const&, size_t, size_t end) { delivered.store(end, std::memory_order_release); });
+    std::jthread thread{[&](std::stop_token stop) { follower.run(stop); }};
+
+    // Time from publishing a record to the follower delivering it.
+    BENCHMARK(use_inotify ? "publish to delivery (inotify)" : "publish to delivery (1ms polling)")
+    {
+      std::memset(appender.next(), 0, desc.mem_size());
+      appender.publish();
+      while (delivered.load(std::memory_order_acquire) != appender.committed()) {
+        std::this_thread::yield();
+      }
+      return appender.committed();
+    };
+  }
+
+  std::filesystem::remove(file_name);
+}
+
+template <class Ring>
+void ring_benchmark(char const* name)
+{
+  using namespace types;
+
+  // A typical quote update.
+  rdf::fields_builder builder;
+  builder.push({ "Key8 Field",      "", Key8, 15 })
+         .push({ "Timestamp Field", "", Timestamp })
+         .push({ "Float64 Field",   "", Float64 })
+         .push({ "Int64 Field",     "", Int64 });
+  descriptor const desc {"Quote", builder};
+  auto const& ts = desc.fields("Timestamp Field");
+  auto const& price = desc.fields("Float64 Field");
+
+  constexpr size_t k_count = 1'000'000;
+  Ring ring{desc, 4096};
+
+  auto const now = [] { return timestamp_t{std::chrono::steady_clock::now().time_since_epoch()}; };
+
+  BENCHMARK(fmt::format("{} throughput ({} records)", name, k_count))
+  {
+    std::thread producer{[&] {
+      for (size_t i = 0; i < k_count; ++i) {
+        ring.push([&](mem_t* mem) { price.write<Float64>(mem, (double)i); });
+      }
+    }};
+    double sum = 0;
+    for (size_t i = 0; i < k_count; ++i) {
+      ring.pop([&](record r) { sum += r.get<Float64>(price); });
+    }
+    producer.join();
+    return sum;
+  };
+
+  // Producer to consumer latency, stamped by the producer at the time of the write. The producer waits for each record
+  // to be consumed so the figures measure the hand-off rather than time spent queued behind earlier records.
+  constexpr size_t k_latency_count = 100'000;
+  std::vector<int64_t> latencies(k_latency_count);
+  std::thread producer{[&] {
+    for (size_t i = 0; i < k_latency_count; ++i) {
+      ring.push([&](mem_t* mem) { ts.write<Timestamp>(mem, now()); });
+      while (ring.size() != 0) {
+        std::this_thread::yield();
+      }
+    }
+  }};
+  for (size_t i = 0; i < k_latency_count; ++i) {
+    ring.pop([&](record r) { latencies[i] = (now() - r.get<Timestamp>(ts)).count(); });
+  }
+  producer.join();
+
+  std::ranges::sort(latencies);
+  auto const percentile = [&](double p) { return latencies[std::min(k_latency_count - 1, (size_t)(p * k_latency_count))]; };
+  SPDLOG_INFO("{} latency (ns): p50 {}, p99 {}, p999 {}, max {}", name, percentile(0.5), percentile(0.99), percentile(0.999), latencies.back());
+}
+
+TEST_CASE( "ring buffer", "[!benchmark]" )
+{
+  ring_benchmark<spsc_ring>("spsc");
+  ring_benchmark<mpmc_ring>("mpmc");
+}
+
+TEST_CASE( "block streaming", "[!benchmark]" )
+{
+  using namespace types;
+
+  auto const desc = make_all_fields_descriptor();
+  auto const& f = desc.fields("Int64 Field");
+  char const* file_name = "./block-reader-test.bin";
+
+  constexpr size_t k_count = 64 * 1024;
+  {
+    auto file = table_file::create(file_name, desc, k_count);
+    generate_records(file.data(), desc, k_count);
+  }
+
+  // The file is in the page cache here, so this compares the per-record cost of each path rather than cold reads.
+  BENCHMARK("mapped scan")
+  {
+    auto const file = table_file::open(file_name);
+    int64_t sum = 0;
+    for (auto r : file.records()) {
+      sum += r.get<Int64>(f);
+    }
+    return sum;
+  };
+
+  auto const scan = [&](block_reader::options const& opts)
+  {
+    block_reader reader{file_name, opts};
+    int64_t sum = 0;
+    reader.read([&](record_span<record> records, size_t) {
+      for (auto r : records) {
+        sum += r.get<Int64>(f);
+      }
+    });
+    return sum;
+  };
+
+  BENCHMARK("block reader (io_uring)")        { return scan({ .use_io_uring = true }); };
+  BENCHMARK("block reader (pread)")           { return scan({ .use_io_uring = false }); };
+  BENCHMARK("block reader (io_uring, direct)") { return scan({ .direct = true, .use_io_uring = true }); };
+
+  std::filesystem::remove(file_name);
+}
+
+TEST_CASE( "key lookup", "[!benchmark]" )
+{
+  using namespace types;
+
+  auto const desc = make_all_fields_descriptor();
+  auto const& key = desc.fields("Key8 Field");    // Distinct for every record.
+
+  constexpr size_t k_count = 256 * 1024;
+  mem_t* const rows = (mem_t*)std::aligned_alloc(desc.mem_align(), desc.mem_size() * k_count);
+  generate_records(rows, desc, k_count);
+  record_span<record> const records{rows, desc.mem_size(), k_count};
+
+  auto const target = fmt::format("_B[_{}d:{}d]", k_count / 2, k_count / 2 + 1);
+
+  BENCHMARK("single lookup (scan)")
+  {
+    for (size_t i = 0; i < k_count; ++i) {
+      if (records[i].get<Key8>(key) == target) {
+        return i;
+      }
+    }
+    return key_index::k_npos;
+  };
+
+  key_index index{key};
+  BENCHMARK("build index (tbb)")
+  {
+    index.build(records);
+    return index.size();
+  };
+
+  BENCHMARK("single lookup (index)")
+  {
+    return index.find(target, records);
+  };
+
+  free(rows);
+}
+
+TEST_CASE( "time window", "[!benchmark]" )
+{
+  using namespace types;
+
+  auto const desc = make_all_fields_descriptor();
+  auto const& ts = desc.fields("Timestamp Field");    // i * 10000, see generate_records().
+
+  constexpr size_t k_count = 256 * 1024;
+  mem_t* const rows = (mem_t*)std::aligned_alloc(desc.mem_align(), desc.mem_size() * k_count);
+  generate_records(rows, desc, k_count);
+  record_span<record> const records{rows, desc.mem_size(), k_count};
+
+  auto const from = util::make_timestamp(100'000 * 10000);
+  auto const to = util::make_timestamp(101'000 * 10000);
+
+  BENCHMARK("window (scan)")
+  {
+    size_t begin = k_count, end = k_count;
+    for (size_t i = 0; i < k_count; ++i) {
+      auto const t = records[i].get<Timestamp>(ts);
+      if (t >= from && begin == k_count) {
+        begin = i;
+      }
+      if (t >= to) {
+        end = i;
+        break;
+      }
+    }
+    return end - begin;
+  };
+
+  time_index index{ts};
+  BENCHMARK("window (interpolation search)")
+  {
+    return index.range(records, from, to).size();
+  };
+
+  index.build(records);
+  BENCHMARK("window (sparse index)")
+  {
+    return index.range(records, from, to).size();
+  };
+
+  free(rows);
+}
+
+TEST_CASE( "filter scan", "[!benchmark]" )
+{
+  using namespace types;
+
+  // Narrow records, where the per-record branch rather than memory traffic limits the plain loop.
+  rdf::fields_builder builder;
+  builder.push({ "Float64 Field", "", Float64 })
+         .push({ "Int32 Field",   "", Int32 })
+         .push({ "Uint16 Field",  "", Uint16 });
+  descriptor desc{"Scan", builder};
+  auto const& price = desc.fields("Float64 Field");
+
+  constexpr size_t k_count = 4 * 1024 * 1024;
+  mem_t* const rows = (mem_t*)std::aligned_alloc(desc.mem_align(), desc.mem_size() * k_count);
+  std::mt19937_64 rng{1};
+  for (size_t i = 0; i < k_count; ++i) {
+    price.write<Float64>(rows + i * desc.mem_size(), (std::float64_t)(rng() % 1000));
+  }
+  record_span<record> const records{rows, desc.mem_size(), k_count};
+
+  // Half the records match, in random order, the worst case for a branch per record.
+  BENCHMARK("price > 500 (branch per record)")
+  {
+    selection s{k_count};
+    for (size_t i = 0; i < k_count; ++i) {
+      if (records[i].get<Float64>(price) > 500) {
+        s.set(i);
+      }
+    }
+    return s.count();
+  };
+
+  BENCHMARK("price > 500 (scan)")
+  {
+    return select<Float64>(records, price, compare_op::gt, 500).count();
+  };
+
+  BENCHMARK("100 <= price <= 200 (scan)")
+  {
+    return select_between<Float64>(records, price, 100, 200).count();
+  };
+
+  BENCHMARK("price in 8 values (scan)")
+  {
+    return select_in<Float64>(records, price, { 1, 10, 100, 200, 300, 400, 500, 900 }).count();
+  };
+
+  free(rows);
+}
+
+TEST_CASE( "aggregation", "[!benchmark]" )
+{
+  using namespace types;
+
+  rdf::fields_builder builder;
+  builder.push({ "Float64 Field", "", Float64 })
+         .push({ "Int64 Field",   "", Int64 })
+         .push({ "Int32 Field",   "", Int32 });
+  descriptor desc{"Aggregation", builder};
+  auto const& price = desc.fields("Float64 Field");
+  auto const& size = desc.fields("Int64 Field");
+
+  constexpr size_t k_count = 4 * 1024 * 1024;
+  mem_t* const rows = (mem_t*)std::aligned_alloc(desc.mem_align(), desc.mem_size() * k_count);
+  std::mt19937_64 rng{2};
+  for (size_t i = 0; i < k_count; ++i) {
+    price.write<Float64>(rows + i * desc.mem_size(), (std::float64_t)(rng() % 100'000) / 100);
+    size.write<Int64>(rows + i * desc.mem_size(), (int64_t)(rng() % 1000));
+  }
+  record_span<record> const records{rows, desc.mem_size(), k_count};
+
+  BENCHMARK("sum/min/max price (loop)")
+  {
+    double sum = 0;
+    auto lo = std::numeric_limits<double>::infinity();
+    auto hi = -lo;
+    for (auto r : records) {
+      auto const p = r.get<Float64>(price);
+      sum += p;
+      lo = std::min<double>(lo, p);
+      hi = std::max<double>(hi, p);
+    }
+    return sum + lo + hi;
+  };
+
+  BENCHMARK("sum/min/max price (aggregate)")
+  {
+    auto const a = aggregate<Float64>(records, price);
+    return a.sum() + a.min() + a.max();
+  };
+
+  BENCHMARK("sum/min/max size (loop)")
+  {
+    int64_t sum = 0;
+    auto lo = std::numeric_limits<int64_t>::max();
+    auto hi = std::numeric_limits<int64_t>::min();
+    for (auto r : records) {
+      auto const s = r.get<Int64>(size);
+      sum += s;
+      lo = std::min<int64_t>(lo, s);
+      hi = std::max<int64_t>(hi, s);
+    }
+    return sum + lo + hi;
+  };
+
+  BENCHMARK("sum/min/max size (aggregate)")
+  {
+    auto const a = aggregate<Int64>(records, size);
+    return a.sum() + a.min() + a.max();
+  };
+
+  auto const where = select<Float64>(records, price, compare_op::lt, 100);
+  BENCHMARK("sum size where price < 100 (aggregate)")
+  {
+    return aggregate<Int64>(records, size, where).sum();
+  };
+
+  free(rows);
+}
+
+TEST_CASE( "group by scaling", "[!benchmark]" )
+{
+  using namespace types;
+
+  // The 1 GB all fields data of the read/write benchmark, grouped by a 10 symbol key and by a distinct key.
+  auto const desc = make_all_fields_descriptor();
+  constexpr size_t k_bytes = 1024 * 1024 * 1024;
+  auto const count = k_bytes / desc.mem_size();
+  mem_t* const rows = (mem_t*)std::aligned_alloc(desc.mem_align(), desc.mem_size() * count);
+  generate_records(rows, desc, count);
+  record_span<record> const records{rows, desc.mem_size(), count};
+
+  rdf::fields_builder builder;
+  builder.push({ "Symbol", "", Key16, 254 })
+         .push({ "Id",     "", Key8, 31 })
+         .push({ "Volume", "", Uint64 })
+         .push({ "Trades", "", Uint64 })
+         .push({ "Mean",   "", Float64 });
+  descriptor rollup{"Rollup", builder};
+  auto const aggregates = std::vector<group_aggregate>{
+    group_aggregate::sum(desc.fields("Uint32 Field"), rollup.fields("Volume")),
+    group_aggregate::count(rollup.fields("Trades")),
+    group_aggregate::mean(desc.fields("Float64 Field"), rollup.fields("Mean"))
+  };
+  group_by per_symbol{desc.fields("Key16 Field"), rollup, rollup.fields("Symbol"), aggregates};
+  group_by per_id{desc.fields("Key8 Field"), rollup, rollup.fields("Id"), aggregates};
+
+  // One run per thread count, up to the number of cores.
+  for (int threads = 1; threads <= (int)std::thread::hardware_concurrency(); threads *= 2)
+  {
+    tbb::task_arena arena{threads};
+    BENCHMARK(fmt::format("volume per symbol ({} threads)", threads))
+    {
+      return arena.execute([&] { return per_symbol(records).size(); });
+    };
+    BENCHMARK(fmt::format("volume per distinct key ({} threads)", threads))
+    {
+      return arena.execute([&] { return per_id(records).size(); });
+    };
+  }
+
+  free(rows);
+}
+
+TEST_CASE( "dictionary keys", "[!benchmark]" )
+{
+  using namespace types;
+
+  // The same trades with the symbol as a Key16 string and as a KeyDict code.
+  rdf::fields_builder string_builder;
+  string_builder.push({ "Symbol", "", Key16, 254 })
+                .push({ "Size",   "", Uint32 })
+                .push({ "Price",  "", Float64 });
+  descriptor const strings{"String Keys", string_builder};
+
+  rdf::fields_builder code_builder;
+  code_builder.push({ "Symbol", "", KeyDict })
+              .push({ "Size",   "", Uint32 })
+              .push({ "Price",  "", Float64 });
+  descriptor const codes{"Dictionary Keys", code_builder};
+
+  constexpr size_t k_count = 4'000'000;
+  record_buffer string_rows{strings, k_count};
+  record_buffer code_rows{codes, k_count};
+  key_dictionary dict;
+  for (size_t i = 0; i < k_count; ++i) {
+    auto const symbol = fmt::format("AAPL_{}:*", i % 10);
+    strings.fields("Symbol").write<Key16>(string_rows[i], symbol);
+    strings.fields("Size").write<Uint32>(string_rows[i], (uint32_t)i);
+    strings.fields("Price").write<Float64>(string_rows[i], i * 100.f64);
+    dict.write(codes.fields("Symbol"), code_rows[i], symbol);
+    codes.fields("Size").write<Uint32>(code_rows[i], (uint32_t)i);
+    codes.fields("Price").write<Float64>(code_rows[i], i * 100.f64);
+  }
+  SPDLOG_INFO("{} records of {}B with string keys, {}B with dictionary keys", k_count, strings.mem_size(), codes.mem_size());
+
+  auto const string_records = string_rows.records();
+  auto const code_records = code_rows.records();
+
+  BENCHMARK("count symbol (string compare)")
+  {
+    return tbb::parallel_reduce(string_records.with_grain(4096), size_t{0},
+      [&](record_span<record> const& range, size_t n) {
+        for (auto r : range) {
+          n += r.get<Key16>(strings.fields("Symbol")) == "AAPL_7:*";
+        }
+        return n;
+      }, std::plus<>{});
+  };
+  BENCHMARK("count symbol (code select)")
+  {
+    return select<KeyDict>(code_records, codes.fields("Symbol"), compare_op::eq, dict.find("AAPL_7:*")).count();
+  };
+
+  rdf::fields_builder string_rollup_builder;
+  string_rollup_builder.push({ "Symbol", "", Key16, 254 })
+                       .push({ "Volume", "", Uint64 });
+  descriptor const string_rollup{"String Rollup", string_rollup_builder};
+  rdf::fields_builder code_rollup_builder;
+  code_rollup_builder.push({ "Symbol", "", KeyDict })
+                     .push({ "Volume", "", Uint64 });
+  descriptor const code_rollup{"Code Rollup", code_rollup_builder};
+
+  group_by per_string{strings.fields("Symbol"), string_rollup, string_rollup.fields("Symbol"),
+                      { group_aggregate::sum(strings.fields("Size"), string_rollup.fields("Volume")) }};
+  group_by per_code{codes.fields("Symbol"), code_rollup, code_rollup.fields("Symbol"),
+                    { group_aggregate::sum(codes.fields("Size"), code_rollup.fields("Volume")) }};
+
+  BENCHMARK("volume per symbol (string key)")
+  {
+    return per_string(string_records).size();
+  };
+  BENCHMARK("volume per symbol (dictionary key)")
+  {
+    return per_code(code_records).size();
+  };
+}
+
+TEST_CASE( "out of line strings", "[!benchmark]" )
+{
+  using namespace types;
+
+  // The same trades with a fixed 254 byte String16 venue and a StringRef venue, mostly short names.
+  rdf::fields_builder fixed_builder;
+  fixed_builder.push({ "Venue", "", String16, 254 })
+               .push({ "Size",  "", Uint32 });
+  descriptor const fixed{"Fixed Strings", fixed_builder};
+
+  rdf::fields_builder ref_builder;
+  ref_builder.push({ "Venue", "", StringRef })
+             .push({ "Size",  "", Uint32 });
+  descriptor const refs{"String Refs", ref_builder};
+
+  constexpr size_t k_count = 4'000'000;
+  record_buffer fixed_rows{fixed, k_count};
+  record_buffer ref_rows{refs, k_count};
+  string_arena arena;
+  for (size_t i = 0; i < k_count; ++i) {
+    auto const venue = i % 16 == 0 ? fmt::format("Alternative Trading System {}", i % 7) : fmt::format("XNAS_{}", i % 7);
+    fixed.fields("Venue").write<String16>(fixed_rows[i], venue);
+    fixed.fields("Size").write<Uint32>(fixed_rows[i], (uint32_t)i);
+    arena.write(refs.fields("Venue"), ref_rows[i], venue);
+    refs.fields("Size").write<Uint32>(ref_rows[i], (uint32_t)i);
+  }
+  SPDLOG_INFO("{} records of {}B with fixed strings, {}B with string refs and a {}B arena",
+              k_count, fixed.mem_size(), refs.mem_size(), arena.size_bytes());
+
+  auto const fixed_records = fixed_rows.records();
+  auto const ref_records = ref_rows.records();
+
+  BENCHMARK("sum size (fixed strings)")
+  {
+    return aggregate<Uint32>(fixed_records, fixed.fields("Size")).sum();
+  };
+  BENCHMARK("sum size (string refs)")
+  {
+    return aggregate<Uint32>(ref_records, refs.fields("Size")).sum();
+  };
+
+  auto const count = [](record_span<record> const& records, auto&& match) {
+    return tbb::parallel_reduce(records.with_grain(4096), size_t{0},
+      [&](record_span<record> const& range, size_t n) {
+        for (auto r : range) {
+          n += match(r.cmem());
+        }
+        return n;
+      }, std::plus<>{});
+  };
+  BENCHMARK("count venue (fixed strings)")
+  {
+    return count(fixed_records, [&](mem_t const* mem) { return fixed.fields("Venue").read<String16>(mem) == "Alternative Trading System 3"; });
+  };
+  BENCHMARK("count venue (string refs)")
+  {
+    return count(ref_records, [&](mem_t const* mem) { return arena.equal(refs.fields("Venue"), mem, "Alternative Trading System 3"); });
+  };
+}
+
+TEST_CASE( "block encoding", "[!benchmark]" )
+{
+  using namespace types;
+
+  // The all fields data of the read/write benchmark: regular timestamps, counters and repetitive strings.
+  auto const desc = make_all_fields_descriptor();
+  constexpr size_t k_count = 500'000;
+  record_buffer rows{desc, k_count};
+  generate_records(rows.data(), desc, k_count);
+  auto const records = rows.records();
+
+  char const* file_name = "./block-encoding-bench.bin";
+  encoded_table::write(file_name, desc, records);
+  auto const table = encoded_table::open(file_name);
+  SPDLOG_INFO("{} records: {}B raw, {}B encoded in {} blocks", k_count, rows.size_bytes(), table.size_bytes(), table.block_count());
+
+  BENCHMARK("encode")
+  {
+    encoded_table::write(file_name, desc, records);
+    return std::filesystem::file_size(file_name);
+  };
+  BENCHMARK("decode")
+  {
+    return table.decode().size();
+  };
+  BENCHMARK("scan decoded blocks")
+  {
+    std::atomic<uint64_t> sum = 0;
+    table.scan([&](size_t, record_span<record> block) {
+      sum += tbb::this_task_arena::isolate([&] { return aggregate<Uint32>(block, desc.fields("Uint32 Field")).sum(); });
+    });
+    return sum.load();
+  };
+
+  std::filesystem::remove(file_name);
+}
+
+TEST_CASE( "timestamp parsing", "[!benchmark]" )
+{
+  // A day of ticks at irregular nanosecond times.
+  constexpr size_t k_count = 100'000;
+  util::time_fmt const tf{k_str_to_time_fmt};
+  std::mt19937_64 rng{42};
+  std::vector<timestamp_t> times(k_count);
+  std::vector<std::string> strs(k_count);
+  auto ts = util::make_timestamp(1505433600000000000);
+  for (size_t i = 0; i < k_count; ++i) {
+    ts += std::chrono::nanoseconds{rng() % 1'000'000'000};
+    times[i] = ts;
+    strs[i] = tf.to_str(ts);
+  }
+
+  BENCHMARK("str_to_time")
+  {
+    int64_t sum = 0;
+    for (auto const& s : strs) {
+      sum += util::str_to_time(s).time_since_epoch().count();
+    }
+    return sum;
+  };
+  BENCHMARK("time_fmt::to_time")
+  {
+    int64_t sum = 0;
+    for (auto const& s : strs) {
+      sum += tf.to_time(s).time_since_epoch().count();
+    }
+    return sum;
+  };
+  BENCHMARK("time_to_str")
+  {
+    size_t size = 0;
+    for (auto t : times) {
+      size += util::time_to_str(t).size();
+    }
+    return size;
+  };
+  BENCHMARK("time_fmt::to_str")
+  {
+    size_t size = 0;
+    for (auto t : times) {
+      size += tf.to_str(t).size();
+    }
+    return size;
+  };
+  BENCHMARK("time_fmt::to_chars")
+  {
+    std::vector<char> out(k_count * tf.size());
+    auto it = out.data();
+    for (auto t : times) {
+      it = tf.to_chars(it, t);
+    }
+    return out.back();
+  };
+}
+
+TEST_CASE( "text export", "[!benchmark]" )
+{
+  using namespace types;
+
+  auto const desc = make_all_fields_descriptor();
+  constexpr size_t k_count = 500'000;
+  record_buffer rows{desc, k_count};
+  generate_records(rows.data(), desc, k_count);
+  auto const records = rows.records();
+
+  record_formatter const csv{desc};
+  std::string text;
+  csv.format(records, text);
+  SPDLOG_INFO("{} records: {}B raw, {}B of text", k_count, rows.size_bytes(), text.size());
+
+  BENCHMARK("record::to_string")
+  {
+    size_t size = 0;
+    for (auto r : records) {
+      size += r.to_string(desc).size();
+    }
+    return size;
+  };
+  BENCHMARK("record_formatter::format")
+  {
+    text.clear();
+    csv.format(records, text);
+    return text.size();
+  };
+
+  char const* file_name = "./text-export-bench.csv";
+  BENCHMARK("export_text")
+  {
+    return export_text(file_name, desc, records);
+  };
+  std::filesystem::remove(file_name);
+}
+
+TEST_CASE( "text import", "[!benchmark]" )
+{
+  auto const desc = make_all_fields_descriptor();
+  constexpr size_t k_count = 500'000;
+  record_buffer rows{desc, k_count};
+  generate_records(rows.data(), desc, k_count);
+
+  char const* file_name = "./text-import-bench.csv";
+  auto const bytes = export_text(file_name, desc, rows.records());
+  SPDLOG_INFO("{} records: {}B of text", k_count, bytes);
+
+  BENCHMARK("import_text")
+  {
+    auto const result = import_text(file_name, desc);
+    return result.records.size() + result.errors.size();
+  };
+  BENCHMARK("import_text (one chunk)")
+  {
+    auto const result = import_text(file_name, desc, { .chunk_bytes = bytes });
+    return result.records.size() + result.errors.size();
+  };
+  std::filesystem::remove(file_name);
+}
+
+TEST_CASE( "arrow export throughput", "[!benchmark]" )
+{
+  auto const desc = make_all_fields_descriptor();
+  constexpr size_t k_count = 500'000;
+  record_buffer rows{desc, k_count};
+  generate_records(rows.data(), desc, k_count);
+  auto const records = rows.records();
+
+  column_table table{desc, k_count};
+  table.from_rows(records.data(), k_count);
+
+  // Fixed width columns are views of the table, only strings, bools and Float128 are converted.
+  BENCHMARK("export_arrow (column_table)")
+  {
+    ArrowArray array;
+    export_arrow(table, &array);
+    auto const length = array.length;
+    array.release(&array);
+    return length;
+  };
+  BENCHMARK("export_arrow (records)")
+  {
+    ArrowArray array;
+    export_arrow(desc, records, &array);
+    auto const length = array.length;
+    array.release(&array);
+    return length;
+  };
+}
+
+TEST_CASE( "partial record scan", "[!benchmark]" )
+{
+  // A scan reading a few fields of each record, e.g. a filter on a key and a flag, summing a price. In the packed
+  // layout the 1 byte aligned key and flag follow the large string payloads, in the hot_cold layout they share the
+  // first cache line with the timestamp and price.
+  auto const builder = [] {
+    auto const all = make_all_fields_descriptor();
+    rdf::fields_builder b;
+    for (auto const& f : all.fields()) {
+      b.push(f);
+    }
+    return b;
+  }();
+  descriptor const packed {"Packed", builder};
+  descriptor const hot_cold {"Hot Cold", builder, descriptor::field_weights{
+    {"Timestamp Field", 4}, {"Float64 Field", 4}, {"Key8 Field", 2}, {"Bool Field", 2}, {"Char Field", 1} }};
+  SPDLOG_INFO(hot_cold.describe(true));
+
+  constexpr size_t k_count = 200'000;
+  auto const scan = [](descriptor const& desc, record_span<record> records) {
+    auto const& ts = desc.fields("Timestamp Field");
+    auto const& price = desc.fields("Float64 Field");
+    auto const& key = desc.fields("Key8 Field");
+    auto const& flag = desc.fields("Bool Field");
+    auto const& side = desc.fields("Char Field");
+    double sum = 0;
+    for (auto r : records) {
+      auto const mem = r.cmem();
+      if (flag.read<Bool>(mem) || key.read<Key8>(mem).size() > 8 || side.read<Char>(mem) == 'B') {
+        sum += price.read<Float64>(mem) + (double)ts.read<Timestamp>(mem).time_since_epoch().count();
+      }
+    }
+    return sum;
+  };
+
+  for (auto const* desc : { &packed, &hot_cold }) {
+    record_buffer rows{*desc, k_count};
+    generate_records(rows.data(), *desc, k_count);
+    auto const records = rows.records();
+    SPDLOG_INFO("{}: {}B records", desc->name(), desc->mem_size());
+    BENCHMARK(fmt::format("partial scan ({})", desc->name()))
+    {
+      return scan(*desc, records);
+    };
+  }
+}
+
 } // namespace rdf
\ No newline at end of file